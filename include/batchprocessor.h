@@ -0,0 +1,65 @@
+#ifndef BATCHPROCESSOR_H
+#define BATCHPROCESSOR_H
+
+#include "processingpipeline.h"
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <functional>
+
+/**
+ * @brief Settings for one batch run over a directory.
+ */
+struct BatchOptions {
+    QString inputDir;
+    QString outputDir;
+    QStringList nameFilters{"*.png", "*.jpg", "*.jpeg", "*.bmp", "*.tif", "*.tiff", "*.pgm", "*.ppm", "*.rle"};
+    QString outputFormat;  ///< Output extension without the dot (e.g. "png"); empty keeps the input extension.
+    bool recursive = false;
+    int threadCount = 0;   ///< Worker threads; 0 uses QThread::idealThreadCount().
+};
+
+/**
+ * @brief Summary of a finished batch run.
+ */
+struct BatchResult {
+    int succeeded = 0;
+    int failed = 0;
+    qint64 elapsedMs = 0;
+};
+
+/**
+ * @brief Runs a ProcessingPipeline over every matching file of a directory on a worker pool.
+ *
+ * Files are discovered lazily and at most a few images per worker are in flight at any time,
+ * so memory stays bounded no matter how large the directory is. No widgets are used.
+ */
+class BatchProcessor {
+public:
+    /// Called from worker threads after each file; @p error is empty on success.
+    using FileCallback = std::function<void(const QString& inputPath, const QString& outputPath, const QString& error)>;
+
+    BatchProcessor(const ProcessingPipeline& pipeline, const BatchOptions& options);
+
+    /**
+     * @brief Processes the directory and blocks until every queued file is done.
+     * @param onFileDone Optional per-file report (invoked from worker threads, must be thread-safe).
+     * @return Counts of succeeded and failed files.
+     */
+    BatchResult run(const FileCallback& onFileDone = FileCallback());
+
+    /**
+     * @brief Stops queuing new files; files already in flight still finish. Thread-safe.
+     */
+    void cancel() { cancelled = true; }
+
+private:
+    QString processFile(const QString& inputPath, const QString& outputPath) const;
+    QString outputPathFor(const QString& inputPath) const;
+
+    ProcessingPipeline pipeline;
+    BatchOptions options;
+    std::atomic<bool> cancelled{false};
+};
+
+#endif // BATCHPROCESSOR_H
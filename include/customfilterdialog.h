@@ -2,9 +2,11 @@
 #define CUSTOMFILTERDIALOG_H
 
 #include "previewdialogbase.h"
+#include "imageprocessing.h"
 #include <QDialog>
 #include <QComboBox>
 #include <QGridLayout>
+#include <QLabel>
 #include <QSpinBox>
 #include <QVector>
 #include <opencv2/opencv.hpp>
@@ -17,6 +19,7 @@ public:
     explicit CustomFilterDialog(QWidget *parent = nullptr);
     cv::Mat getKernel();
     QCheckBox* getPreviewCheckBox() const { return previewCheckBox; }
+    void setConvolutionInfo(const ImageProcessing::ConvolutionInfo& info); // Shows how the last preview was filtered
 
 private slots:
     void updateKernelSize();
@@ -28,6 +31,7 @@ signals:
 private:
     QComboBox *kernelSizeBox;
     QCheckBox* previewCheckBox;
+    QLabel* methodLabel;
     QGridLayout *kernelLayout;
     QVector<QVector<QDoubleSpinBox*>> kernelInputs;
 };
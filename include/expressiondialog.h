@@ -0,0 +1,44 @@
+#ifndef EXPRESSIONDIALOG_H
+#define EXPRESSIONDIALOG_H
+
+#include <QDialog>
+#include <QVector>
+
+class QDialogButtonBox;
+class QLabel;
+class QLineEdit;
+class QTableWidget;
+class ImageViewer;
+
+/**
+ * @brief Asks for an image expression (see ImageProcessing::ImageExpression) and the open image
+ * each of its variables stands for. Every open image gets a variable name (A, B, C... by default,
+ * editable); OK is only enabled while the expression parses and all its variables are named.
+ */
+class ExpressionDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    explicit ExpressionDialog(const QVector<QWidget*>& openedImages, QWidget *parent = nullptr);
+
+    QString getExpression() const;
+
+    /**
+     * @brief The viewer bound to each variable of the expression, in the order of
+     * ImageExpression::variables(); empty if a variable is not bound.
+     */
+    QVector<ImageViewer*> getBoundViewers() const;
+
+private slots:
+    void validate();
+    void averageAll(); // Fills in mean() of every image, for stacking exposures
+
+private:
+    QLineEdit *expressionEdit;
+    QTableWidget *variableTable; // Variable name, image title
+    QLabel *statusLabel;
+    QDialogButtonBox *buttonBox;
+    QVector<ImageViewer*> viewers; // One per table row
+};
+
+#endif // EXPRESSIONDIALOG_H
@@ -4,6 +4,7 @@
 #include <QWidget>
 #include <QVector>
 #include <opencv2/opencv.hpp>
+#include "imageprocessing.h" // For ImageProcessing::Histogram
 
 // Forward declarations
 class QPaintEvent;
@@ -17,6 +18,7 @@ class HistogramWidget : public QWidget {
 public:
     explicit HistogramWidget(QWidget *parent = nullptr);
     void computeHistogram(const cv::Mat &grayImage);
+    void setHistogram(const ImageProcessing::Histogram &histogram); // Shows counts computed elsewhere
 
 protected:
     void paintEvent(QPaintEvent *event) override;
@@ -0,0 +1,80 @@
+#ifndef IMAGECANVAS_H
+#define IMAGECANVAS_H
+
+#include <QCache>
+#include <QImage>
+#include <QPixmap>
+#include <QWidget>
+#include <opencv2/core.hpp>
+#include "imagepyramid.h"
+#include "tiledimage.h"
+
+/**
+ * @brief Draws a cv::Mat at a given scale, converting only the part that is actually exposed.
+ *
+ * Meant to sit in a QScrollArea: the widget takes the full scaled size, but paintEvent() only
+ * converts and resamples the tiles intersecting the exposed rectangle. Rendered tiles stay cached
+ * until the image or the scale changes, so scrolling back and repaints are plain blits and the
+ * cost of zooming and panning depends on the viewport size, not on the image size.
+ */
+class ImageCanvas : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit ImageCanvas(QWidget *parent = nullptr);
+
+    /**
+     * @brief Shows `image` (shared, not copied; it must not be modified afterwards) at `scale`.
+     * @return false if the image type cannot be displayed (only 8-bit 1, 3 and 4 channel images can).
+     */
+    bool setImage(const cv::Mat &image, double scale);
+
+    /**
+     * @brief Shows level 0 of `pyramid` at any `scale`, each tile blended from the two nearest levels.
+     * @return false if the image type cannot be displayed.
+     */
+    bool setPyramid(const ImagePyramid &pyramid, double scale);
+    void clear();
+
+    /**
+     * @brief Blends a CV_8UC1 mask of the image's size over it at half intensity, as a separate layer.
+     * The mask is shared, not copied: after drawing into it, call invalidateImageRect() for the changed area.
+     * An empty Mat removes the overlay.
+     */
+    void setOverlay(const cv::Mat &mask);
+
+    /**
+     * @brief Re-renders only the tiles touching `imageRect` (in image coordinates) on the next paint.
+     */
+    void invalidateImageRect(const cv::Rect &imageRect);
+
+    const cv::Mat &image() const { return tiles.image(); }
+    double scale() const { return displayScale; }
+
+    /**
+     * @brief Converts an 8-bit 1, 3 or 4 channel Mat to a QImage (null for other types).
+     * 4-channel images are wrapped without a copy, so the Mat must outlive the QImage.
+     */
+    static QImage toQImage(const cv::Mat &mat);
+
+signals:
+    void mouseClicked(QMouseEvent *event);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override {
+        emit mouseClicked(event);
+    }
+
+private:
+    QRect targetRect(const cv::Rect &imageRect) const; // Widget pixels covered by an image rectangle
+    QPixmap renderTile(int index) const;
+
+    TiledImage tiles;
+    ImagePyramid pyramid; // Set in pyramid mode; tiles then only lay out the display
+    cv::Mat overlay;      // Mask layer, drawn only where its size matches the image
+    double displayScale = 1.0;
+    QCache<int, QPixmap> tileCache; // Rendered tiles by index, cost in KiB
+};
+
+#endif // IMAGECANVAS_H
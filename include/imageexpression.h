@@ -0,0 +1,65 @@
+#ifndef IMAGEEXPRESSION_H
+#define IMAGEEXPRESSION_H
+
+#include "imageprocessing.h"
+#include <string>
+#include <vector>
+
+namespace ImageProcessing {
+
+/**
+ * @brief A pixel-wise expression over any number of images, e.g. `0.3*A + 0.5*B - C & mask`.
+ *
+ * Grammar, loosest binding first (as in C): `|`, `^`, `&`, `+ -`, `* /`, unary `- ~`.
+ * Operands are numbers, variables (identifiers bound to images by evaluate()), parentheses and
+ * the functions `min(...)`, `max(...)`, `sum(...)`, `mean(...)` (any number of arguments) and `abs(x)`.
+ * Arithmetic is done in float; bitwise operators work on values rounded and clamped to the image's
+ * range (8 and 16-bit unsigned images only). Division by zero gives 0.
+ *
+ * The expression is compiled once into a small stack program. evaluate() runs it over bands of rows
+ * in parallel: each band of every input is converted to float once, the program runs over
+ * band-sized buffers (plain loops that vectorize), and the result is saturated straight into the
+ * output. No full-size intermediate image is ever allocated, and n-ary functions are folded pairwise,
+ * so averaging dozens of images needs only two band buffers.
+ */
+class ImageExpression {
+public:
+    /**
+     * @brief Parses and compiles `text`, or returns an Error naming the position of the problem.
+     */
+    static Result<ImageExpression> parse(const std::string& text);
+
+    const std::string& text() const { return source; }
+
+    /**
+     * @brief The variables the expression refers to, in order of first use.
+     */
+    const std::vector<std::string>& variables() const { return variableNames; }
+
+    /**
+     * @brief Evaluates the expression; images[i] is bound to variables()[i].
+     * All images must be non-empty and have the same size and type, which the result also has.
+     * @param progress Optional progress reporting and cancellation (checked between bands).
+     */
+    MatResult evaluate(const std::vector<cv::Mat>& images, OperationProgress* progress = nullptr) const;
+
+private:
+    friend class ExpressionParser;
+
+    enum class Op { Load, Constant, Negate, Not, Abs, Add, Subtract, Multiply, Divide, Min, Max, And, Or, Xor };
+    struct Instruction {
+        Op op;
+        int variable = 0;   // Load: index into variables()
+        float value = 0.0f; // Constant
+    };
+
+    std::string source;
+    std::vector<std::string> variableNames;
+    std::vector<Instruction> program; // Postfix: operands are pushed, operators pop theirs and push the result
+    int stackDepth = 0;               // Buffers needed to run the program
+    bool usesBitwise = false;
+};
+
+} // namespace ImageProcessing
+
+#endif // IMAGEEXPRESSION_H
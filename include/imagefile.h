@@ -0,0 +1,44 @@
+#ifndef IMAGEFILE_H
+#define IMAGEFILE_H
+
+#include <QString>
+#include <opencv2/core.hpp>
+
+/**
+ * @brief Loads images through a read-only file mapping instead of reading the file into memory first.
+ *
+ * Bottom-up BMP and binary 8-bit PPM are converted from the mapping in a single pass, and RLE and
+ * compressed formats are decoded straight from it, so peak memory during a load is about the size of
+ * the decoded image. Uncompressed layouts that match a cv::Mat (binary 8-bit PGM, top-down 24-bit BMP)
+ * are copied out of the mapping by load(), or returned by loadView() as a view of the mapping itself.
+ *
+ * Files that cannot be mapped are read into memory and decoded as before.
+ */
+namespace ImageFile {
+
+/**
+ * @brief Loads any image OpenCV can decode, or an `.rle` image.
+ * @return The image, or an empty Mat with a description in `errorMessage`.
+ */
+cv::Mat load(const QString& filePath, QString* errorMessage = nullptr);
+
+/**
+ * @brief Like load(), but 8-bit PGM and top-down 24-bit BMP files come back as a view of the file mapping,
+ * with no copy at all. For short-lived images only (e.g. one file of a batch run): the view keeps the file
+ * mapped, and locked on Windows, until the last Mat sharing it goes away, and pages not written to still
+ * follow the file, so rewriting it changes the pixels and truncating it makes reading them fault.
+ * Pixel writes go to private copy-on-write pages, never to the file.
+ */
+cv::Mat loadView(const QString& filePath, QString* errorMessage = nullptr);
+
+/**
+ * @brief Decodes a small 8-bit BGR preview whose longer side is at most `maxSide`.
+ *
+ * Uses OpenCV's reduced-resolution decoding (IMREAD_REDUCED_COLOR_*), which JPEG performs
+ * natively at a fraction of the cost of a full decode.
+ */
+cv::Mat loadThumbnail(const QString& filePath, int maxSide, QString* errorMessage = nullptr);
+
+} // namespace ImageFile
+
+#endif // IMAGEFILE_H
@@ -0,0 +1,74 @@
+#ifndef IMAGELOADER_H
+#define IMAGELOADER_H
+
+#include <QCache>
+#include <QDateTime>
+#include <QImage>
+#include <QObject>
+#include <QSet>
+#include <QThreadPool>
+#include <opencv2/core.hpp>
+
+/**
+ * @brief Decodes image files on a bounded pool of worker threads and reports each result as it arrives.
+ *
+ * Requests are queued, so dropping hundreds of files costs the GUI thread nothing but the queueing:
+ * results are delivered one by one through queued signals, in completion order. Full decodes are
+ * dequeued before thumbnails, so an image the user asked for is not stuck behind a long batch.
+ * Destroying the loader drops the queued requests and waits for the running ones.
+ *
+ * Decoded images are kept in an LRU cache keyed by canonical path and checked against the file's
+ * modification time and size, so re-opening an unchanged file skips the decode entirely. A cached
+ * image is shared with every viewer showing it, not copied: viewers never modify images in place.
+ * Images are loaded with ImageFile::load(), so they own their pixels: a cached image never keeps its
+ * file mapped, or locked, after the viewers are closed, and never changes when the file does.
+ */
+class ImageLoader : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int ThumbnailSize = 96; // Longer side of thumbnails, in pixels
+
+    explicit ImageLoader(QObject *parent = nullptr);
+    ~ImageLoader() override;
+
+    /**
+     * @brief Queues a reduced-resolution decode; thumbnailReady() or thumbnailFailed() follows.
+     */
+    void requestThumbnail(const QString &filePath);
+
+    /**
+     * @brief Queues a full decode; imageReady() or imageFailed() follows.
+     * Ignored while the same file is already being decoded.
+     */
+    void requestImage(const QString &filePath);
+
+    /**
+     * @brief Drops every request that has not started yet.
+     */
+    void cancelPending();
+
+    /**
+     * @brief Caps the memory of cached decoded images (0 disables the cache), evicting the least recently used.
+     */
+    void setCacheLimit(size_t bytes);
+
+signals:
+    void thumbnailReady(const QString &filePath, const QImage &thumbnail);
+    void thumbnailFailed(const QString &filePath, const QString &error);
+    void imageReady(const QString &filePath, const cv::Mat &image);
+    void imageFailed(const QString &filePath, const QString &error);
+
+private:
+    struct CachedImage {
+        cv::Mat image;
+        QDateTime modified; // File state when decoding started
+        qint64 fileSize = 0;
+    };
+
+    QThreadPool pool;
+    QCache<QString, CachedImage> cache; // By canonical path, cost in KiB
+    QSet<QString> loadingImages; // Full decodes queued or running, touched on the GUI thread only
+};
+
+#endif // IMAGELOADER_H
@@ -2,8 +2,18 @@
 #define IMAGE_ALGORITHMS_H
 
 #include <opencv2/opencv.hpp>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <variant>
 #include <vector>
-#include "imageviewer.h" // Include for StructuringElementType enum
+
+// Enum for morphology structuring element type
+enum StructuringElementType {
+    Diamond, // Typically 4-connected for 3x3
+    Square   // Typically 8-connected for 3x3
+};
 
 namespace ImageProcessing {
 
@@ -17,6 +27,95 @@ struct ShapeFeatures {
     double equivalentDiameter;
 };
 
+// ==========================================================================
+// Image Processing - Error Reporting
+// ==========================================================================
+
+/**
+     * @brief Describes why an operation rejected its input (e.g. "Median Filter Error", "Input image is empty.").
+     */
+struct Error {
+    std::string title;
+    std::string message;
+};
+
+/**
+     * @brief Holds either the value produced by an operation or the Error explaining why it failed.
+     *
+     * Operations never show UI themselves; callers decide how to surface the error
+     * (a message box in ImageViewer, a log line in apo-batch).
+     */
+template<typename T>
+class Result {
+public:
+    Result(T value) : storage(std::move(value)) {}
+    Result(Error error) : storage(std::move(error)) {}
+
+    bool ok() const { return std::holds_alternative<T>(storage); }
+    explicit operator bool() const { return ok(); }
+
+    const T& value() const & { return std::get<T>(storage); }
+    T value() && { return std::get<T>(std::move(storage)); }
+    const Error& error() const { return std::get<Error>(storage); }
+
+    /**
+     * @brief Returns the value, or fallback if the operation failed.
+     */
+    T valueOr(T fallback) const { return ok() ? std::get<T>(storage) : std::move(fallback); }
+
+private:
+    std::variant<T, Error> storage;
+};
+
+using MatResult = Result<cv::Mat>;
+
+// ==========================================================================
+// Image Processing - Progress & Cancellation
+// ==========================================================================
+
+/**
+     * @brief Progress and cancellation state shared between a running operation and its caller.
+     *
+     * Long-running operations take an optional pointer to it, report progress in percent
+     * and return an Error as soon as cancellation is requested. Safe to use across threads.
+     */
+class OperationProgress {
+public:
+    void report(int percent) { progress.store(percent, std::memory_order_relaxed); }
+    int percent() const { return progress.load(std::memory_order_relaxed); }
+
+    void requestCancel() { cancelRequested.store(true, std::memory_order_relaxed); }
+    bool isCancelled() const { return cancelRequested.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int> progress{0};
+    std::atomic<bool> cancelRequested{false};
+};
+
+// ==========================================================================
+// Image Processing - Tiled Execution
+// ==========================================================================
+
+// Filter for one tile: receives the tile padded by the halo, returns either the result for the
+// whole padded tile (the halo is cropped afterwards) or for the tile alone.
+using TileFilter = std::function<MatResult(const cv::Mat& paddedTile)>;
+
+/**
+     * @brief Runs a neighbourhood filter tile by tile, tiles in parallel.
+     * Each tile is extended by `halo` pixels taken from its neighbours, or extrapolated with `borderType`
+     * at the image edges, so the result matches running the filter on the whole image as long as
+     * its radius does not exceed `halo`. Temporaries stay tile-sized.
+     * @param inputImage The input image.
+     * @param halo Filter radius in pixels.
+     * @param borderType OpenCV border handling flag, e.g. MainWindow::getBorderOption().
+     * @param filter The per-tile filter; must be thread-safe.
+     * @param progress Optional progress reporting and cancellation (checked between tiles).
+     * @param tileSize Edge length of the tiles.
+     * @return The assembled image, or the first tile's error.
+     */
+MatResult applyTiled(const cv::Mat& inputImage, int halo, int borderType, const TileFilter& filter,
+                     OperationProgress* progress = nullptr, int tileSize = 512);
+
 // ==========================================================================
 // Group 5: Image Processing - Core Operations
 // ==========================================================================
@@ -28,28 +127,44 @@ struct ShapeFeatures {
      * @param maxValue The value to assign to pixels above the threshold.
      * @return The binary image.
      */
-cv::Mat binarise(const cv::Mat& inputImage, double thresholdValue = 127.0, double maxValue = 255.0);
+MatResult binarise(const cv::Mat& inputImage, double thresholdValue = 127.0, double maxValue = 255.0);
 
 /**
      * @brief Converts a color image to grayscale.
      * @param inputImage The input BGR or BGRA image.
      * @return The grayscale image, or the original if already grayscale/binary.
      */
-cv::Mat convertToGrayscale(const cv::Mat& inputImage);
+MatResult convertToGrayscale(const cv::Mat& inputImage);
+
+/**
+     * @brief What one pass over the pixels tells about an image's content.
+     */
+struct ImageContent {
+    bool alphaUnused = false;   // 4 channels and the alpha channel is all zero
+    bool channelsEqual = false; // 3 or 4 channels and B == G == R everywhere
+    bool binary = false;        // The first channel only holds 0 and 255
+};
+
+/**
+     * @brief Analyzes an image in a single parallel pass that stops as soon as the answers are known.
+     * @param inputImage The input image (1, 3 or 4 channels).
+     * @return The content flags; all false for an empty image.
+     */
+ImageContent analyzeContent(const cv::Mat& inputImage);
 
 /**
      * @brief Converts a color image with alpha to color image.
      * @param inputImage The input BGRA image.
      * @return The BGR, or the original if already BGR.
      */
-cv::Mat removeAlphaChannel(const cv::Mat& inputImage);
+MatResult removeAlphaChannel(const cv::Mat& inputImage);
 
 /**
      * @brief Converts a grayscale image to color.
      * @param inputImage The input grayscale image.
      * @return The BGR image, or the original if BGR.
      */
-cv::Mat convertToColor(const cv::Mat &input);
+MatResult convertToColor(const cv::Mat &input);
 
 /**
      * @brief Splits a color image into its B, G, R channels.
@@ -76,12 +191,56 @@ std::vector<cv::Mat> convertToLab(const cv::Mat& inputImage);
 // Group 6: Image Processing - Point Operations
 // ==========================================================================
 
+// Lookup table of an 8-bit point operation: the output value for each input value
+using PointTable = std::array<uchar, 256>;
+// Counts of the 256 values of an 8-bit channel (see computeGrayHistogram())
+using Histogram = std::array<int, 256>;
+using TableResult = Result<PointTable>;
+
+// Tables of the individual point operations. Chaining them with composeTables() folds any number
+// of steps into one table, which applyPointTable() then applies in a single pass over the image.
+PointTable identityTable();
+PointTable negationTable();
+TableResult rangeStretchingTable(int p1, int p2, int q3, int q4);
+TableResult posterizationTable(int levels);
+PointTable thresholdTable(double thresholdValue, double maxValue = 255.0); // Same rule as cv::THRESH_BINARY
+TableResult gammaTable(double gamma);
+
+/**
+     * @brief Table equalizing an image with the given histogram (same mapping as equalizeHistogram()).
+     */
+PointTable equalizationTable(const Histogram& histogram);
+
+/**
+     * @brief Table stretching the values present in the histogram to 0-255 (same mapping as stretchHistogram()).
+     */
+PointTable histogramStretchTable(const Histogram& histogram);
+
+/**
+     * @brief Table applying `first`, then `second`.
+     */
+PointTable composeTables(const PointTable& first, const PointTable& second);
+
+/**
+     * @brief Histogram of an image after `table` is applied to it, computed from its histogram alone.
+     * Lets image-dependent steps (equalization) be folded into a chain without touching the pixels.
+     */
+Histogram mapHistogram(const Histogram& histogram, const PointTable& table);
+
+/**
+     * @brief Applies a lookup table to every channel of an 8-bit image, in parallel over rows.
+     * @param inputImage The input 8-bit image.
+     * @param table The lookup table.
+     * @return The mapped image.
+     */
+MatResult applyPointTable(const cv::Mat& inputImage, const PointTable& table);
+
 /**
      * @brief Applies image negation (inversion).
      * @param inputImage The input image (grayscale or color).
      * @return The negated image.
      */
-cv::Mat applyNegation(const cv::Mat& inputImage);
+MatResult applyNegation(const cv::Mat& inputImage);
 
 /**
      * @brief Applies contrast stretching based on input/output ranges.
@@ -92,7 +251,7 @@ cv::Mat applyNegation(const cv::Mat& inputImage);
      * @param q4 Upper bound of output range.
      * @return The contrast-stretched image.
      */
-cv::Mat applyRangeStretching(const cv::Mat& inputImage, int p1, int p2, int q3, int q4);
+MatResult applyRangeStretching(const cv::Mat& inputImage, int p1, int p2, int q3, int q4);
 
 /**
      * @brief Applies posterization to reduce the number of intensity levels.
@@ -100,7 +259,15 @@ cv::Mat applyRangeStretching(const cv::Mat& inputImage, int p1, int p2, int q3,
      * @param levels The desired number of intensity levels (2-256).
      * @return The posterized image.
      */
-cv::Mat applyPosterization(const cv::Mat& inputImage, int levels);
+MatResult applyPosterization(const cv::Mat& inputImage, int levels);
+
+/**
+     * @brief Applies gamma correction: out = 255 * (in / 255) ^ gamma.
+     * @param inputImage The input 8-bit image (grayscale or color; an alpha channel is left unchanged).
+     * @param gamma The exponent; below 1 brightens, above 1 darkens.
+     * @return The corrected image.
+     */
+MatResult applyGammaCorrection(const cv::Mat& inputImage, double gamma);
 
 /**
      * @brief Performs bitwise AND operation between two images.
@@ -108,7 +275,7 @@ cv::Mat applyPosterization(const cv::Mat& inputImage, int levels);
      * @param img2 Second input image (must be same size and type as img1).
      * @return Result of img1 & img2.
      */
-cv::Mat applyBitwiseAnd(const cv::Mat& img1, const cv::Mat& img2);
+MatResult applyBitwiseAnd(const cv::Mat& img1, const cv::Mat& img2);
 
 /**
      * @brief Performs bitwise OR operation between two images.
@@ -116,7 +283,7 @@ cv::Mat applyBitwiseAnd(const cv::Mat& img1, const cv::Mat& img2);
      * @param img2 Second input image (must be same size and type as img1).
      * @return Result of img1 | img2.
      */
-cv::Mat applyBitwiseOr(const cv::Mat& img1, const cv::Mat& img2);
+MatResult applyBitwiseOr(const cv::Mat& img1, const cv::Mat& img2);
 
 /**
      * @brief Performs bitwise XOR operation between two images.
@@ -124,7 +291,7 @@ cv::Mat applyBitwiseOr(const cv::Mat& img1, const cv::Mat& img2);
      * @param img2 Second input image (must be same size and type as img1).
      * @return Result of img1 ^ img2.
      */
-cv::Mat applyBitwiseXor(const cv::Mat& img1, const cv::Mat& img2);
+MatResult applyBitwiseXor(const cv::Mat& img1, const cv::Mat& img2);
 
 /**
      * @brief Adds two images.
@@ -132,7 +299,7 @@ cv::Mat applyBitwiseXor(const cv::Mat& img1, const cv::Mat& img2);
      * @param img2 Second input image (must be same size and type as img1).
      * @return Result of saturated addition img1 + img2.
      */
-cv::Mat applyAddition(const cv::Mat& img1, const cv::Mat& img2);
+MatResult applyAddition(const cv::Mat& img1, const cv::Mat& img2);
 
 /**
      * @brief Subtracts the second image from the first.
@@ -140,7 +307,7 @@ cv::Mat applyAddition(const cv::Mat& img1, const cv::Mat& img2);
      * @param img2 Second input image (must be same size and type as img1).
      * @return Result of saturated subtraction img1 - img2.
      */
-cv::Mat applySubtraction(const cv::Mat& img1, const cv::Mat& img2);
+MatResult applySubtraction(const cv::Mat& img1, const cv::Mat& img2);
 
 /**
      * @brief Blends two images using a weighted sum.
@@ -150,26 +317,41 @@ cv::Mat applySubtraction(const cv::Mat& img1, const cv::Mat& img2);
      * @param gamma Value added to the sum (usually 0).
      * @return Result of alpha*img1 + (1-alpha)*img2 + gamma.
      */
-cv::Mat applyBlending(const cv::Mat& img1, const cv::Mat& img2, double alpha, double gamma = 0.0);
+MatResult applyBlending(const cv::Mat& img1, const cv::Mat& img2, double alpha, double gamma = 0.0);
 
 
 // ==========================================================================
 // Group 7: Image Processing - Histogram Operations
 // ==========================================================================
 
+/**
+     * @brief Counts the values of each channel of an 8-bit image, in parallel over rows.
+     * @param inputImage The input 8-bit image (any number of channels).
+     * @return One histogram per channel, empty if the image is empty or not 8-bit.
+     */
+std::vector<Histogram> computeChannelHistograms(const cv::Mat& inputImage);
+
+/**
+     * @brief Histogram of the grayscale version of an 8-bit image.
+     * Color images are converted a few rows at a time, never as a whole grayscale copy.
+     * @param inputImage The input 8-bit grayscale, BGR or BGRA image.
+     * @return The histogram; all zeros if the image is empty or of another type.
+     */
+Histogram computeGrayHistogram(const cv::Mat& inputImage);
+
 /**
      * @brief Stretches the histogram to the full 0-255 range.
      * @param inputImage The input grayscale image.
      * @return The histogram-stretched image.
      */
-cv::Mat stretchHistogram(const cv::Mat& inputImage);
+MatResult stretchHistogram(const cv::Mat& inputImage);
 
 /**
      * @brief Applies histogram equalization manually using CDF.
      * @param inputImage The input grayscale image.
      * @return The histogram-equalized image.
      */
-cv::Mat equalizeHistogram(const cv::Mat& inputImage);
+MatResult equalizeHistogram(const cv::Mat& inputImage);
 
 // ==========================================================================
 // Group 8: Image Processing - Filtering & Edge Detection
@@ -182,7 +364,7 @@ cv::Mat equalizeHistogram(const cv::Mat& inputImage);
      * @param borderOption OpenCV border handling flag (e.g., cv::BORDER_DEFAULT).
      * @return The blurred image.
      */
-cv::Mat applyBoxBlur(const cv::Mat& inputImage, int kernelSize, int borderOption);
+MatResult applyBoxBlur(const cv::Mat& inputImage, int kernelSize, int borderOption);
 
 /**
      * @brief Applies a Gaussian blur filter.
@@ -193,7 +375,7 @@ cv::Mat applyBoxBlur(const cv::Mat& inputImage, int kernelSize, int borderOption
      * @param borderOption OpenCV border handling flag.
      * @return The Gaussian-blurred image.
      */
-cv::Mat applyGaussianBlur(const cv::Mat& inputImage, int kernelSize, double sigmaX, double sigmaY, int borderOption);
+MatResult applyGaussianBlur(const cv::Mat& inputImage, int kernelSize, double sigmaX, double sigmaY, int borderOption);
 
 /**
      * @brief Applies Sobel edge detection (combining X and Y gradients).
@@ -204,7 +386,7 @@ cv::Mat applyGaussianBlur(const cv::Mat& inputImage, int kernelSize, double sigm
      * @param borderOption OpenCV border handling flag.
      * @return The edge magnitude image (CV_8U).
      */
-cv::Mat applySobelEdgeDetection(const cv::Mat& inputImage, int kernelSize, double scale, double delta, int borderOption);
+MatResult applySobelEdgeDetection(const cv::Mat& inputImage, int kernelSize, double scale, double delta, int borderOption);
 
 /**
      * @brief Applies Laplacian edge detection.
@@ -215,7 +397,7 @@ cv::Mat applySobelEdgeDetection(const cv::Mat& inputImage, int kernelSize, doubl
      * @param borderOption OpenCV border handling flag.
      * @return The Laplacian edge image (CV_8U).
      */
-cv::Mat applyLaplacianEdgeDetection(const cv::Mat& inputImage, int kernelSize, double scale, double delta, int borderOption);
+MatResult applyLaplacianEdgeDetection(const cv::Mat& inputImage, int kernelSize, double scale, double delta, int borderOption);
 
 /**
      * @brief Applies Canny edge detection.
@@ -226,7 +408,7 @@ cv::Mat applyLaplacianEdgeDetection(const cv::Mat& inputImage, int kernelSize, d
      * @param L2gradient Flag indicating whether to use a more accurate L2 norm for gradient magnitude.
      * @return The binary edge map (CV_8U).
      */
-cv::Mat applyCannyEdgeDetection(const cv::Mat& inputImage, double threshold1, double threshold2, int apertureSize = 3, bool L2gradient = false);
+MatResult applyCannyEdgeDetection(const cv::Mat& inputImage, double threshold1, double threshold2, int apertureSize = 3, bool L2gradient = false);
 
 /**
      * @brief Applies a sharpening filter using a predefined kernel.
@@ -235,7 +417,7 @@ cv::Mat applyCannyEdgeDetection(const cv::Mat& inputImage, double threshold1, do
      * @param borderOption OpenCV border handling flag.
      * @return The sharpened image.
      */
-cv::Mat applySharpening(const cv::Mat& inputImage, int option, int borderOption);
+MatResult applySharpening(const cv::Mat& inputImage, int option, int borderOption);
 
 /**
      * @brief Applies a Prewitt edge detection filter for a specific direction.
@@ -244,7 +426,53 @@ cv::Mat applySharpening(const cv::Mat& inputImage, int option, int borderOption)
      * @param borderOption OpenCV border handling flag.
      * @return The edge detected image for the specified direction.
      */
-cv::Mat applyPrewittEdgeDetection(const cv::Mat& inputImage, int direction, int borderOption);
+MatResult applyPrewittEdgeDetection(const cv::Mat& inputImage, int direction, int borderOption);
+
+/**
+     * @brief How convolve() computes a filter.
+     */
+enum class ConvolutionMethod {
+    Direct,    ///< cv::filter2D with the dense kernel
+    Separable, ///< Rank-1 kernel as a row pass and a column pass (cv::sepFilter2D)
+    Frequency  ///< Product of DFT spectra, for large kernels
+};
+
+/**
+     * @brief The method convolve() picked and how long the filtering took.
+     */
+struct ConvolutionInfo {
+    ConvolutionMethod method = ConvolutionMethod::Direct;
+    double milliseconds = 0.0;
+};
+
+/**
+     * @brief Human-readable name of a convolution method, e.g. for dialogs.
+     */
+const char* convolutionMethodName(ConvolutionMethod method);
+
+/**
+     * @brief Picks the cheapest method for a kernel: Separable if its SVD shows rank 1,
+     *        Frequency if it has at least 11x11 taps, Direct otherwise.
+     */
+ConvolutionMethod chooseConvolutionMethod(const cv::Mat& kernel);
+
+/**
+     * @brief Kernel equivalent to filtering with `first`, then with `second` (both CV_32F, as used by cv::filter2D).
+     * @return A (first.rows + second.rows - 1) x (first.cols + second.cols - 1) CV_32F kernel.
+     */
+cv::Mat combineKernels(const cv::Mat& first, const cv::Mat& second);
+
+/**
+     * @brief Filters the image with `kernel` like cv::filter2D (same depth, centred anchor), using chooseConvolutionMethod().
+     * Every method runs on tiles padded with the real neighbouring pixels and `borderOption` past the image
+     * edge, so the borders match filter2D exactly; values can differ by one gray level of rounding.
+     * @param inputImage The input image (any channel count).
+     * @param kernel The filter kernel (converted to CV_32F).
+     * @param borderOption OpenCV border handling flag.
+     * @param info Optional: receives the method used and the elapsed time.
+     * @return The filtered image.
+     */
+MatResult convolve(const cv::Mat& inputImage, const cv::Mat& kernel, int borderOption, ConvolutionInfo* info = nullptr);
 
 /**
      * @brief Applies a custom user-defined filter kernel.
@@ -252,18 +480,32 @@ cv::Mat applyPrewittEdgeDetection(const cv::Mat& inputImage, int direction, int
      * @param kernel The custom filter kernel (CV_32F).
      * @param normalize If true, the kernel will be normalized by dividing by its sum (if sum is non-zero).
      * @param borderOption OpenCV border handling flag.
+     * @param info Optional: receives the convolution method used and its timing (see convolve()).
      * @return The filtered image.
      */
-cv::Mat applyCustomFilter(const cv::Mat& inputImage, cv::Mat kernel, bool normalize, int borderOption);
+MatResult applyCustomFilter(const cv::Mat& inputImage, cv::Mat kernel, bool normalize, int borderOption,
+                            ConvolutionInfo* info = nullptr);
 
 /**
-     * @brief Applies a median filter.
-     * @param inputImage The input grayscale image.
-     * @param kernelSize Aperture linear size (must be odd and greater than 1, e.g., 3, 5).
+     * @brief Applies a median filter (constant time per pixel above 7x7, so large kernels stay fast).
+     * @param inputImage The input 8-bit grayscale image.
+     * @param kernelSize Aperture linear size (must be odd and greater than 1, e.g., 3, 5, 51).
      * @param borderOption OpenCV border handling flag (Note: medianBlur itself doesn't use borderOption, custom implementation needed for that).
+     * @param progress Optional progress reporting and cancellation.
      * @return The median-filtered image.
      */
-cv::Mat applyMedianFilter(const cv::Mat& inputImage, int kernelSize, int borderOption);
+MatResult applyMedianFilter(const cv::Mat& inputImage, int kernelSize, int borderOption, OperationProgress* progress = nullptr);
+
+/**
+     * @brief How applyTwoStepFilter() runs its two kernels. All give the same image up to rounding.
+     */
+enum class TwoStepStrategy {
+    Combined,   ///< One pass with the combined 5x5 kernel (see convolve())
+    Sequential, ///< A 3x3 pass per kernel, with a float intermediate
+    Separable   ///< Row and column passes with the combined 1-D kernels; kernels without rank 1 run as 3x3 passes
+};
+
+const char* twoStepStrategyName(TwoStepStrategy strategy);
 
 /**
      * @brief Applies a 5x5 filter derived from the convolution of two 3x3 kernels.
@@ -271,9 +513,28 @@ cv::Mat applyMedianFilter(const cv::Mat& inputImage, int kernelSize, int borderO
      * @param kernel1 The first 3x3 kernel (CV_32F).
      * @param kernel2 The second 3x3 kernel (CV_32F).
      * @param borderOption OpenCV border handling flag.
-     * @return The filtered image using the combined 5x5 kernel.
+     * @param strategy How the kernels are applied.
+     * @param info Optional: receives the convolution method used and its timing (see convolve()).
+     * @return The filtered image, normalized by the sum of the combined 5x5 kernel.
+     */
+MatResult applyTwoStepFilter(const cv::Mat& inputImage, const cv::Mat& kernel1, const cv::Mat& kernel2, int borderOption,
+                             TwoStepStrategy strategy = TwoStepStrategy::Combined, ConvolutionInfo* info = nullptr);
+
+/**
+     * @brief Time one strategy took in benchmarkTwoStepFilter().
+     */
+struct StrategyTiming {
+    TwoStepStrategy strategy;
+    double milliseconds; ///< Best of the runs
+};
+
+/**
+     * @brief Runs applyTwoStepFilter() with every strategy on the image and times each.
+     * @param runs Runs per strategy; the fastest counts, which filters out scheduling noise.
+     * @return One timing per strategy, in TwoStepStrategy order, or the filter's error.
      */
-cv::Mat applyTwoStepFilter(const cv::Mat& inputImage, const cv::Mat& kernel1, const cv::Mat& kernel2, int borderOption);
+Result<std::vector<StrategyTiming>> benchmarkTwoStepFilter(const cv::Mat& inputImage, const cv::Mat& kernel1,
+                                                           const cv::Mat& kernel2, int borderOption, int runs = 5);
 
 // ==========================================================================
 // Group 9: Image Processing - Morphology
@@ -294,7 +555,7 @@ cv::Mat getStructuringElement(StructuringElementType type);
      * @param borderOption OpenCV border handling flag.
      * @return The eroded image.
      */
-cv::Mat applyErosion(const cv::Mat& inputImage, StructuringElementType elementType, int iterations, int borderOption);
+MatResult applyErosion(const cv::Mat& inputImage, StructuringElementType elementType, int iterations, int borderOption);
 
 /**
      * @brief Applies morphological dilation.
@@ -304,7 +565,7 @@ cv::Mat applyErosion(const cv::Mat& inputImage, StructuringElementType elementTy
      * @param borderOption OpenCV border handling flag.
      * @return The dilated image.
      */
-cv::Mat applyDilation(const cv::Mat& inputImage, StructuringElementType elementType, int iterations, int borderOption);
+MatResult applyDilation(const cv::Mat& inputImage, StructuringElementType elementType, int iterations, int borderOption);
 
 /**
      * @brief Applies morphological opening (erosion followed by dilation).
@@ -314,7 +575,7 @@ cv::Mat applyDilation(const cv::Mat& inputImage, StructuringElementType elementT
      * @param borderOption OpenCV border handling flag.
      * @return The opened image.
      */
-cv::Mat applyOpening(const cv::Mat& inputImage, StructuringElementType elementType, int iterations, int borderOption);
+MatResult applyOpening(const cv::Mat& inputImage, StructuringElementType elementType, int iterations, int borderOption);
 
 /**
      * @brief Applies morphological closing (dilation followed by erosion).
@@ -324,15 +585,16 @@ cv::Mat applyOpening(const cv::Mat& inputImage, StructuringElementType elementTy
      * @param borderOption OpenCV border handling flag.
      * @return The closed image.
      */
-cv::Mat applyClosing(const cv::Mat& inputImage, StructuringElementType elementType, int iterations, int borderOption);
+MatResult applyClosing(const cv::Mat& inputImage, StructuringElementType elementType, int iterations, int borderOption);
 
 /**
      * @brief Applies morphological skeletonization iteratively.
      * @param inputImage The input binary image (non-zero pixels treated as foreground).
      * @param elementType The structuring element type to use (typically Diamond).
+     * @param progress Optional progress reporting and cancellation.
      * @return The skeletonized image (CV_8U).
      */
-cv::Mat applySkeletonization(const cv::Mat& inputImage, StructuringElementType elementType);
+MatResult applySkeletonization(const cv::Mat& inputImage, StructuringElementType elementType, OperationProgress* progress = nullptr);
 
 
 // ==========================================================================
@@ -345,9 +607,9 @@ cv::Mat applySkeletonization(const cv::Mat& inputImage, StructuringElementType e
      * @param rho Distance resolution of the accumulator in pixels.
      * @param theta Angle resolution of the accumulator in radians.
      * @param threshold Accumulator threshold parameter. Only lines receiving more votes than threshold are returned.
-     * @return An image with the detected lines drawn.
+     * @return An image with the detected lines drawn, or an Error if no lines were detected.
      */
-cv::Mat detectHoughLines(const cv::Mat& binaryEdgeImage, double rho, double theta, int threshold);
+MatResult detectHoughLines(const cv::Mat& binaryEdgeImage, double rho, double theta, int threshold);
 
 // ==========================================================================
 // Group 11: Image Segmentation - Thresholding
@@ -360,21 +622,21 @@ cv::Mat detectHoughLines(const cv::Mat& binaryEdgeImage, double rho, double thet
      * @param threshold Threshold value.
      * @return An image with the threshold applied.
      */
-cv::Mat applyGlobalThreshold(const cv::Mat& inputImage, int threshold);
+MatResult applyGlobalThreshold(const cv::Mat& inputImage, int threshold);
 
 /**
      * @brief Determines the threshold for a pixel based on a small region around it and thresholds it.
      * @param inputImage The input grayscale image.
      * @return An image with the adaptive threshold applied.
      */
-cv::Mat applyAdaptiveThreshold(const cv::Mat& inputImage);
+MatResult applyAdaptiveThreshold(const cv::Mat& inputImage);
 
 /**
      * @brief Otsu's method determines an optimal global threshold value from the image histogram and then thresholds an image.
      * @param inputImage The input grayscale image.
      * @return An image with the Otsu Threshold applied.
      */
-cv::Mat applyOtsuThreshold(const cv::Mat& inputImage);
+MatResult applyOtsuThreshold(const cv::Mat& inputImage);
 
 /**
      * @brief Magic wand segmentation algorithm which puts all nearby pixels with values within tolerance into one group.
@@ -383,23 +645,25 @@ cv::Mat applyOtsuThreshold(const cv::Mat& inputImage);
      * @param tolerance Tolerance value.
      * @return A magic wand segmented image.
      */
-cv::Mat magicWandSegmentation(const cv::Mat& inputImageRaw, const cv::Point& seed, int tolerance);
+MatResult magicWandSegmentation(const cv::Mat& inputImageRaw, const cv::Point& seed, int tolerance);
 
 /**
      * @brief Grab cut segmentation algorithm which cuts the object from the background.
      * @param inputImage The input grayscale image.
      * @param rect The rectangle area on which the operation will be applied.
      * @param iterCount Operation iterations count.
+     * @param progress Optional progress reporting and cancellation (checked between iterations).
      * @return A grab cutted image.
      */
-cv::Mat grabCutSegmentation(const cv::Mat& inputImage, const cv::Rect& rect, int iterCount = 5);
+MatResult grabCutSegmentation(const cv::Mat& inputImage, const cv::Rect& rect, int iterCount = 5, OperationProgress* progress = nullptr);
 
 /**
      * @brief Watershed algorithm with all preprocessing steps included.
      * @param inputImage The input image.
+     * @param progress Optional progress reporting and cancellation (checked between stages).
      * @return An image with the Watershed applied.
      */
-cv::Mat applyWatershedSegmentation(const cv::Mat &inputImage);
+MatResult applyWatershedSegmentation(const cv::Mat &inputImage, OperationProgress* progress = nullptr);
 
 /**
      * @brief Inpaitning algorithm.
@@ -407,9 +671,10 @@ cv::Mat applyWatershedSegmentation(const cv::Mat &inputImage);
      * @param mask The inpainting mask.
      * @param radius Radius value.
      * @param method Used method.
+     * @param progress Optional progress reporting and cancellation (checked before the inpainting pass).
      * @return An image with the Inpainting applied.
      */
-cv::Mat applyInpainting(const cv::Mat& inputImage, const cv::Mat& mask, double radius, int method);
+MatResult applyInpainting(const cv::Mat& inputImage, const cv::Mat& mask, double radius, int method, OperationProgress* progress = nullptr);
 
 /**
      * @brief Computes all shape features listed in ShapeFeatures structure.
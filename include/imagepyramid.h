@@ -0,0 +1,50 @@
+#ifndef IMAGEPYRAMID_H
+#define IMAGEPYRAMID_H
+
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * @brief Gaussian pyramid of an image (level 0 is the image itself, each level half the previous).
+ *
+ * The pyramid keeps a reference to the image it was built from, so that buffer cannot be freed
+ * and reused while the pyramid exists: isBuiltFrom() can safely compare buffer addresses to tell
+ * whether an image has changed since.
+ */
+class ImagePyramid {
+public:
+    ImagePyramid() = default;
+
+    /**
+     * @brief Builds the levels with cv::pyrDown until the shorter side would drop below `minSize`.
+     */
+    explicit ImagePyramid(const cv::Mat& image, int minSize = 32);
+
+    bool empty() const { return levels.empty(); }
+    bool isBuiltFrom(const cv::Mat& image) const;
+
+    int levelCount() const { return static_cast<int>(levels.size()); }
+    const cv::Mat& level(int index) const { return levels[index]; }
+
+    /**
+     * @brief Sampling scale of a level relative to level 0: exactly 2^-index.
+     */
+    static double levelScale(int index);
+
+    /**
+     * @brief The finest level that is not smaller than `scale` (level 0 for scale >= 1)
+     *        and the blend weight towards the next coarser level, in [0, 1).
+     */
+    int levelFor(double scale, double* blendToCoarser = nullptr) const;
+
+    /**
+     * @brief Resamples the region `target` of the image scaled by `scale` (in scaled pixels),
+     *        blending the two pyramid levels around `scale` (trilinear filtering).
+     */
+    cv::Mat render(double scale, const cv::Rect& target) const;
+
+private:
+    std::vector<cv::Mat> levels;
+};
+
+#endif // IMAGEPYRAMID_H
@@ -0,0 +1,48 @@
+#ifndef IMAGESNAPSHOT_H
+#define IMAGESNAPSHOT_H
+
+#include <memory>
+#include <opencv2/core.hpp>
+
+/**
+ * @brief An immutable, reference-counted image.
+ *
+ * Copying a snapshot shares its pixels, so handing an image to another viewer, a dialog or a worker
+ * thread costs a reference count increment, however large the image. The pixels are only readable
+ * through the snapshot (mat() is a const header and must never be written through), so every holder
+ * can read them concurrently without locking while the source goes on editing its own buffer.
+ *
+ * Copy-on-write is explicit: whoever wants to modify the pixels calls clone() for a private copy.
+ */
+class ImageSnapshot {
+public:
+    ImageSnapshot() = default;
+
+    /**
+     * @brief Shares `image` without copying. Its owner must not write into the buffer afterwards,
+     * except after checking isShared() on the snapshots it handed out.
+     */
+    explicit ImageSnapshot(const cv::Mat& image);
+
+    const cv::Mat& mat() const;
+    bool empty() const { return !pixels || pixels->empty(); }
+    cv::Size size() const { return pixels ? pixels->size() : cv::Size(); }
+    int type() const { return pixels ? pixels->type() : 0; }
+    int channels() const { return pixels ? pixels->channels() : 0; }
+
+    /**
+     * @brief Whether another snapshot (in any thread) still shares these pixels.
+     */
+    bool isShared() const { return pixels.use_count() > 1; }
+    bool sharesBufferWith(const cv::Mat& image) const;
+
+    /**
+     * @brief A writable deep copy of the pixels.
+     */
+    cv::Mat clone() const;
+
+private:
+    std::shared_ptr<const cv::Mat> pixels;
+};
+
+#endif // IMAGESNAPSHOT_H
@@ -0,0 +1,43 @@
+#ifndef IMAGESTACKING_H
+#define IMAGESTACKING_H
+
+#include "imageprocessing.h"
+#include <vector>
+
+namespace ImageProcessing {
+
+enum class StackMethod {
+    Mean,
+    Median,
+    SigmaClippedMean // Mean of the values within `kappa` standard deviations of the mean, iterated
+};
+
+struct StackOptions {
+    StackMethod method = StackMethod::Mean;
+    double kappa = 3.0;  // SigmaClippedMean: rejection threshold in standard deviations
+    int iterations = 5;  // SigmaClippedMean: passes at most, fewer once no value is rejected
+};
+
+/**
+ * @brief Combines aligned frames pixel by pixel, e.g. to reduce the noise of 50-500 exposures.
+ *
+ * Frames are streamed in blocks of a fixed number of values: several whole rows while rows are short,
+ * a part of one row when a row holds more values than fit (long rows, or many frames for the median
+ * and sigma clipping). Each block of every frame is converted to float once, and the per-pixel
+ * accumulators (sums for the mean, every frame's value for the median and sigma clipping) only ever
+ * hold one block per worker, so memory beyond the result stays bounded however many frames there
+ * are. Blocks are processed in parallel.
+ *
+ * The result has a higher bit depth than the frames, so the precision gained by combining them
+ * isn't rounded away: 8-bit frames give a CV_16U result scaled by 257 (255 maps to 65535),
+ * 16-bit and float frames a CV_32F result in their own range.
+ *
+ * @param frames At least two non-empty images of the same size and type (8U, 16U or 32F, any channel count).
+ * @param progress Optional progress reporting and cancellation (checked between blocks).
+ */
+MatResult stackImages(const std::vector<cv::Mat>& frames, const StackOptions& options = {},
+                      OperationProgress* progress = nullptr);
+
+} // namespace ImageProcessing
+
+#endif // IMAGESTACKING_H
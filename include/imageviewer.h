@@ -4,7 +4,6 @@
 #include <QWidget>
 #include <QLabel>
 #include <qcheckbox.h>
-#include <stack>
 #include <vector>
 #include <QVBoxLayout>
 #include <QWheelEvent>
@@ -16,8 +15,14 @@
 #include <opencv2/opencv.hpp>
 #include <QImage>
 #include <QPixmap>
-#include "clickablelabel.h" // Assuming this exists
+#include "imagecanvas.h"
 #include "previewdialogbase.h" // Assuming this exists
+#include "imageprocessing.h" // For StructuringElementType and MatResult
+#include "operationrunner.h"
+#include "processingpipeline.h"
+#include "undohistory.h"
+#include "imagesnapshot.h"
+#include "tiledimage.h"
 
 // Forward declarations
 class MainWindow;
@@ -25,11 +30,14 @@ class ImageOperation; // Assuming this exists
 class QLineEdit;
 class QTableWidget;
 class HistogramWidget; // Assuming this exists
-
-// Enum for morphology structuring element type
-enum StructuringElementType {
-    Diamond, // Typically 4-connected for 3x3
-    Square   // Typically 8-connected for 3x3
+class QProgressBar;
+class QScrollArea;
+
+// The image a dialog generator should bind: the full image for the accepted operation,
+// or a reduced pyramid level of it for previews.
+struct PreviewSource {
+    cv::Mat image;
+    double scale = 1.0; // image size relative to originalImage; pixel-sized parameters scale with it
 };
 
 class ImageViewer : public QWidget {
@@ -39,6 +47,8 @@ public:
     // ======================================================================
     // `Constructor & Core Management`
     // ======================================================================
+    // `image` is shared, not copied: viewers never modify images in place, so other viewers and
+    // the image cache can hold the same buffer. Callers must not modify it afterwards.
     explicit ImageViewer(const cv::Mat &image, const QString &title, QWidget *parent = nullptr,
                          QPoint position = QPoint(100, 100), MainWindow *mainWindow = nullptr);
 
@@ -46,12 +56,15 @@ public:
     // `Getters & Setters`
     // ======================================================================
     // --- Getters ---
-    cv::Mat getOriginalImage() const { return originalImage; }
+    // Snapshots share the pixels: cheap to take, and safe to read on any thread while this viewer keeps editing
+    ImageSnapshot getSnapshot() const { return ImageSnapshot(originalImage); }
     MainWindow* getMainWindow() const { return mainWindow; }
-    cv::Mat getDrawnMask() const { return drawnMask.clone(); } // Return a clone for safety
+    ImageSnapshot getDrawnMask() const;
 
     // --- Setters ---
     void setUsePyramidScaling(bool enable) { usePyramidScaling = enable; updateImage();}
+    void setUndoMemoryBudget(size_t bytes);
+    void setUndoSpillDirectory(const QString& directory); // Empty: drop states over the budget
 
     // ======================================================================
     // `UI Interaction & Control`
@@ -71,28 +84,51 @@ public:
     // ======================================================================
     void undo();
     void redo();
-    void pushToUndoStack(); // Call before modifying `originalImage` via an operation
+    // Applies a result with undo, or shows its error. `steps` reproduce the operation in a macro
+    // (empty if it can't be, e.g. when it depends on other images, masks or picked points).
+    bool commitResult(const ImageProcessing::MatResult& result, const QVector<PipelineStep>& steps = {});
+
+    // ======================================================================
+    // `Background Operations`
+    // ======================================================================
+    void runOperation(const QString& name, ImageJob job, const QVector<PipelineStep>& steps = {}); // Runs a job off the GUI thread, commits on completion
+    bool isOperationRunning() const;
+    void schedulePreview(ImageJob job); // Debounced background preview; only the latest request is shown
+    void cancelPreview();               // Drops pending and running previews
+    PreviewSource previewSource();      // Image to preview on: a pyramid level matched to the zoom
+
+    // ======================================================================
+    // `Macros`
+    // ======================================================================
+    void runMacro(const ProcessingPipeline& pipeline); // Replays a pipeline on this image in the background
 
     // ======================================================================
     // `Dialog Preview Helper`
     // ======================================================================
+    // `generator` takes a PreviewSource, reads the dialog's current parameters and returns them
+    // bound into an ImageJob. Previews get a zoom-matched proxy (see previewSource()) and are
+    // coalesced and computed in the background (see schedulePreview());
+    // only the accepted job runs at full resolution, in the background via runOperation().
+    // `describe`, if given, returns the accepted parameters as pipeline steps for macro recording.
     template<typename Func>
-    void setupPreview(PreviewDialogBase* dialog, QCheckBox* previewCheckBox, Func generator) {
+    void setupPreview(PreviewDialogBase* dialog, QCheckBox* previewCheckBox, Func generator,
+                      std::function<QVector<PipelineStep>()> describe = nullptr) {
         connect(dialog, &QDialog::finished, this, [=](int result) {
+            cancelPreview();
+            updateImage();
             if (result == QDialog::Accepted) {
-                pushToUndoStack();
-                originalImage = generator();
+                runOperation(dialog->windowTitle(), generator(PreviewSource{originalImage, 1.0}),
+                             describe ? describe() : QVector<PipelineStep>());
             }
-            updateImage();
         });
 
         connect(dialog, &PreviewDialogBase::previewRequested, this, [=]() {
-            if (previewCheckBox->isChecked()) {
-                cv::Mat preview = generator();
-                showTempImage(preview);
-            } else {
+            if (!previewCheckBox->isChecked()) {
+                cancelPreview();
                 updateImage();
+                return;
             }
+            schedulePreview(generator(previewSource()));
         });
     }
 
@@ -130,6 +166,8 @@ private slots:
     void duplicateImage();
     void drawMask();
     void saveImageAs();
+    void toggleMacroRecording(bool recording); // Starts recording, or stops and saves the macro
+    void runMacroFromFile();
 
     // ======================================================================
     // `Image Type Conversion Slots`
@@ -153,6 +191,7 @@ private slots:
     void applyNegation();
     void rangeStretching();
     void applyPosterization();
+    void applyGammaCorrection();
     void applyBitwiseOperation();
     void showLineProfile(); // Also includes drawing helpers
     void applyGlobalThreshold();
@@ -199,28 +238,47 @@ private:
     // ======================================================================
     // `UI Elements`
     // ======================================================================
-    ClickableLabel *imageLabel; // Assuming ClickableLabel inherits QLabel or similar
+    ImageCanvas *imageCanvas = nullptr;  // Draws the visible part of the image
+    QScrollArea *scrollArea = nullptr;   // Viewport over imageCanvas
     QLineEdit *zoomInput;
     HistogramWidget *histogramWindow = nullptr; // Pointer to the separate histogram window
     QTableWidget *LUT; // Table widget for histogram data (remains embedded)
     QVBoxLayout *mainLayout;
     QMenuBar *menuBar;
     QAction* showHistogramAction; // Action to show histogram window (was histogramAction)
+    QWidget *progressPanel = nullptr;      // Progress bar + Cancel button, visible while an operation runs
+    QProgressBar *progressBar = nullptr;
 
     // ======================================================================
     // `Core State & Data`
     // ======================================================================
-    cv::Mat originalImage; // The currently displayed image data
-    cv::Mat drawnMask;     // Mask being drawn (CV_8UC1)
+    cv::Mat originalImage; // The currently displayed image data; only replaced through adoptImage() and the history
+    cv::Mat drawnMask;     // Mask being drawn (CV_8UC1), in place
+    mutable ImageSnapshot maskSnapshot; // Snapshot of drawnMask's buffer handed out or adopted; drawing detaches from it
     bool drawingMaskMode = false;
     bool showingMaskMode = false;
     QPoint lastDrawPos;
-    std::stack<cv::Mat> undoStack;
-    std::stack<cv::Mat> redoStack;
+    UndoHistory history; // Undo/redo states, compressed and evicted to stay within its memory budget
     double currentScale = 1.0; // Current zoom level (1.0 = 100%)
+    double displayedScale = 0.0; // Zoom level the canvas was last updated with
     MainWindow *mainWindow; // Pointer to the main application window
     QList<ImageOperation*> operationsList; // List of registered operations for state updates
     bool usePyramidScaling = false;
+    OperationRunner *operationRunner = nullptr; // Runs slow operations in the background
+    OperationRunner *previewRunner = nullptr;   // Computes dialog previews in the background
+    QTimer *previewTimer = nullptr;             // Coalesces bursts of preview requests (slider drags)
+    ImageJob pendingPreviewJob;                 // Latest requested preview, not started yet
+    quint64 previewGeneration = 0;              // Bumped on every request; older results are dropped
+    quint64 runningPreviewGeneration = 0;       // Generation of the preview currently computing
+    ImagePyramid imagePyramid;                  // Pyramid of originalImage for pyramid scaling and previews
+    cv::Mat classifiedImage;                    // originalImage as last classified, kept so its buffer can't be reused
+    bool classifiedBinary = false;              // Whether classifiedImage only holds 0 and 255
+    cv::Mat histogramImage;                     // originalImage as last counted, kept so its buffer can't be reused
+    ImageProcessing::Histogram grayHistogram{}; // Gray-level counts of histogramImage
+    QVector<PipelineStep> runningSteps;         // Macro steps of the operation running in operationRunner
+    bool recordingMacro = false;
+    QVector<QVector<PipelineStep>> macroSteps;       // Steps of each operation committed while recording (empty: not recordable)
+    QVector<QVector<PipelineStep>> undoneMacroSteps; // Steps of undone operations, restored on redo
 
     // --- Added for Inpainting Drawing Controls ---
     int currentBrushThickness = 10;  // Default thickness
@@ -251,11 +309,16 @@ private:
     void createMenu();          // Sets up the menu bar and actions
     void registerOperation(ImageOperation *op); // Adds an operation for state management
     void updateOperationsEnabledState(); // Enables/disables menu actions based on image type
+    cv::Mat adoptImage(const cv::Mat &image); // Classifies an incoming image, dropping redundant channels
+    QString borderParameter(); // Current border option as a pipeline "border" value
 
     // ======================================================================
     // `Internal UI Update Helpers`
     // ======================================================================
     void updateImage();         // Updates the displayed pixmap, resizes window
+    void fitWindowToImage();    // Resizes the window to the image, bounded by the screen
+    const ImagePyramid& originalPyramid(); // imagePyramid, rebuilt if originalImage has changed
+    const ImageProcessing::Histogram& originalHistogram(); // grayHistogram, recounted if originalImage has changed
     void updateZoomLabel();     // Updates the text in the zoom input field
     void updateHistogram();     // Recalculates and updates the histogram window (if exists)
     void updateHistogramTable(); // Updates the LUT QTableWidget
@@ -263,13 +326,16 @@ private:
     void drawTemporaryPoints(); // Draws points/lines during selection
     void drawLineProfile(const cv::Point& p1, const cv::Point& p2); // Draws the line profile chart
     void drawOnMask(const QPoint& widgetPos); // Internal drawing function for mask
+    void setDrawnMask(const ImageSnapshot& mask); // Shares `mask` until the next stroke
+    void detachMask();                            // Copy-on-write before drawing into drawnMask
+    void setBusy(bool busy, const QString& operationName = QString()); // Shows progress, locks the menus
+    void startPendingPreview(); // Starts pendingPreviewJob, or cancels the running preview to make room
 
 
     // ======================================================================
     // `Helper Functions`
     // ======================================================================
-    void clearRedoStack();      // Clears the redo stack (used after a new operation)
-    QImage MatToQImage(const cv::Mat &mat); // Converts cv::Mat to QImage
+    void showError(const ImageProcessing::Error& error); // Shows an operation error in a message box
 };
 
 #endif // IMAGEVIEWER_H
@@ -5,6 +5,7 @@
 #include <QMap>
 #include <QVector> // Include necessary header
 #include <opencv2/core.hpp> // Include OpenCV header
+#include "imagesnapshot.h"
 
 // Forward declarations
 class QComboBox;
@@ -29,7 +30,7 @@ class InpaintingDialog : public QDialog {
 
 public:
 
-    cv::Mat drawnMask;
+    ImageSnapshot drawnMask; // The viewer's drawing while another image is used as the mask; empty otherwise
     /**
      * @brief Constructor for InpaintingDialog.
      * @param parentViewer The ImageViewer instance this dialog operates on (for drawing).
@@ -40,9 +41,9 @@ public:
 
     /**
      * @brief Gets the selected mask (either drawn or from another image).
-     * @return cv::Mat The mask image (CV_8UC1) or an empty Mat if invalid.
+     * @return ImageSnapshot The mask image (CV_8UC1), shared rather than copied, or an empty snapshot if invalid.
      */
-    cv::Mat getSelectedMask() const;
+    ImageSnapshot getSelectedMask() const;
     void refreshImageList();
 
     // signals:
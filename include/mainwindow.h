@@ -6,9 +6,16 @@
 #include <QMenuBar>
 #include <QAction>
 #include <QFileDialog>
+#include <QHash>
+#include <QImage>
 #include <QMessageBox>
 #include <opencv2/opencv.hpp>
 
+class ImageLoader;
+class ProcessingPipeline;
+class QListWidget;
+class QListWidgetItem;
+
 class MainWindow : public QMainWindow {
     Q_OBJECT
 
@@ -16,6 +23,10 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
     int getBorderOption();
     bool isPyramidScalingEnabled() const;
+    bool isProxyPreviewEnabled() const;
+    bool isMacroOptimizationEnabled() const;
+    size_t getUndoMemoryBudget() const;
+    QString getUndoSpillDirectory() const;
     QVector<QWidget*> openedImages;
 
 protected:
@@ -25,15 +36,35 @@ protected:
 
 private slots:
     void openImage();
-    void openImage(const QString& filePath);  // replaces previous void openImage()
+    void openImages(const QStringList& filePaths);
+    void showLoadedImage(const QString& filePath, const cv::Mat& image);
+    void showThumbnail(const QString& filePath, const QImage& thumbnail);
+    void clearThumbnails();
     void showInfo(); // New slot for displaying info
     void setBorderOption(int option, QAction *selectedAction);
     void mergeGrayscaleChannels();
     void showBitwiseOperationDialog();
+    void evaluateImageExpression();
+    void stackOpenImages();
+    void setUndoMemoryLimit();
+    void setImageCacheLimit();
+    void runMacroOnOpenImages();
+    void runMacroOnFolder();
 
 private:
+    bool loadMacro(ProcessingPipeline& pipeline); // Asks for a pipeline file and loads it
+    QListWidgetItem* addThumbnailItem(const QString& filePath);
+    ImageLoader *imageLoader;
+    QListWidget *thumbnailStrip;                  // Files of large batches, opened on double click
+    QHash<QString, QListWidgetItem*> thumbnailItems;
     bool usePyramidScaling = false;
     QAction *pyramidScalingToggle;
+    bool useProxyPreview = true;
+    QAction *proxyPreviewToggle;
+    int undoBudgetMB = 512;
+    int imageCacheMB = 512;
+    QAction *undoSpillToggle;
+    QAction *optimizeMacrosToggle;
     int borderOption;
     QAction *borderIsolated;
     QAction *borderReflect;
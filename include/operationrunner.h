@@ -0,0 +1,59 @@
+#ifndef OPERATIONRUNNER_H
+#define OPERATIONRUNNER_H
+
+#include <QObject>
+#include <QTimer>
+#include <functional>
+#include <memory>
+#include "imageprocessing.h"
+
+// An image operation with all parameters already bound, safe to run on a worker thread
+using ImageJob = std::function<ImageProcessing::MatResult(ImageProcessing::OperationProgress& progress)>;
+
+/**
+ * @brief Runs one ImageJob at a time on the global thread pool and reports back on the GUI thread.
+ *
+ * The worker posts its result back through a queued call as soon as the job returns; progress is
+ * sampled by a timer while it runs. The job and the runner only share a reference-counted state object,
+ * so destroying the runner (e.g. closing the viewer) while a job is running is safe: the job is cancelled
+ * and its result dropped.
+ */
+class OperationRunner : public QObject {
+    Q_OBJECT
+
+public:
+    explicit OperationRunner(QObject *parent = nullptr);
+    ~OperationRunner() override;
+
+    /**
+     * @brief Starts the job on a worker thread. Ignored if a job is already running.
+     * @return true if the job was started.
+     */
+    bool start(ImageJob job);
+
+    /**
+     * @brief Requests cancellation of the running job; cancelled() is emitted once it stops.
+     */
+    void cancel();
+
+    bool isRunning() const { return state != nullptr; }
+
+signals:
+    void progressChanged(int percent);
+    void finished(const ImageProcessing::MatResult &result);
+    void cancelled();
+
+private slots:
+    void reportProgress();
+
+private:
+    struct JobState;
+
+    void complete(const std::shared_ptr<JobState>& jobState, const ImageProcessing::MatResult& result);
+
+    std::shared_ptr<JobState> state;
+    QTimer progressTimer;
+    int lastPercent = -1;
+};
+
+#endif // OPERATIONRUNNER_H
@@ -0,0 +1,109 @@
+#ifndef PROCESSINGPIPELINE_H
+#define PROCESSINGPIPELINE_H
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <opencv2/core.hpp>
+
+/**
+ * @brief One named step of a processing pipeline together with its raw parameters.
+ */
+struct PipelineStep {
+    QString name;                   ///< ImageProcessing function name, e.g. "applyMedianFilter".
+    QMap<QString, QString> params;  ///< Raw key=value parameters, e.g. {"size", "5"}.
+};
+
+/**
+ * @brief A declarative chain of ImageProcessing operations.
+ *
+ * Pipelines are written one step per line, or separated with ';' on a single line:
+ * @code
+ *   # comments start with '#'
+ *   convertToGrayscale
+ *   equalizeHistogram
+ *   applyMedianFilter size=5 border=reflect
+ *   applyOtsuThreshold
+ * @endcode
+ * The pipeline only depends on the processing code (no widgets), so it can be run from worker threads.
+ */
+class ProcessingPipeline {
+public:
+    ProcessingPipeline() = default;
+    explicit ProcessingPipeline(const QVector<PipelineStep>& steps) : stepList(steps) {}
+
+    /**
+     * @brief Parses a pipeline description.
+     * @param text The pipeline text (lines and/or ';'-separated steps).
+     * @param errorMessage Receives a description of the first syntax error, if any.
+     * @return true if every step names a known operation.
+     */
+    bool parse(const QString& text, QString* errorMessage = nullptr);
+
+    /**
+     * @brief Reads and parses a pipeline file.
+     * @param filePath Path to the pipeline file.
+     * @param errorMessage Receives a description of the failure, if any.
+     * @return true on success.
+     */
+    bool load(const QString& filePath, QString* errorMessage = nullptr);
+
+    /**
+     * @brief Writes the pipeline to a file in the format load() reads.
+     * @param filePath Path to the pipeline file.
+     * @param errorMessage Receives a description of the failure, if any.
+     * @return true on success.
+     */
+    bool save(const QString& filePath, QString* errorMessage = nullptr) const;
+
+    /**
+     * @brief Serializes the pipeline back to its textual form (one step per line).
+     */
+    QString toString() const;
+
+    /**
+     * @brief Runs every step in order on the given image.
+     * Consecutive point operations on a grayscale image are folded into one lookup table and applied in a single pass.
+     * @param input The input image (not modified).
+     * @param errorMessage Receives "step N (name): reason" when a step fails.
+     * @return The final image, or an empty Mat if a step failed.
+     */
+    cv::Mat run(const cv::Mat& input, QString* errorMessage = nullptr) const;
+
+    /**
+     * @brief Returns an equivalent pipeline that does less work.
+     *  - Pairs of steps that undo each other (two negations) and repeated conversions are dropped.
+     *  - Consecutive smoothing filters (box, Gaussian, normalized non-negative custom kernels) with the
+     *    same border become one custom filter with the combined kernel, up to 11x11.
+     * A fused filter rounds once instead of after every step and extrapolates the border once, so pixels
+     * can differ by a gray level, and near the image edge by more. Point operations need no rewriting:
+     * run() already folds them into one lookup table.
+     */
+    ProcessingPipeline optimized() const;
+
+    bool isEmpty() const { return stepList.isEmpty(); }
+    const QVector<PipelineStep>& steps() const { return stepList; }
+    void append(const PipelineStep& step) { stepList.append(step); }
+    void clear() { stepList.clear(); }
+
+    /**
+     * @brief Lists the step names understood by the pipeline.
+     */
+    static QStringList availableSteps();
+
+    /**
+     * @brief Parameter value of an OpenCV border flag, as read back by the steps' "border" parameter.
+     */
+    static QString borderName(int borderOption);
+
+    /**
+     * @brief Parameter value of a square kernel: comma-separated row-major values.
+     */
+    static QString kernelToString(const cv::Mat& kernel);
+
+private:
+    QVector<PipelineStep> stepList;
+};
+
+#endif // PROCESSINGPIPELINE_H
@@ -0,0 +1,54 @@
+#ifndef RLECODEC_H
+#define RLECODEC_H
+
+#include <QIODevice>
+#include <QString>
+#include <opencv2/core.hpp>
+
+/**
+ * @brief Reads and writes the app's run-length encoded `.rle` images.
+ *
+ * Version 2 layout (little endian):
+ *  - header: "APRL", version (u8 = 2), channels (u8: 1, 3 or 4), reserved (u16 = 0), width (u32), height (u32);
+ *  - blocks of up to BlockRows image rows, each a payload size (u32) followed by the payload;
+ *  - a payload is a list of runs, each the pixel value (`channels` bytes) and the run length minus one
+ *    as a variable-length integer (7 bits per byte, low bits first, high bit set on all but the last byte).
+ *
+ * Runs may cross row ends but not block ends, so a block is encoded and decoded on its own and only one
+ * block is buffered at a time. Run lengths have no fixed cap: runs up to 128 pixels take one byte,
+ * up to 16384 two. Version 1 files ("GRE"/"COL" + width + height, 1-byte run lengths) are still read.
+ */
+namespace RleCodec {
+
+constexpr int FormatVersion = 2;
+constexpr int BlockRows = 64;
+
+/**
+ * @brief Whether an image can be stored: 8-bit with 1, 3 or 4 channels.
+ */
+bool canEncode(const cv::Mat& image);
+
+/**
+ * @brief Encodes `image` to `device` (opened for writing).
+ * @param encodedBytes Optional: receives the number of bytes written, header included.
+ * @param errorMessage Receives a description of the failure, if any.
+ * @return true on success.
+ */
+bool write(const cv::Mat& image, QIODevice& device, qint64* encodedBytes = nullptr, QString* errorMessage = nullptr);
+bool write(const cv::Mat& image, const QString& filePath, qint64* encodedBytes = nullptr, QString* errorMessage = nullptr);
+
+/**
+ * @brief Decodes an image from `device` (opened for reading), in either format version.
+ * @return The image, or an empty Mat if the data is malformed or truncated.
+ */
+cv::Mat read(QIODevice& device, QString* errorMessage = nullptr);
+cv::Mat read(const QString& filePath, QString* errorMessage = nullptr);
+
+/**
+ * @brief Decodes an image from encoded bytes in memory (e.g. a mapped file), without copying them.
+ */
+cv::Mat decode(const uchar* data, size_t size, QString* errorMessage = nullptr);
+
+} // namespace RleCodec
+
+#endif // RLECODEC_H
@@ -0,0 +1,51 @@
+#ifndef STACKINGDIALOG_H
+#define STACKINGDIALOG_H
+
+#include <QDialog>
+#include <QVector>
+#include "imagestacking.h"
+
+class QComboBox;
+class QDialogButtonBox;
+class QDoubleSpinBox;
+class QLabel;
+class QLineEdit;
+class QListWidget;
+class QSpinBox;
+class ImageViewer;
+
+/**
+ * @brief Asks which open images to stack (see ImageProcessing::stackImages), how to combine them,
+ * and optionally a file for the full bit depth result. All images start checked; OK is only enabled
+ * while at least two of the same size and type are.
+ */
+class StackingDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    explicit StackingDialog(const QVector<QWidget*>& openedImages, QWidget *parent = nullptr);
+
+    QVector<ImageViewer*> getSelectedViewers() const;
+    ImageProcessing::StackOptions getOptions() const;
+
+    /**
+     * @brief Where to save the result at its full bit depth, or an empty string to only show it.
+     */
+    QString getOutputPath() const;
+
+private slots:
+    void validate();
+    void browseOutputPath();
+
+private:
+    QListWidget *frameList;
+    QComboBox *methodCombo;
+    QDoubleSpinBox *kappaSpin;
+    QSpinBox *iterationsSpin;
+    QLineEdit *outputPathEdit;
+    QLabel *statusLabel;
+    QDialogButtonBox *buttonBox;
+    QVector<ImageViewer*> viewers; // One per list row
+};
+
+#endif // STACKINGDIALOG_H
@@ -0,0 +1,56 @@
+#ifndef TILEDIMAGE_H
+#define TILEDIMAGE_H
+
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * @brief Splits an image into a grid of fixed-size tiles (the last row/column may be smaller).
+ *
+ * Tiles are ROI views into the shared image buffer, so building the grid copies no pixels.
+ * Tiles are numbered row-major: index = row * columns() + column.
+ */
+class TiledImage {
+public:
+    static constexpr int DefaultTileSize = 256;
+
+    TiledImage() = default;
+    explicit TiledImage(const cv::Mat& image, int tileSize = DefaultTileSize);
+
+    const cv::Mat& image() const { return source; }
+    bool empty() const { return source.empty(); }
+    int tileSize() const { return size; }
+    int columns() const { return cols; }
+    int rows() const { return rowCount; }
+    int tileCount() const { return cols * rowCount; }
+
+    /**
+     * @brief Image coordinates covered by a tile.
+     */
+    cv::Rect tileRect(int index) const;
+
+    /**
+     * @brief View of one tile (no copy). Writing to it writes to the image.
+     */
+    cv::Mat tile(int index) const { return source(tileRect(index)); }
+
+    /**
+     * @brief Copy of a tile extended by `halo` pixels on each side. Inside the image the halo holds
+     *        the neighbouring pixels; beyond the image edge it is extrapolated with `borderType`
+     *        (an OpenCV border flag, BORDER_ISOLATED is ignored), matching what a whole-image filter sees.
+     */
+    cv::Mat paddedTile(int index, int halo, int borderType) const;
+
+    /**
+     * @brief Indices of the tiles overlapping `region` (in image coordinates), row-major.
+     */
+    std::vector<int> tilesIntersecting(const cv::Rect& region) const;
+
+private:
+    cv::Mat source;
+    int size = DefaultTileSize;
+    int cols = 0;
+    int rowCount = 0;
+};
+
+#endif // TILEDIMAGE_H
@@ -2,8 +2,10 @@
 #define TWOSTEPFILTERDIALOG_H
 
 #include "previewdialogbase.h"
+#include "imageprocessing.h"
 #include <QDialog>
 #include <QVector>
+#include <QComboBox>
 #include <QGridLayout>
 #include <QSpinBox>
 #include <QLabel>
@@ -19,10 +21,14 @@ public:
     cv::Mat getKernel1();
     cv::Mat getKernel2();
     cv::Mat getKernel3();
+    ImageProcessing::TwoStepStrategy getStrategy() const;
     QCheckBox* getPreviewCheckBox() const { return previewCheckBox; }
+    void setConvolutionInfo(const ImageProcessing::ConvolutionInfo& info); // Shows how the last preview was filtered
+    void setBenchmarkResults(const std::vector<ImageProcessing::StrategyTiming>& timings);
 
 signals:
     void previewRequested();
+    void benchmarkRequested(); // Asks the owner to time every strategy on the full image
 
 private slots:
     void loadKernel1FromFile();
@@ -33,6 +39,9 @@ private:
     QVector<QVector<QDoubleSpinBox*>> kernelInputs2;
     QVector<QVector<QDoubleSpinBox*>> kernel5x5Labels;
     QCheckBox* previewCheckBox;
+    QLabel* methodLabel;
+    QComboBox* strategyBox;
+    QLabel* benchmarkLabel;
 
     void initKernels(QGridLayout *grid1, QGridLayout *grid2, QGridLayout *grid5x5);
     QDoubleSpinBox* createSpinBox(QGridLayout *layout, int row, int col);
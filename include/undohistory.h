@@ -0,0 +1,102 @@
+#ifndef UNDOHISTORY_H
+#define UNDOHISTORY_H
+
+#include <QByteArray>
+#include <QString>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <opencv2/core.hpp>
+
+class QTemporaryFile;
+
+/**
+ * @brief Undo/redo store for the images of one viewer, bounded by a memory budget.
+ *
+ * States are kept as shared cv::Mat headers (no copy) as long as they fit in the budget.
+ * Committed images are never written to in place, so sharing a buffer with the viewer or with
+ * a duplicated viewer is safe. When the budget is exceeded, the states farthest from the current
+ * image are re-encoded as compressed tiles that differ from their newer neighbour, then (if a spill
+ * directory is set) moved to disk, and finally dropped, oldest first.
+ *
+ * Copying a history is cheap: encoded tiles and spill files are shared between the copies.
+ */
+class UndoHistory {
+public:
+    static constexpr size_t DefaultBudget = size_t(512) * 1024 * 1024;
+
+    explicit UndoHistory(size_t budgetBytes = DefaultBudget);
+
+    /**
+     * @brief Records `previous` as the state before `current` and clears the redo states.
+     * The owner must not replace its current image any other way: delta-encoded states are rebuilt from it.
+     */
+    void push(const cv::Mat& previous, const cv::Mat& current);
+
+    /**
+     * @brief Moves one step back. `current` becomes the first redo state.
+     * @return The previous image, or an empty Mat if there is nothing to undo or the state could not be
+     * rebuilt (see decode()); the history is then left unchanged.
+     */
+    cv::Mat undo(const cv::Mat& current);
+
+    /**
+     * @brief Moves one step forward. `current` becomes the last undo state.
+     * @return The next image, or an empty Mat if there is nothing to redo or the state could not be rebuilt.
+     */
+    cv::Mat redo(const cv::Mat& current);
+
+    bool canUndo() const { return !undoStates.empty(); }
+    bool canRedo() const { return !redoStates.empty(); }
+    int undoCount() const { return static_cast<int>(undoStates.size()); }
+    int redoCount() const { return static_cast<int>(redoStates.size()); }
+    void clear();
+
+    /**
+     * @brief Sets the memory budget in bytes; older states are compressed, spilled or evicted to meet it.
+     * @param current The viewer's current image, needed to re-encode the nearest states.
+     */
+    void setBudget(size_t bytes, const cv::Mat& current);
+    size_t budget() const { return budgetBytes; }
+    size_t memoryUsage() const;
+
+    /**
+     * @brief Directory for states that do not fit in memory. Empty (the default) drops them instead.
+     */
+    void setSpillDirectory(const QString& directory) { spillDirectory = directory; }
+    QString getSpillDirectory() const { return spillDirectory; }
+
+private:
+    struct Tile {
+        cv::Rect rect;
+        QByteArray data; // qCompress'ed pixels of the rectangle, rows packed
+    };
+
+    struct Entry {
+        cv::Mat image;                  // Full state, shared; empty once encoded
+        cv::Size size;
+        int type = 0;
+        bool relative = false;          // Tiles patch the neighbour nearer to the current image
+        std::vector<Tile> tiles;
+        std::shared_ptr<QTemporaryFile> spillFile; // Holds the tiles once spilled to disk
+
+        bool isFull() const { return !image.empty(); }
+        size_t bytes() const;
+    };
+
+    // back() is the state adjacent to the current image
+    using States = std::deque<Entry>;
+
+    static Entry encode(const cv::Mat& image, const cv::Mat& neighbour);
+    cv::Mat decode(const Entry& entry, const cv::Mat& neighbour) const;
+    bool compactOldest(States& states, const cv::Mat& current);
+    bool spillOldest(States& states);
+    void enforceBudget(const cv::Mat& current);
+
+    States undoStates;
+    States redoStates;
+    size_t budgetBytes;
+    QString spillDirectory;
+};
+
+#endif // UNDOHISTORY_H
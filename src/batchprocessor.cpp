@@ -0,0 +1,109 @@
+#include "batchprocessor.h"
+#include "imagefile.h"
+#include "rlecodec.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+#include <opencv2/imgcodecs.hpp>
+#include <vector>
+
+BatchProcessor::BatchProcessor(const ProcessingPipeline& pipeline, const BatchOptions& options)
+    : pipeline(pipeline), options(options) {}
+
+// Mirrors the input directory layout below outputDir, optionally switching the extension.
+QString BatchProcessor::outputPathFor(const QString& inputPath) const {
+    const QString relative = QDir(options.inputDir).relativeFilePath(inputPath);
+    QString outputPath = QDir(options.outputDir).filePath(relative);
+    if (!options.outputFormat.isEmpty()) {
+        const QFileInfo info(outputPath);
+        outputPath = info.dir().filePath(info.completeBaseName() + "." + options.outputFormat);
+    }
+    return outputPath;
+}
+
+// Decodes, runs the pipeline and encodes one file. Returns an error message or an empty string.
+QString BatchProcessor::processFile(const QString& inputPath, const QString& outputPath) const {
+    QString error;
+    const cv::Mat input = ImageFile::loadView(inputPath, &error); // Dropped once the file is processed
+    if (input.empty()) {
+        return error;
+    }
+
+    const cv::Mat output = pipeline.run(input, &error);
+    if (output.empty()) {
+        return error;
+    }
+
+    QDir().mkpath(QFileInfo(outputPath).absolutePath());
+    if (QFileInfo(outputPath).suffix().compare("rle", Qt::CaseInsensitive) == 0) {
+        return RleCodec::write(output, outputPath, nullptr, &error) ? QString() : error;
+    }
+
+    std::vector<uchar> buffer;
+    const std::string extension = "." + QFileInfo(outputPath).suffix().toStdString();
+    try {
+        if (!cv::imencode(extension, output, buffer)) {
+            return "cannot encode as " + QString::fromStdString(extension);
+        }
+    } catch (const cv::Exception& e) {
+        return QString::fromStdString(e.what());
+    }
+
+    QSaveFile outFile(outputPath);
+    if (!outFile.open(QIODevice::WriteOnly)) {
+        return "cannot write: " + outFile.errorString();
+    }
+    outFile.write(reinterpret_cast<const char*>(buffer.data()), static_cast<qint64>(buffer.size()));
+    if (!outFile.commit()) {
+        return "cannot write: " + outFile.errorString();
+    }
+    return QString();
+}
+
+BatchResult BatchProcessor::run(const FileCallback& onFileDone) {
+    QElapsedTimer timer;
+    timer.start();
+    cancelled = false;
+
+    QThreadPool pool;
+    const int threads = options.threadCount > 0 ? options.threadCount : QThread::idealThreadCount();
+    pool.setMaxThreadCount(threads);
+
+    // Limit queued + running files so a huge directory never sits decoded in memory at once
+    QSemaphore inFlight(threads * 2);
+    std::atomic<int> succeeded{0};
+    std::atomic<int> failed{0};
+
+    QDirIterator it(options.inputDir, options.nameFilters, QDir::Files | QDir::Readable,
+                    options.recursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
+    while (it.hasNext() && !cancelled) {
+        const QString inputPath = it.next();
+        const QString outputPath = outputPathFor(inputPath);
+
+        inFlight.acquire();
+        pool.start([this, inputPath, outputPath, &inFlight, &succeeded, &failed, &onFileDone]() {
+            const QString error = processFile(inputPath, outputPath);
+            if (error.isEmpty()) {
+                ++succeeded;
+            } else {
+                ++failed;
+            }
+            if (onFileDone) {
+                onFileDone(inputPath, outputPath, error);
+            }
+            inFlight.release();
+        });
+    }
+    pool.waitForDone();
+
+    BatchResult result;
+    result.succeeded = succeeded;
+    result.failed = failed;
+    result.elapsedMs = timer.elapsed();
+    return result;
+}
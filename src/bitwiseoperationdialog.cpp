@@ -24,7 +24,7 @@ BitwiseOperationDialog::BitwiseOperationDialog(QWidget *parent, const QVector<QW
     // Populate combo boxes with grayscale image viewers
     for (QWidget* widget : openedImages) {
         ImageViewer* viewer = qobject_cast<ImageViewer*>(widget);
-        if (!viewer || viewer->getOriginalImage().channels() != 1) continue;
+        if (!viewer || viewer->getSnapshot().channels() != 1) continue;
 
         QString title = viewer->windowTitle();
         imageViewerMap[title] = viewer;
@@ -147,8 +147,11 @@ void BitwiseOperationDialog::performOperation(ImageViewer* currentViewer, ImageV
         return;
     }
 
-    cv::Mat img1 = currentViewer->getOriginalImage();
-    cv::Mat img2 = secondViewer->getOriginalImage();
+    // Snapshots share the viewers' pixels; nothing below writes into them
+    const ImageSnapshot snapshot1 = currentViewer->getSnapshot();
+    const ImageSnapshot snapshot2 = secondViewer->getSnapshot();
+    const cv::Mat& img1 = snapshot1.mat();
+    cv::Mat img2 = snapshot2.mat();
 
     if (img1.empty() || img2.empty()) {
         QMessageBox::warning(this, "Error", "One or both selected images are empty.");
@@ -170,7 +173,9 @@ void BitwiseOperationDialog::performOperation(ImageViewer* currentViewer, ImageV
                                            QMessageBox::Yes | QMessageBox::No);
         if (answer == QMessageBox::Yes) {
             try {
-                cv::resize(img2, img2, img1.size(), 0, 0, cv::INTER_LINEAR);
+                cv::Mat resized;
+                cv::resize(img2, resized, img1.size(), 0, 0, cv::INTER_LINEAR);
+                img2 = resized;
             } catch (const cv::Exception& e) {
                 QMessageBox::critical(this, "Resize Error", e.what());
                 return;
@@ -183,23 +188,24 @@ void BitwiseOperationDialog::performOperation(ImageViewer* currentViewer, ImageV
     // Perform operation
     QString op = operationCombo->currentText();
     try {
-        if (op == "Add") resultImage = ImageProcessing::applyAddition(img1, img2);
-        else if (op == "Subtract") resultImage = ImageProcessing::applySubtraction(img1, img2);
+        ImageProcessing::MatResult result = ImageProcessing::Error{"Error", "Unknown operation."};
+        if (op == "Add") result = ImageProcessing::applyAddition(img1, img2);
+        else if (op == "Subtract") result = ImageProcessing::applySubtraction(img1, img2);
         else if (op == "Blend") {
             double alpha = static_cast<double>(alphaSpin->value()) / 100.0;
-            resultImage = ImageProcessing::applyBlending(img1, img2, alpha);
+            result = ImageProcessing::applyBlending(img1, img2, alpha);
         }
-        else if (op == "Bitwise AND") resultImage = ImageProcessing::applyBitwiseAnd(img1, img2);
-        else if (op == "Bitwise OR") resultImage = ImageProcessing::applyBitwiseOr(img1, img2);
-        else if (op == "Bitwise XOR") resultImage = ImageProcessing::applyBitwiseXor(img1, img2);
-        else {
-            QMessageBox::warning(this, "Error", "Unknown operation.");
+        else if (op == "Bitwise AND") result = ImageProcessing::applyBitwiseAnd(img1, img2);
+        else if (op == "Bitwise OR") result = ImageProcessing::applyBitwiseOr(img1, img2);
+        else if (op == "Bitwise XOR") result = ImageProcessing::applyBitwiseXor(img1, img2);
+
+        if (!result) {
+            resultImage.release();
+            QMessageBox::warning(this, QString::fromStdString(result.error().title),
+                                 QString::fromStdString(result.error().message));
             return;
         }
-
-        if (resultImage.empty()) {
-            QMessageBox::warning(this, "Operation Failed", "Operation did not produce a valid result.");
-        }
+        resultImage = std::move(result).value();
     } catch (const cv::Exception& e) {
         QMessageBox::critical(this, "OpenCV Error", e.what());
     } catch (...) {
@@ -8,7 +8,9 @@
 #include <QGridLayout>
 #include <QFileDialog>
 #include <QTextStream>
+#include <QScrollArea>
 #include <QVector>
+#include <cmath>
 #include <qdir.h>
 
 CustomFilterDialog::CustomFilterDialog(QWidget *parent) : PreviewDialogBase(parent) {
@@ -19,19 +21,27 @@ CustomFilterDialog::CustomFilterDialog(QWidget *parent) : PreviewDialogBase(pare
 
     // Kernel size selection
     kernelSizeBox = new QComboBox(this);
-    kernelSizeBox->addItems({"3x3", "5x5", "7x7", "9x9"});
+    // From 11x11 on, non-separable kernels are filtered through the DFT (see ImageProcessing::applyCustomFilter)
+    kernelSizeBox->addItems({"3x3", "5x5", "7x7", "9x9", "11x11", "15x15", "21x21", "25x25"});
     connect(kernelSizeBox, qOverload<int>(&QComboBox::currentIndexChanged), this, &CustomFilterDialog::updateKernelSize);
     mainLayout->addWidget(kernelSizeBox);
 
-    // Grid for kernel input
-    kernelLayout = new QGridLayout();
-    mainLayout->addLayout(kernelLayout);
+    // Grid for kernel input, scrollable: kernels past 7x7 don't fit the dialog
+    QScrollArea *kernelArea = new QScrollArea(this);
+    kernelArea->setWidgetResizable(true);
+    QWidget *kernelWidget = new QWidget(kernelArea);
+    kernelLayout = new QGridLayout(kernelWidget);
+    kernelArea->setWidget(kernelWidget);
+    mainLayout->addWidget(kernelArea);
 
     QPushButton *loadButton = new QPushButton("Load from File");
     connect(loadButton, &QPushButton::clicked, this, &CustomFilterDialog::loadKernelFromFile);
     mainLayout->addWidget(loadButton);
 
 
+    methodLabel = new QLabel("Method: shown with the preview");
+    mainLayout->addWidget(methodLabel);
+
     previewCheckBox = new QCheckBox("Preview");
     previewCheckBox->setChecked(false); // default off
     connect(previewCheckBox, &QCheckBox::checkStateChanged, this, &PreviewDialogBase::previewRequested);
@@ -63,7 +73,8 @@ void CustomFilterDialog::updateKernelSize() {
 
     int size = kernelSizeBox->currentText().split("x")[0].toInt();
     kernelInputs.clear();
-    int spinBoxSize = (size > 5) ? 75 : 85; // Increase size for better visibility
+    int spinBoxSize = (size > 9) ? 65 : (size > 5) ? 75 : 85; // Increase size for better visibility
+    const int spinBoxHeight = (size > 9) ? 30 : 45;
 
     for (int i = 0; i < size; i++) {
         QVector<QDoubleSpinBox*> row;
@@ -72,7 +83,7 @@ void CustomFilterDialog::updateKernelSize() {
             spinBox->setRange(-99.99, 99.99);
             spinBox->setDecimals(2);  // or more if needed
             spinBox->setValue(0);
-            spinBox->setFixedSize(spinBoxSize, 45);
+            spinBox->setFixedSize(spinBoxSize, spinBoxHeight);
             spinBox->setAlignment(Qt::AlignCenter); // Ensure text is centered
             connect(spinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &PreviewDialogBase::previewRequested);
             kernelLayout->addWidget(spinBox, i, j);
@@ -82,6 +93,12 @@ void CustomFilterDialog::updateKernelSize() {
     }
 }
 
+void CustomFilterDialog::setConvolutionInfo(const ImageProcessing::ConvolutionInfo& info) {
+    methodLabel->setText(QString("Method: %1, %2 ms for the last preview")
+                             .arg(ImageProcessing::convolutionMethodName(info.method))
+                             .arg(info.milliseconds, 0, 'f', 1));
+}
+
 cv::Mat CustomFilterDialog::getKernel() {
     int size = kernelSizeBox->currentText().split("x")[0].toInt();
     cv::Mat kernel(size, size, CV_32F);
@@ -118,12 +135,20 @@ void CustomFilterDialog::loadKernelFromFile() {
         }
     }
 
-    int size = kernelSizeBox->currentText().split("x")[0].toInt();
-    if (values.size() != size * size) {
-        QMessageBox::warning(this, "Size Mismatch", QString("Expected %1 values for a %2x%2 kernel, but got %3.")
-                                 .arg(size * size).arg(size).arg(values.size()));
+    // Any odd square kernel: the size is taken from the file, and added to the list if it isn't there
+    const int size = static_cast<int>(std::lround(std::sqrt(static_cast<double>(values.size()))));
+    if (size < 3 || size % 2 == 0 || values.size() != size * size) {
+        QMessageBox::warning(this, "Size Mismatch", QString("Expected an odd square kernel (9, 25, 49... values), but got %1 values.")
+                                 .arg(values.size()));
         return;
     }
+    const QString sizeText = QString("%1x%1").arg(size);
+    if (kernelSizeBox->findText(sizeText) < 0) {
+        int position = 0;
+        while (position < kernelSizeBox->count() && kernelSizeBox->itemText(position).split("x")[0].toInt() < size) ++position;
+        kernelSizeBox->insertItem(position, sizeText);
+    }
+    kernelSizeBox->setCurrentText(sizeText); // Rebuilds the grid if the size changed
 
     int index = 0;
     for (int i = 0; i < size; ++i) {
@@ -0,0 +1,113 @@
+#include "expressiondialog.h"
+#include "imageexpression.h"
+#include "imageviewer.h"
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+namespace {
+
+// A, B, ..., Z, then I27, I28, ...
+QString defaultVariableName(int index) {
+    return index < 26 ? QString(QChar('A' + index)) : QString("I%1").arg(index + 1);
+}
+
+} // namespace
+
+ExpressionDialog::ExpressionDialog(const QVector<QWidget*>& openedImages, QWidget *parent) : QDialog(parent) {
+    setWindowTitle("Image Expression");
+    setMinimumSize(450, 400);
+    auto *layout = new QVBoxLayout(this);
+
+    layout->addWidget(new QLabel("Expression, e.g. 0.3*A + 0.5*B - C & D, or mean(A, B, C):"));
+    expressionEdit = new QLineEdit(this);
+    layout->addWidget(expressionEdit);
+
+    variableTable = new QTableWidget(0, 2, this);
+    variableTable->setHorizontalHeaderLabels({"Variable", "Image"});
+    variableTable->horizontalHeader()->setStretchLastSection(true);
+    variableTable->verticalHeader()->hide();
+    for (QWidget *widget : openedImages) {
+        auto *viewer = qobject_cast<ImageViewer*>(widget);
+        if (!viewer || viewer->getSnapshot().empty()) continue;
+        const int row = variableTable->rowCount();
+        variableTable->insertRow(row);
+        variableTable->setItem(row, 0, new QTableWidgetItem(defaultVariableName(row)));
+        auto *titleItem = new QTableWidgetItem(viewer->windowTitle());
+        titleItem->setFlags(titleItem->flags() & ~Qt::ItemIsEditable);
+        variableTable->setItem(row, 1, titleItem);
+        viewers.append(viewer);
+    }
+    layout->addWidget(variableTable);
+
+    statusLabel = new QLabel(this);
+    statusLabel->setWordWrap(true);
+    layout->addWidget(statusLabel);
+
+    auto *averageButton = new QPushButton("Average All", this);
+    buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    buttonBox->addButton(averageButton, QDialogButtonBox::ActionRole);
+    layout->addWidget(buttonBox);
+
+    connect(expressionEdit, &QLineEdit::textChanged, this, &ExpressionDialog::validate);
+    connect(variableTable, &QTableWidget::itemChanged, this, &ExpressionDialog::validate);
+    connect(averageButton, &QPushButton::clicked, this, &ExpressionDialog::averageAll);
+    connect(buttonBox, &QDialogButtonBox::accepted, this, &QDialog::accept);
+    connect(buttonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    validate();
+}
+
+QString ExpressionDialog::getExpression() const {
+    return expressionEdit->text();
+}
+
+QVector<ImageViewer*> ExpressionDialog::getBoundViewers() const {
+    const auto parsed = ImageProcessing::ImageExpression::parse(getExpression().toStdString());
+    if (!parsed) return {};
+
+    QVector<ImageViewer*> bound;
+    for (const std::string &variable : parsed.value().variables()) {
+        const QString name = QString::fromStdString(variable);
+        ImageViewer *match = nullptr;
+        for (int row = 0; row < variableTable->rowCount(); ++row) {
+            if (variableTable->item(row, 0)->text().trimmed() == name) {
+                match = viewers[row];
+                break;
+            }
+        }
+        if (!match) return {};
+        bound.append(match);
+    }
+    return bound;
+}
+
+void ExpressionDialog::validate() {
+    QString status;
+    const auto parsed = ImageProcessing::ImageExpression::parse(getExpression().toStdString());
+    if (getExpression().trimmed().isEmpty()) {
+        status = "Enter an expression.";
+    } else if (!parsed) {
+        status = QString::fromStdString(parsed.error().message);
+    } else if (getBoundViewers().isEmpty()) {
+        QStringList unbound;
+        for (const std::string &variable : parsed.value().variables()) {
+            const QString name = QString::fromStdString(variable);
+            if (variableTable->findItems(name, Qt::MatchExactly).isEmpty()) unbound << name;
+        }
+        status = "No image is named " + unbound.join(", ") + ".";
+    }
+    statusLabel->setText(status.isEmpty() ? QString("Uses %1 image(s).").arg(parsed.value().variables().size()) : status);
+    buttonBox->button(QDialogButtonBox::Ok)->setEnabled(status.isEmpty());
+}
+
+void ExpressionDialog::averageAll() {
+    QStringList names;
+    for (int row = 0; row < variableTable->rowCount(); ++row) {
+        names << variableTable->item(row, 0)->text().trimmed();
+    }
+    expressionEdit->setText("mean(" + names.join(", ") + ")");
+}
@@ -45,17 +45,12 @@ void HistogramWidget::computeHistogram(const cv::Mat &grayImage) {
         return;
     }
 
-    histogramData.fill(0, 256); // Reset histogram data
-    maxHistogramValue = 0; // Reset max value
-
-    // Calculate histogram
-    for (int y = 0; y < grayImage.rows; ++y) {
-        const uchar* row_ptr = grayImage.ptr<uchar>(y);
-        for (int x = 0; x < grayImage.cols; ++x) {
-            int pixelValue = row_ptr[x];
-            histogramData[pixelValue]++;
-        }
-    }
+    setHistogram(ImageProcessing::computeGrayHistogram(grayImage));
+}
+
+// Shows precomputed counts, e.g. the ones ImageViewer caches for its current image.
+void HistogramWidget::setHistogram(const ImageProcessing::Histogram &histogram) {
+    histogramData = QVector<int>(histogram.begin(), histogram.end());
 
     // Find the maximum value in the histogram for scaling
     auto maxIt = std::max_element(histogramData.begin(), histogramData.end());
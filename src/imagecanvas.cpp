@@ -0,0 +1,160 @@
+#include "imagecanvas.h"
+#include <QPaintEvent>
+#include <QPainter>
+#include <algorithm>
+#include <cmath>
+#include <opencv2/imgproc.hpp>
+
+namespace {
+
+// Rendered tiles are about this size on screen, whatever the zoom
+constexpr int DisplayTileSize = 256;
+
+// Roughly two full-HD screens worth of rendered tiles
+constexpr int TileCacheKiB = 16 * 1024;
+
+// The mask is added at half intensity on a BGR copy of the pixels
+cv::Mat blendOverlay(const cv::Mat &pixels, const cv::Mat &mask) {
+    cv::Mat display;
+    if (pixels.channels() == 4) {
+        cv::cvtColor(pixels, display, cv::COLOR_BGRA2BGR);
+    } else if (pixels.channels() == 1) {
+        cv::cvtColor(pixels, display, cv::COLOR_GRAY2BGR);
+    } else {
+        display = pixels.clone();
+    }
+    cv::Mat maskColored;
+    cv::cvtColor(mask, maskColored, cv::COLOR_GRAY2BGR);
+    cv::addWeighted(display, 1.0, maskColored, 0.5, 0, display);
+    return display;
+}
+
+} // namespace
+
+ImageCanvas::ImageCanvas(QWidget *parent)
+    : QWidget(parent), tileCache(TileCacheKiB) {
+    // Tiles cover the whole widget, no need to erase the background first
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+bool ImageCanvas::setImage(const cv::Mat &image, double scale) {
+    if (image.empty()) {
+        clear();
+        return true;
+    }
+    if (scale <= 0 || (image.type() != CV_8UC1 && image.type() != CV_8UC3 && image.type() != CV_8UC4)) {
+        clear();
+        return false;
+    }
+
+    tileCache.clear();
+    pyramid = ImagePyramid();
+    // Upper bound keeps the per-tile conversion affordable when zoomed far out
+    const int tileSize = std::clamp(static_cast<int>(std::round(DisplayTileSize / scale)), 64, 4096);
+    tiles = TiledImage(image, tileSize);
+    displayScale = scale;
+    setFixedSize(std::max(1, static_cast<int>(std::round(image.cols * scale))),
+                 std::max(1, static_cast<int>(std::round(image.rows * scale))));
+    update();
+    return true;
+}
+
+bool ImageCanvas::setPyramid(const ImagePyramid &imagePyramid, double scale) {
+    if (imagePyramid.empty()) {
+        clear();
+        return true;
+    }
+    if (!setImage(imagePyramid.level(0), scale)) return false;
+    pyramid = imagePyramid;
+    // Tiles only read the pyramid level matching the zoom, so they can span any part of level 0
+    tiles = TiledImage(imagePyramid.level(0), std::max(64, static_cast<int>(std::round(DisplayTileSize / scale))));
+    return true;
+}
+
+void ImageCanvas::setOverlay(const cv::Mat &mask) {
+    if (overlay.empty() && mask.empty()) return;
+    overlay = mask;
+    tileCache.clear();
+    update();
+}
+
+void ImageCanvas::invalidateImageRect(const cv::Rect &imageRect) {
+    for (int index : tiles.tilesIntersecting(imageRect)) {
+        tileCache.remove(index);
+        update(targetRect(tiles.tileRect(index)));
+    }
+}
+
+void ImageCanvas::clear() {
+    tileCache.clear();
+    tiles = TiledImage();
+    pyramid = ImagePyramid();
+    setFixedSize(0, 0);
+    update();
+}
+
+// Rounds tile edges rather than sizes, so neighbouring tiles always meet.
+QRect ImageCanvas::targetRect(const cv::Rect &imageRect) const {
+    return QRect(QPoint(static_cast<int>(std::round(imageRect.x * displayScale)),
+                        static_cast<int>(std::round(imageRect.y * displayScale))),
+                 QPoint(static_cast<int>(std::round(imageRect.br().x * displayScale)) - 1,
+                        static_cast<int>(std::round(imageRect.br().y * displayScale)) - 1));
+}
+
+QPixmap ImageCanvas::renderTile(int index) const {
+    const cv::Rect source = tiles.tileRect(index);
+    const QRect target = targetRect(source);
+    if (target.isEmpty()) return QPixmap();
+    const bool withOverlay = !overlay.empty() && overlay.size() == tiles.image().size();
+
+    if (!pyramid.empty()) {
+        cv::Mat pixels = pyramid.render(displayScale, cv::Rect(target.x(), target.y(), target.width(), target.height()));
+        if (withOverlay) {
+            cv::Mat maskPixels;
+            cv::resize(overlay(source), maskPixels, pixels.size(), 0, 0, cv::INTER_AREA);
+            pixels = blendOverlay(pixels, maskPixels);
+        }
+        return QPixmap::fromImage(toQImage(pixels)); // fromImage copies before `pixels` goes away
+    }
+
+    const cv::Mat pixels = withOverlay ? blendOverlay(tiles.tile(index), overlay(source)) : tiles.tile(index);
+    const QImage tileImage = toQImage(pixels);
+    if (tileImage.size() == target.size()) return QPixmap::fromImage(tileImage);
+    return QPixmap::fromImage(tileImage.scaled(target.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+}
+
+void ImageCanvas::paintEvent(QPaintEvent *event) {
+    if (tiles.empty()) return;
+
+    // Exposed area in image coordinates, one pixel larger on each side for rounding
+    const QRect exposed = event->rect();
+    const cv::Rect region(static_cast<int>(std::floor(exposed.x() / displayScale)) - 1,
+                          static_cast<int>(std::floor(exposed.y() / displayScale)) - 1,
+                          static_cast<int>(std::ceil(exposed.width() / displayScale)) + 3,
+                          static_cast<int>(std::ceil(exposed.height() / displayScale)) + 3);
+
+    QPainter painter(this);
+    for (int index : tiles.tilesIntersecting(region)) {
+        const QPoint topLeft = targetRect(tiles.tileRect(index)).topLeft();
+        if (const QPixmap *cached = tileCache.object(index)) {
+            painter.drawPixmap(topLeft, *cached);
+            continue;
+        }
+        QPixmap rendered = renderTile(index);
+        if (rendered.isNull()) continue;
+        painter.drawPixmap(topLeft, rendered);
+        const int costKiB = std::max(1, rendered.width() * rendered.height() * 4 / 1024);
+        tileCache.insert(index, new QPixmap(std::move(rendered)), costKiB);
+    }
+}
+
+QImage ImageCanvas::toQImage(const cv::Mat &mat) {
+    if (mat.type() == CV_8UC3) {
+        return QImage(mat.data, mat.cols, mat.rows, mat.step, QImage::Format_RGB888).rgbSwapped();
+    } else if (mat.type() == CV_8UC4) {
+        return QImage(mat.data, mat.cols, mat.rows, mat.step, QImage::Format_ARGB32);
+    } else if (mat.type() == CV_8UC1) {
+        return QImage(mat.data, mat.cols, mat.rows, mat.step, QImage::Format_Grayscale8);
+    }
+    return QImage(); // Invalid image
+}
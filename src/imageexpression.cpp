@@ -0,0 +1,335 @@
+#include "imageexpression.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+
+namespace ImageProcessing {
+
+// ==========================================================================
+// Parsing: recursive descent, emitting the postfix program directly
+// ==========================================================================
+
+class ExpressionParser {
+public:
+    explicit ExpressionParser(const std::string& text) : text(text) {}
+
+    Result<ImageExpression> run() {
+        expression.source = text;
+        if (!parseLevel(0)) return Error{"Expression Error", errorMessage};
+        skipSpace();
+        if (position < text.size()) {
+            return Error{"Expression Error", unexpected()};
+        }
+        if (expression.variableNames.empty()) {
+            return Error{"Expression Error", "The expression must use at least one image."};
+        }
+        return expression;
+    }
+
+private:
+    using Op = ImageExpression::Op;
+
+    // Binary operator levels, loosest first: |  ^  &  + -  * /
+    static constexpr int UnaryLevel = 5;
+
+    static bool binaryOperator(int level, char c, Op& op, bool& bitwise) {
+        bitwise = level <= 2;
+        switch (level) {
+        case 0: op = Op::Or; return c == '|';
+        case 1: op = Op::Xor; return c == '^';
+        case 2: op = Op::And; return c == '&';
+        case 3: op = c == '+' ? Op::Add : Op::Subtract; return c == '+' || c == '-';
+        default: op = c == '*' ? Op::Multiply : Op::Divide; return c == '*' || c == '/';
+        }
+    }
+
+    bool parseLevel(int level) {
+        if (level == UnaryLevel) return parseUnary();
+        if (!parseLevel(level + 1)) return false;
+        for (;;) {
+            skipSpace();
+            Op op;
+            bool bitwise;
+            if (position >= text.size() || !binaryOperator(level, text[position], op, bitwise)) return true;
+            ++position;
+            if (!parseLevel(level + 1)) return false;
+            emit(op);
+            expression.usesBitwise |= bitwise;
+        }
+    }
+
+    bool parseUnary() {
+        skipSpace();
+        if (position < text.size() && (text[position] == '-' || text[position] == '~' || text[position] == '+')) {
+            const char sign = text[position++];
+            if (!parseUnary()) return false;
+            if (sign == '-') emit(Op::Negate);
+            if (sign == '~') {
+                emit(Op::Not);
+                expression.usesBitwise = true;
+            }
+            return true;
+        }
+        return parsePrimary();
+    }
+
+    bool parsePrimary() {
+        skipSpace();
+        if (position >= text.size()) return fail("Unexpected end of expression.");
+        const char c = text[position];
+
+        if (c == '(') {
+            ++position;
+            if (!parseLevel(0)) return false;
+            return expect(')');
+        }
+        if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+            // from_chars ignores the locale, unlike strtod
+            double value = 0.0;
+            const auto [end, error] = std::from_chars(text.data() + position, text.data() + text.size(), value);
+            if (error != std::errc()) return fail(unexpected());
+            position = end - text.data();
+            emit(Op::Constant, 0, static_cast<float>(value));
+            return true;
+        }
+        if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            const size_t start = position;
+            while (position < text.size() && (std::isalnum(static_cast<unsigned char>(text[position])) || text[position] == '_')) {
+                ++position;
+            }
+            const std::string name = text.substr(start, position - start);
+            skipSpace();
+            if (position < text.size() && text[position] == '(') {
+                ++position;
+                return parseCall(name, start);
+            }
+
+            std::vector<std::string>& names = expression.variableNames;
+            const int index = static_cast<int>(std::find(names.begin(), names.end(), name) - names.begin());
+            if (index == static_cast<int>(names.size())) names.push_back(name);
+            emit(Op::Load, index);
+            return true;
+        }
+        return fail(unexpected());
+    }
+
+    // N-ary functions are folded pairwise as the arguments are parsed, so they never need more
+    // than one extra stack slot however many arguments they take.
+    bool parseCall(const std::string& name, size_t start) {
+        Op fold;
+        if (name == "min") fold = Op::Min;
+        else if (name == "max") fold = Op::Max;
+        else if (name == "sum" || name == "mean" || name == "abs") fold = Op::Add;
+        else return fail("Unknown function '" + name + "' at position " + std::to_string(start + 1) + ".");
+
+        int arguments = 0;
+        for (;;) {
+            if (!parseLevel(0)) return false;
+            if (++arguments > 1) emit(fold);
+            skipSpace();
+            if (position >= text.size() || text[position] != ',') break;
+            ++position;
+        }
+        if (!expect(')')) return false;
+
+        if (name == "abs") {
+            if (arguments != 1) return fail("abs() takes exactly one argument.");
+            emit(Op::Abs);
+        } else if (name == "mean" && arguments > 1) {
+            emit(Op::Constant, 0, 1.0f / arguments);
+            emit(Op::Multiply);
+        }
+        return true;
+    }
+
+    void emit(Op op, int variable = 0, float value = 0.0f) {
+        expression.program.push_back({op, variable, value});
+        if (op == Op::Load || op == Op::Constant) {
+            expression.stackDepth = std::max(expression.stackDepth, ++depth);
+        } else if (op != Op::Negate && op != Op::Not && op != Op::Abs) {
+            --depth;
+        }
+    }
+
+    bool expect(char c) {
+        skipSpace();
+        if (position < text.size() && text[position] == c) {
+            ++position;
+            return true;
+        }
+        return fail(position < text.size() ? unexpected() : std::string("Missing '") + c + "' at the end.");
+    }
+
+    void skipSpace() {
+        while (position < text.size() && std::isspace(static_cast<unsigned char>(text[position]))) ++position;
+    }
+
+    std::string unexpected() const {
+        return "Unexpected '" + std::string(1, text[position]) + "' at position " + std::to_string(position + 1) + ".";
+    }
+
+    bool fail(const std::string& message) {
+        errorMessage = message;
+        return false;
+    }
+
+    const std::string& text;
+    size_t position = 0;
+    int depth = 0;
+    std::string errorMessage;
+    ImageExpression expression;
+};
+
+Result<ImageExpression> ImageExpression::parse(const std::string& text) {
+    return ExpressionParser(text).run();
+}
+
+// ==========================================================================
+// Evaluation: the program runs over bands of rows, one float buffer per stack slot
+// ==========================================================================
+
+namespace {
+
+// Floats per stack slot buffer: 64 KiB, so the buffers of a band stay in the L2 cache
+constexpr int BandFloats = 16 * 1024;
+
+// A stack slot: a band of values, or a single constant
+struct Value {
+    float* data;
+    float scalar;
+};
+
+// The loops below run over contiguous floats and vectorize; only the scalar cases differ
+template <typename F>
+void applyUnary(Value& value, size_t count, F f) {
+    if (!value.data) {
+        value.scalar = f(value.scalar);
+        return;
+    }
+    float* data = value.data;
+    for (size_t i = 0; i < count; ++i) data[i] = f(data[i]);
+}
+
+// Writes into `target`, the buffer of the left operand's slot
+template <typename F>
+void applyBinary(Value& left, const Value& right, float* target, size_t count, F f) {
+    if (!left.data && !right.data) {
+        left.scalar = f(left.scalar, right.scalar);
+    } else if (!right.data) {
+        const float b = right.scalar;
+        for (size_t i = 0; i < count; ++i) target[i] = f(left.data[i], b);
+    } else if (!left.data) {
+        const float a = left.scalar;
+        const float* b = right.data;
+        for (size_t i = 0; i < count; ++i) target[i] = f(a, b[i]);
+        left.data = target;
+    } else {
+        const float* b = right.data;
+        for (size_t i = 0; i < count; ++i) target[i] = f(left.data[i], b[i]);
+    }
+}
+
+} // namespace
+
+MatResult ImageExpression::evaluate(const std::vector<cv::Mat>& images, OperationProgress* progress) const {
+    if (images.size() != variableNames.size()) {
+        return Error{"Expression Error", "Expected " + std::to_string(variableNames.size()) + " images, got "
+                                             + std::to_string(images.size()) + "."};
+    }
+    for (size_t i = 0; i < images.size(); ++i) {
+        if (images[i].empty()) {
+            return Error{"Expression Error", "Image '" + variableNames[i] + "' is empty."};
+        }
+        if (images[i].size() != images[0].size() || images[i].type() != images[0].type()) {
+            return Error{"Expression Error", "Image '" + variableNames[i] + "' does not have the size and type of '"
+                                                 + variableNames[0] + "'."};
+        }
+    }
+    const int depth = images[0].depth();
+    if (usesBitwise && depth != CV_8U && depth != CV_16U) {
+        return Error{"Expression Error", "Bitwise operators need 8 or 16-bit unsigned images."};
+    }
+
+    // Bitwise operands are rounded and clamped to the image range first
+    const float maxValue = depth == CV_16U ? 65535.0f : 255.0f;
+    auto bits = [maxValue](float v) { return static_cast<unsigned>(std::min(std::max(v, 0.0f), maxValue) + 0.5f); };
+
+    const int rows = images[0].rows;
+    const int rowLength = images[0].cols * images[0].channels();
+    const int bandRows = std::max(1, BandFloats / rowLength);
+    const int bands = (rows + bandRows - 1) / bandRows;
+    const size_t slotFloats = static_cast<size_t>(bandRows) * rowLength;
+    cv::Mat output(images[0].size(), images[0].type());
+    std::atomic<int> bandsDone{0};
+    std::atomic<bool> cancelled{false};
+
+    cv::parallel_for_(cv::Range(0, bands), [&](const cv::Range& range) {
+        std::vector<float> buffers(static_cast<size_t>(stackDepth) * slotFloats);
+        std::vector<Value> stack(stackDepth);
+        for (int band = range.start; band < range.end; ++band) {
+            if ((progress && progress->isCancelled()) || cancelled) {
+                cancelled = true;
+                return;
+            }
+            const int firstRow = band * bandRows;
+            const int rowCount = std::min(bandRows, rows - firstRow);
+            const size_t count = static_cast<size_t>(rowCount) * rowLength;
+            auto slot = [&](int index) { return buffers.data() + index * slotFloats; };
+
+            int top = 0;
+            for (const Instruction& instruction : program) {
+                switch (instruction.op) {
+                case Op::Load: {
+                    // Each input is read once per band and converted with OpenCV's vectorized convertTo
+                    cv::Mat floats(rowCount, rowLength, CV_32F, slot(top));
+                    images[instruction.variable].rowRange(firstRow, firstRow + rowCount).reshape(1).convertTo(floats, CV_32F);
+                    stack[top] = Value{slot(top), 0.0f};
+                    ++top;
+                    break;
+                }
+                case Op::Constant:
+                    stack[top++] = Value{nullptr, instruction.value};
+                    break;
+                case Op::Negate: applyUnary(stack[top - 1], count, [](float a) { return -a; }); break;
+                case Op::Abs: applyUnary(stack[top - 1], count, [](float a) { return std::abs(a); }); break;
+                case Op::Not: applyUnary(stack[top - 1], count, [&](float a) { return static_cast<float>(bits(maxValue) - bits(a)); }); break;
+                default: {
+                    Value& left = stack[top - 2];
+                    const Value& right = stack[top - 1];
+                    float* target = slot(top - 2);
+                    switch (instruction.op) {
+                    case Op::Add: applyBinary(left, right, target, count, [](float a, float b) { return a + b; }); break;
+                    case Op::Subtract: applyBinary(left, right, target, count, [](float a, float b) { return a - b; }); break;
+                    case Op::Multiply: applyBinary(left, right, target, count, [](float a, float b) { return a * b; }); break;
+                    case Op::Divide: applyBinary(left, right, target, count, [](float a, float b) { return b != 0.0f ? a / b : 0.0f; }); break;
+                    case Op::Min: applyBinary(left, right, target, count, [](float a, float b) { return std::min(a, b); }); break;
+                    case Op::Max: applyBinary(left, right, target, count, [](float a, float b) { return std::max(a, b); }); break;
+                    case Op::And: applyBinary(left, right, target, count, [&](float a, float b) { return static_cast<float>(bits(a) & bits(b)); }); break;
+                    case Op::Or: applyBinary(left, right, target, count, [&](float a, float b) { return static_cast<float>(bits(a) | bits(b)); }); break;
+                    case Op::Xor: applyBinary(left, right, target, count, [&](float a, float b) { return static_cast<float>(bits(a) ^ bits(b)); }); break;
+                    default: break;
+                    }
+                    --top;
+                    break;
+                }
+                }
+            }
+
+            // Saturated straight into the output rows
+            cv::Mat target = output.rowRange(firstRow, firstRow + rowCount).reshape(1);
+            if (stack[0].data) {
+                cv::Mat(rowCount, rowLength, CV_32F, stack[0].data).convertTo(target, depth);
+            } else {
+                target.setTo(stack[0].scalar);
+            }
+            if (progress) progress->report(static_cast<int>(++bandsDone * 100LL / bands));
+        }
+    });
+
+    if (cancelled) return Error{"Image Expression", "Operation cancelled."};
+    return output;
+}
+
+} // namespace ImageProcessing
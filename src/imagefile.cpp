@@ -0,0 +1,248 @@
+#include "imagefile.h"
+#include "rlecodec.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QtEndian>
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+namespace ImageFile {
+
+namespace {
+
+void fail(QString* errorMessage, const QString& message) {
+    if (errorMessage) *errorMessage = message;
+}
+
+// Owns the QFile of a mapped view: cv::Mat calls deallocate() when the last Mat sharing the view goes away,
+// and deleting the file unmaps it. Never allocates; cv::Mat::create() then falls back to the default allocator.
+class MappingAllocator : public cv::MatAllocator {
+public:
+    cv::UMatData* allocate(int, const int*, int, void*, size_t*, cv::AccessFlag, cv::UMatUsageFlags) const override {
+        return nullptr;
+    }
+    bool allocate(cv::UMatData*, cv::AccessFlag, cv::UMatUsageFlags) const override { return false; }
+
+    void deallocate(cv::UMatData* u) const override {
+        if (!u) return;
+        delete static_cast<QFile*>(u->userdata);
+        delete u;
+    }
+};
+
+const MappingAllocator mappingAllocator;
+
+// A Mat over `data` (inside the mapping of `file`) that takes ownership of the file.
+cv::Mat mappedView(QFile* file, uchar* data, size_t size, int rows, int cols, int type, size_t step) {
+    cv::Mat view(rows, cols, type, data, step);
+    cv::UMatData* u = new cv::UMatData(&mappingAllocator);
+    u->data = u->origdata = data;
+    u->size = size;
+    u->userdata = file;
+    u->refcount = 1;
+    view.u = u;
+    return view;
+}
+
+// Reads the whitespace-separated header fields of a binary PNM file ("P5"/"P6", width, height, maxval).
+// `offset` is left on the first pixel byte.
+bool readPnmHeader(const uchar* data, size_t size, size_t& offset, int fields[3]) {
+    offset = 2;
+    for (int field = 0; field < 3; ++field) {
+        while (offset < size && (std::isspace(data[offset]) || data[offset] == '#')) {
+            if (data[offset] == '#') {
+                while (offset < size && data[offset] != '\n') ++offset;
+            } else {
+                ++offset;
+            }
+        }
+        long long value = 0;
+        const size_t start = offset;
+        while (offset < size && std::isdigit(data[offset]) && value <= 1 << 30) value = value * 10 + (data[offset++] - '0');
+        if (offset == start || value <= 0 || value > 1 << 30) return false;
+        fields[field] = static_cast<int>(value);
+    }
+    // Exactly one whitespace byte separates maxval from the pixels
+    if (offset >= size || !std::isspace(data[offset])) return false;
+    ++offset;
+    return true;
+}
+
+// Binary PGM/PPM with 8-bit samples: PGM is viewed in place, PPM converted from RGB in one pass.
+// Returns an empty Mat for anything else (plain-text or 16-bit files), which imdecode then handles.
+cv::Mat loadPnm(QFile*& file, uchar* data, size_t size) {
+    if (size < 3 || data[0] != 'P' || (data[1] != '5' && data[1] != '6')) return cv::Mat();
+    const int channels = data[1] == '5' ? 1 : 3;
+    size_t offset;
+    int fields[3];
+    if (!readPnmHeader(data, size, offset, fields) || fields[2] > 255) return cv::Mat();
+    const int width = fields[0], height = fields[1];
+    const size_t step = static_cast<size_t>(width) * channels;
+    if (step * height > size - offset) return cv::Mat();
+
+    if (channels == 1) {
+        cv::Mat view = mappedView(file, data + offset, size, height, width, CV_8UC1, step);
+        file = nullptr; // Now owned by the view
+        return view;
+    }
+    cv::Mat image;
+    cv::cvtColor(cv::Mat(height, width, CV_8UC3, data + offset, step), image, cv::COLOR_RGB2BGR);
+    return image;
+}
+
+// Uncompressed 24-bit BMP: top-down files are viewed in place, bottom-up ones flipped in one pass.
+// Returns an empty Mat for other variants (palettes, bit fields, RLE compression), left to imdecode.
+cv::Mat loadBmp(QFile*& file, uchar* data, size_t size) {
+    constexpr size_t InfoHeaderEnd = 14 + 40;
+    if (size < InfoHeaderEnd || data[0] != 'B' || data[1] != 'M') return cv::Mat();
+    const quint32 pixelOffset = qFromLittleEndian<quint32>(data + 10);
+    const quint32 headerSize = qFromLittleEndian<quint32>(data + 14);
+    const qint32 width = qFromLittleEndian<qint32>(data + 18);
+    const qint32 height = qFromLittleEndian<qint32>(data + 22);
+    const quint16 bitsPerPixel = qFromLittleEndian<quint16>(data + 28);
+    const quint32 compression = qFromLittleEndian<quint32>(data + 30);
+    if (headerSize < 40 || bitsPerPixel != 24 || compression != 0 || width <= 0 || height == 0
+        || height == std::numeric_limits<qint32>::min() || width > (1 << 28)) {
+        return cv::Mat();
+    }
+
+    const int rows = height < 0 ? -height : height;
+    const size_t step = (static_cast<size_t>(width) * 3 + 3) & ~size_t(3); // Rows are padded to 4 bytes
+    if (pixelOffset < InfoHeaderEnd || pixelOffset > size || step * rows > size - pixelOffset) return cv::Mat();
+
+    if (height < 0) {
+        cv::Mat view = mappedView(file, data + pixelOffset, size, rows, width, CV_8UC3, step);
+        file = nullptr;
+        return view;
+    }
+    cv::Mat image;
+    cv::flip(cv::Mat(rows, width, CV_8UC3, data + pixelOffset, step), image, 0);
+    return image;
+}
+
+bool isRle(const QString& filePath) {
+    return QFileInfo(filePath).suffix().compare("rle", Qt::CaseInsensitive) == 0;
+}
+
+// The bytes of a file: a private mapping when possible (views of it stay writable without ever
+// touching the file), otherwise a copy read into memory.
+class FileBytes {
+public:
+    FileBytes() = default;
+    FileBytes(const FileBytes&) = delete;
+    FileBytes& operator=(const FileBytes&) = delete;
+    ~FileBytes() { delete file; } // Unmaps, unless a view has taken the file over
+
+    bool open(const QString& filePath, QString* errorMessage) {
+        file = new QFile(filePath);
+        if (!file->open(QIODevice::ReadOnly)) {
+            fail(errorMessage, "cannot open: " + file->errorString());
+            return false;
+        }
+        const qint64 fileSize = file->size();
+        if (fileSize > std::numeric_limits<int>::max()) {
+            fail(errorMessage, "file is too large");
+            return false;
+        }
+        data = fileSize > 0 ? file->map(0, fileSize, QFileDevice::MapPrivateOption) : nullptr;
+        if (data) {
+            isMapped = true;
+        } else {
+            copy = file->readAll();
+            data = reinterpret_cast<uchar*>(copy.data());
+        }
+        size = static_cast<size_t>(isMapped ? fileSize : copy.size());
+        return true;
+    }
+
+    QFile* file = nullptr; // Set to null by a view that takes it over
+    uchar* data = nullptr;
+    size_t size = 0;
+    bool isMapped = false;
+
+private:
+    QByteArray copy;
+};
+
+cv::Mat decode(const uchar* data, size_t size, bool rle, QString* errorMessage, int flags = cv::IMREAD_UNCHANGED) {
+    if (rle) {
+        QString error;
+        cv::Mat image = RleCodec::decode(data, size, &error);
+        if (image.empty()) fail(errorMessage, "cannot decode RLE image: " + error);
+        return image;
+    }
+    // imdecode reads the encoded bytes in place; only the decoded image is allocated
+    const cv::Mat encoded(1, static_cast<int>(size), CV_8UC1, const_cast<uchar*>(data));
+    cv::Mat image;
+    try {
+        image = cv::imdecode(encoded, flags);
+    } catch (const cv::Exception& e) {
+        fail(errorMessage, QString::fromStdString(e.what()));
+        return cv::Mat();
+    }
+    if (image.empty()) fail(errorMessage, "cannot decode image");
+    return image;
+}
+
+} // namespace
+
+cv::Mat loadView(const QString& filePath, QString* errorMessage) {
+    FileBytes bytes;
+    if (!bytes.open(filePath, errorMessage)) return cv::Mat();
+    const bool rle = isRle(filePath);
+
+    cv::Mat image;
+    if (bytes.isMapped && !rle) {
+        // On success the view functions take over the file and clear it
+        image = loadPnm(bytes.file, bytes.data, bytes.size);
+        if (image.empty()) image = loadBmp(bytes.file, bytes.data, bytes.size);
+    }
+    if (image.empty()) image = decode(bytes.data, bytes.size, rle, errorMessage);
+    return image;
+}
+
+cv::Mat load(const QString& filePath, QString* errorMessage) {
+    cv::Mat image = loadView(filePath, errorMessage);
+    // Copied straight from the mapping, which is released as soon as the view goes out of scope
+    if (image.u && image.u->currAllocator == &mappingAllocator) image = image.clone();
+    return image;
+}
+
+cv::Mat loadThumbnail(const QString& filePath, int maxSide, QString* errorMessage) {
+    FileBytes bytes;
+    if (!bytes.open(filePath, errorMessage)) return cv::Mat();
+
+    cv::Mat image;
+    if (isRle(filePath)) {
+        image = decode(bytes.data, bytes.size, true, errorMessage);
+    } else {
+        // JPEG decodes at 1/8 scale directly, at a fraction of the full cost; other formats are reduced after decoding
+        image = decode(bytes.data, bytes.size, false, errorMessage, cv::IMREAD_REDUCED_COLOR_8);
+        const int reducedSide = std::max(image.cols, image.rows);
+        if (!image.empty() && reducedSide < maxSide) {
+            // Small image: decode again at the coarsest reduction still covering the thumbnail
+            const int fullSide = reducedSide * 8;
+            const int flags = fullSide >= maxSide * 4   ? cv::IMREAD_REDUCED_COLOR_4
+                              : fullSide >= maxSide * 2 ? cv::IMREAD_REDUCED_COLOR_2
+                                                        : cv::IMREAD_COLOR;
+            image = decode(bytes.data, bytes.size, false, errorMessage, flags);
+        }
+    }
+    if (image.empty()) return image;
+
+    if (image.channels() == 1) {
+        cv::cvtColor(image, image, cv::COLOR_GRAY2BGR);
+    } else if (image.channels() == 4) {
+        cv::cvtColor(image, image, cv::COLOR_BGRA2BGR);
+    }
+    const double scale = static_cast<double>(maxSide) / std::max(image.cols, image.rows);
+    if (scale < 1.0) {
+        cv::resize(image, image, cv::Size(), scale, scale, cv::INTER_AREA);
+    }
+    return image;
+}
+
+} // namespace ImageFile
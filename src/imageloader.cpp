@@ -0,0 +1,92 @@
+#include "imageloader.h"
+#include "imagecanvas.h"
+#include "imagefile.h"
+#include <QFileInfo>
+#include <QThread>
+#include <algorithm>
+
+namespace {
+
+// Full decodes start before any queued thumbnail
+constexpr int ImagePriority = 1;
+constexpr int ThumbnailPriority = 0;
+
+constexpr qsizetype DefaultCacheKiB = 512 * 1024;
+
+qsizetype costKiB(const cv::Mat &image) {
+    return std::max<qsizetype>(1, static_cast<qsizetype>(image.total() * image.elemSize() / 1024));
+}
+
+} // namespace
+
+ImageLoader::ImageLoader(QObject *parent) : QObject(parent), cache(DefaultCacheKiB) {
+    // Bounded: at most one decode per core is in flight, however many files are queued
+    pool.setMaxThreadCount(QThread::idealThreadCount());
+}
+
+ImageLoader::~ImageLoader() {
+    // Running tasks post back to `this`, so they must be done before it goes away
+    pool.clear();
+    pool.waitForDone();
+}
+
+void ImageLoader::requestThumbnail(const QString &filePath) {
+    pool.start([this, filePath]() {
+        QString error;
+        const cv::Mat pixels = ImageFile::loadThumbnail(filePath, ThumbnailSize, &error);
+        // Deep copy: the QImage outlives `pixels`
+        const QImage thumbnail = pixels.empty() ? QImage() : ImageCanvas::toQImage(pixels).copy();
+        QMetaObject::invokeMethod(this, [this, filePath, thumbnail, error]() {
+            if (thumbnail.isNull()) {
+                emit thumbnailFailed(filePath, error);
+            } else {
+                emit thumbnailReady(filePath, thumbnail);
+            }
+        }, Qt::QueuedConnection);
+    }, ThumbnailPriority);
+}
+
+void ImageLoader::requestImage(const QString &filePath) {
+    const QFileInfo info(filePath);
+    const QString key = info.canonicalFilePath();
+    if (const CachedImage *cached = cache.object(key)) {
+        if (cached->modified == info.lastModified() && cached->fileSize == info.size()) {
+            QMetaObject::invokeMethod(this, [this, filePath, image = cached->image]() {
+                emit imageReady(filePath, image);
+            }, Qt::QueuedConnection);
+            return;
+        }
+        cache.remove(key); // The file changed since
+    }
+
+    if (loadingImages.contains(filePath)) return;
+    loadingImages.insert(filePath);
+    pool.start([this, filePath, key]() {
+        // Stat before decoding: a file rewritten meanwhile then fails the check on the next open
+        const QFileInfo before(filePath);
+        QString error;
+        const cv::Mat image = ImageFile::load(filePath, &error);
+        QMetaObject::invokeMethod(this, [this, filePath, key, image, error,
+                                         modified = before.lastModified(), fileSize = before.size()]() {
+            loadingImages.remove(filePath);
+            if (image.empty()) {
+                emit imageFailed(filePath, error);
+                return;
+            }
+            if (!key.isEmpty()) {
+                cache.insert(key, new CachedImage{image, modified, fileSize}, costKiB(image));
+            }
+            emit imageReady(filePath, image);
+        }, Qt::QueuedConnection);
+    }, ImagePriority);
+}
+
+void ImageLoader::setCacheLimit(size_t bytes) {
+    cache.setMaxCost(static_cast<qsizetype>(bytes / 1024));
+}
+
+void ImageLoader::cancelPending() {
+    pool.clear();
+    // Dropped full decodes will never report back; running ones still do and remove themselves again
+    loadingImages.clear();
+}
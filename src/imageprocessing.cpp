@@ -1,30 +1,317 @@
 #include "imageprocessing.h"
+#include "tiledimage.h"
 #include <vector>
 #include <cmath>
-#include <QMessageBox>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <mutex>
+#include <optional>
 #include <algorithm> // For std::find_if, std::max_element
 
 namespace ImageProcessing {
 
+namespace {
+
+// Helpers for the optional OperationProgress of long-running operations
+bool isCancelled(const OperationProgress* progress) {
+    return progress && progress->isCancelled();
+}
+
+void reportProgress(OperationProgress* progress, int percent) {
+    if (progress) progress->report(percent);
+}
+
+// Flags raised by analyzeContent's scan: once all are raised, the rest of the image can't change the answer
+enum ContentFlag : unsigned {
+    ChannelsDiffer = 0x1,
+    NonBinary = 0x2,
+    AlphaUsed = 0x4
+};
+
+// Counts one row of 8-bit pixels into `channels` interleaved histograms. Consecutive pixels go to
+// four different sub-histograms, so runs of equal values don't wait on each other's increments.
+void countRow(const uchar* row, int width, int channels, int* subHistograms) {
+    const int rowLength = width * channels;
+    if (channels == 1) {
+        int x = 0;
+        for (; x + 4 <= rowLength; x += 4) {
+            ++subHistograms[row[x]];
+            ++subHistograms[256 + row[x + 1]];
+            ++subHistograms[512 + row[x + 2]];
+            ++subHistograms[768 + row[x + 3]];
+        }
+        for (; x < rowLength; ++x) ++subHistograms[row[x]];
+        return;
+    }
+    for (int x = 0, pixel = 0; x < rowLength; x += channels, ++pixel) {
+        int* base = subHistograms + (pixel & 3) * 256 * channels;
+        for (int c = 0; c < channels; ++c) ++base[c * 256 + row[x + c]];
+    }
+}
+
+// Runs countRow over row stripes in parallel; `convertRows` may turn a block of rows into the
+// 8-bit single row layout to count (e.g. to grayscale), reusing one buffer per stripe.
+std::vector<Histogram> countHistograms(const cv::Mat& image, int channels,
+                                       const std::function<cv::Mat(const cv::Mat& rows, cv::Mat& buffer)>& convertRows) {
+    constexpr int SubHistograms = 4;
+    constexpr int BlockRows = 16;
+    const int stripes = std::max(1, std::min(image.rows, cv::getNumThreads() * 4));
+    std::vector<std::vector<int>> partial(stripes);
+
+    cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
+        for (int stripe = range.start; stripe < range.end; ++stripe) {
+            std::vector<int>& counts = partial[stripe];
+            counts.assign(SubHistograms * channels * 256, 0);
+            const int firstRow = static_cast<int>(static_cast<int64_t>(image.rows) * stripe / stripes);
+            const int endRow = static_cast<int>(static_cast<int64_t>(image.rows) * (stripe + 1) / stripes);
+            cv::Mat buffer;
+            for (int y = firstRow; y < endRow; y += BlockRows) {
+                const cv::Mat block = image.rowRange(y, std::min(endRow, y + BlockRows));
+                const cv::Mat pixels = convertRows ? convertRows(block, buffer) : block;
+                for (int row = 0; row < pixels.rows; ++row) {
+                    countRow(pixels.ptr<uchar>(row), pixels.cols, channels, counts.data());
+                }
+            }
+        }
+    });
+
+    std::vector<Histogram> histograms(channels);
+    for (Histogram& histogram : histograms) histogram.fill(0);
+    for (const std::vector<int>& counts : partial) {
+        for (int sub = 0; sub < SubHistograms; ++sub) {
+            for (int c = 0; c < channels; ++c) {
+                const int* source = counts.data() + (sub * channels + c) * 256;
+                for (int value = 0; value < 256; ++value) histograms[c][value] += source[value];
+            }
+        }
+    }
+    return histograms;
+}
+
+// Adds or subtracts one histogram to another; plain loops over contiguous counts vectorize well
+template <typename Count>
+void addHistogram(Count* target, const Count* source, int bins) {
+    for (int i = 0; i < bins; ++i) target[i] += source[i];
+}
+
+template <typename Count>
+void subtractHistogram(Count* target, const Count* source, int bins) {
+    for (int i = 0; i < bins; ++i) target[i] -= source[i];
+}
+
+// Median filter of Perreault & Hebert, "Median Filtering in Constant Time" (2007). Each column
+// keeps a histogram of the `diameter` pixels above and below the current row, moved down one row
+// at a time; the window histogram is then slid along the row by adding the column that enters and
+// subtracting the one that leaves. Both histograms also keep 16 coarse bins, so finding the median
+// takes at most 16 + 16 steps. The work per pixel doesn't depend on the kernel size.
+// `padded` holds the image with `radius` extra pixels on each side; the result is the inner part.
+template <typename Count>
+cv::Mat constantTimeMedian(const cv::Mat& padded, int radius) {
+    const int diameter = 2 * radius + 1;
+    const int half = diameter * diameter / 2; // The median is the first value with more than `half` samples up to it
+    cv::Mat filtered(padded.rows - 2 * radius, padded.cols - 2 * radius, CV_8UC1);
+
+    std::vector<Count> columnFine(static_cast<size_t>(padded.cols) * 256, 0);
+    std::vector<Count> columnCoarse(static_cast<size_t>(padded.cols) * 16, 0);
+    auto updateColumns = [&](int row, int delta) {
+        const uchar* pixels = padded.ptr<uchar>(row);
+        for (int x = 0; x < padded.cols; ++x) {
+            columnFine[x * 256 + pixels[x]] += delta;
+            columnCoarse[x * 16 + (pixels[x] >> 4)] += delta;
+        }
+    };
+    for (int row = 0; row < diameter - 1; ++row) updateColumns(row, 1);
+
+    std::array<Count, 256> fine;
+    std::array<Count, 16> coarse;
+    for (int y = 0; y < filtered.rows; ++y) {
+        updateColumns(y + diameter - 1, 1); // Columns now cover rows [y, y + diameter)
+
+        fine.fill(0);
+        coarse.fill(0);
+        for (int x = 0; x < diameter; ++x) {
+            addHistogram(fine.data(), &columnFine[x * 256], 256);
+            addHistogram(coarse.data(), &columnCoarse[x * 16], 16);
+        }
+
+        uchar* output = filtered.ptr<uchar>(y);
+        for (int x = 0; x < filtered.cols; ++x) {
+            if (x > 0) {
+                addHistogram(fine.data(), &columnFine[(x + diameter - 1) * 256], 256);
+                addHistogram(coarse.data(), &columnCoarse[(x + diameter - 1) * 16], 16);
+                subtractHistogram(fine.data(), &columnFine[(x - 1) * 256], 256);
+                subtractHistogram(coarse.data(), &columnCoarse[(x - 1) * 16], 16);
+            }
+
+            int count = 0;
+            int bin = 0;
+            while (count + coarse[bin] <= half) count += coarse[bin++];
+            int value = bin * 16;
+            while (count + fine[value] <= half) count += fine[value++];
+            output[x] = static_cast<uchar>(value);
+        }
+
+        updateColumns(y, -1);
+    }
+    return filtered;
+}
+
+// cv::LUT is vectorized; rows are split over threads and written straight into the output
+cv::Mat applyLookupTable(const cv::Mat& inputImage, const cv::Mat& lookupTable) {
+    cv::Mat outputImage(inputImage.size(), inputImage.type());
+    cv::parallel_for_(cv::Range(0, inputImage.rows), [&](const cv::Range& rows) {
+        cv::Mat outputRows = outputImage.rowRange(rows.start, rows.end);
+        cv::LUT(inputImage.rowRange(rows.start, rows.end), lookupTable, outputRows);
+    });
+    return outputImage;
+}
+
+// Non-separable kernels with at least this many taps are filtered through the DFT. Direct filtering
+// costs one multiply-add per tap and pixel, the transforms a few dozen operations per pixel whatever
+// the kernel; they break even around 11x11 (filter2D's own DFT switch is close, at 130 taps).
+constexpr int FrequencyMinTaps = 11 * 11;
+
+// Splits a rank-1 kernel into the column and row vectors whose product it is. The SVD gives
+// kernel = sum of w[i] * u_i * v_i^T; with every w[i] past the first negligible, one term remains.
+bool separateKernel(const cv::Mat& kernel, cv::Mat& columnKernel, cv::Mat& rowKernel) {
+    cv::Mat kernel64;
+    kernel.convertTo(kernel64, CV_64F);
+    const cv::SVD svd(kernel64);
+    const double largest = svd.w.at<double>(0);
+    if (largest <= 0) return false;
+    for (int i = 1; i < svd.w.rows; ++i) {
+        if (svd.w.at<double>(i) > 1e-6 * largest) return false;
+    }
+    const double scale = std::sqrt(largest);
+    cv::Mat(svd.u.col(0) * scale).convertTo(columnKernel, CV_32F);
+    cv::Mat(svd.vt.row(0) * scale).convertTo(rowKernel, CV_32F);
+    return true;
+}
+
+// Correlates a padded tile with `kernel` (as filter2D does) by multiplying spectra, and returns
+// only the pixels `halo` away from the padded edges. The transform covers the whole padded tile and
+// only outputs whose window lies inside it are kept, so the circular convolution never wraps.
+cv::Mat correlateInFrequency(const cv::Mat& padded, const cv::Mat& kernel, int halo) {
+    const cv::Size dftSize(cv::getOptimalDFTSize(padded.cols), cv::getOptimalDFTSize(padded.rows));
+    const cv::Rect valid(halo - kernel.cols / 2, halo - kernel.rows / 2, padded.cols - 2 * halo, padded.rows - 2 * halo);
+
+    cv::Mat kernelSpectrum = cv::Mat::zeros(dftSize, CV_32F);
+    kernel.copyTo(kernelSpectrum(cv::Rect(0, 0, kernel.cols, kernel.rows)));
+    cv::dft(kernelSpectrum, kernelSpectrum, 0, kernel.rows);
+
+    std::vector<cv::Mat> planes;
+    cv::split(padded, planes);
+    for (cv::Mat& plane : planes) {
+        cv::Mat signal = cv::Mat::zeros(dftSize, CV_32F);
+        plane.convertTo(signal(cv::Rect(0, 0, plane.cols, plane.rows)), CV_32F);
+        cv::dft(signal, signal, 0, plane.rows);
+        cv::mulSpectrums(signal, kernelSpectrum, signal, 0, true); // Conjugate: correlation, not convolution
+        cv::dft(signal, signal, cv::DFT_INVERSE | cv::DFT_SCALE | cv::DFT_REAL_OUTPUT, valid.br().y);
+        signal(valid).convertTo(plane, padded.depth()); // Rounds and saturates like filter2D
+    }
+    cv::Mat filtered;
+    cv::merge(planes, filtered);
+    return filtered;
+}
+
+// Branch-free per row so the compiler can vectorize it; uchar(v + 1) & 0xFE is zero only for 0 and 255
+template <int CN>
+unsigned scanContentRow(const uchar* row, int width) {
+    uchar differs = 0, nonBinary = 0, alpha = 0;
+    for (int x = 0; x < width; ++x) {
+        const uchar* pixel = row + x * CN;
+        nonBinary |= static_cast<uchar>(pixel[0] + 1) & 0xFE;
+        if constexpr (CN >= 3) differs |= (pixel[0] ^ pixel[1]) | (pixel[0] ^ pixel[2]);
+        if constexpr (CN == 4) alpha |= pixel[3];
+    }
+    return (differs ? ChannelsDiffer : 0u) | (nonBinary ? NonBinary : 0u) | (alpha ? AlphaUsed : 0u);
+}
+
+} // namespace
+
+// ==========================================================================
+// Image Processing - Tiled Execution
+// ==========================================================================
+
+MatResult applyTiled(const cv::Mat& inputImage, int halo, int borderType, const TileFilter& filter,
+                     OperationProgress* progress, int tileSize) {
+    if (inputImage.empty()) {
+        return Error{"Tiled Operation Error", "Input image is empty."};
+    }
+    const TiledImage tiles(inputImage, tileSize);
+    cv::Mat output;
+    std::mutex failureMutex;
+    std::optional<Error> failure;
+    std::atomic<bool> failed{false};
+    std::atomic<int> tilesDone{0};
+
+    auto fail = [&](Error error) {
+        std::lock_guard<std::mutex> lock(failureMutex);
+        if (!failure) failure = std::move(error);
+        failed = true;
+    };
+
+    auto runTile = [&](int index) {
+        if (isCancelled(progress)) {
+            fail(Error{"Tiled Operation", "Operation cancelled."});
+            return;
+        }
+        const cv::Rect rect = tiles.tileRect(index);
+        MatResult result = filter(tiles.paddedTile(index, halo, borderType));
+        if (!result) {
+            fail(result.error());
+            return;
+        }
+
+        cv::Mat tileResult = result.value();
+        if (tileResult.size() == cv::Size(rect.width + 2 * halo, rect.height + 2 * halo)) {
+            tileResult = tileResult(cv::Rect(halo, halo, rect.width, rect.height));
+        } else if (tileResult.size() != rect.size()) {
+            fail(Error{"Tiled Operation Error", "Tile result has an unexpected size."});
+            return;
+        }
+        if (output.empty()) {
+            output.create(inputImage.size(), tileResult.type()); // First tile runs alone, before the others
+        } else if (tileResult.type() != output.type()) {
+            fail(Error{"Tiled Operation Error", "Tile results have different types."});
+            return;
+        }
+        tileResult.copyTo(output(rect));
+        reportProgress(progress, ++tilesDone * 100 / tiles.tileCount());
+    };
+
+    runTile(0);
+    if (!failed && tiles.tileCount() > 1) {
+        cv::parallel_for_(cv::Range(1, tiles.tileCount()), [&](const cv::Range& range) {
+            for (int index = range.start; index < range.end && !failed; ++index) {
+                runTile(index);
+            }
+        });
+    }
+
+    if (failure) return *failure;
+    return output;
+}
+
 // ==========================================================================
 // Group 5: Image Processing - Core Operations
 // ==========================================================================
 
-cv::Mat binarise(const cv::Mat& inputImage, double thresholdValue, double maxValue) {
+MatResult binarise(const cv::Mat& inputImage, double thresholdValue, double maxValue) {
     cv::Mat outputImage;
     if (inputImage.empty() || inputImage.channels() != 1) {
-        QMessageBox::warning(nullptr, "Make Binary Error", "Input image is empty or not grayscale.");
-        return outputImage; // Return empty if not grayscale
+        return Error{"Make Binary Error", "Input image is empty or not grayscale."};
     }
     cv::threshold(inputImage, outputImage, thresholdValue, maxValue, cv::THRESH_BINARY);
     return outputImage;
 }
 
-cv::Mat convertToGrayscale(const cv::Mat& inputImage) {
+MatResult convertToGrayscale(const cv::Mat& inputImage) {
     cv::Mat outputImage;
     if (inputImage.empty()) {
-        QMessageBox::warning(nullptr, "Convert To Grayscale Error", "Input image is empty.");
-        return outputImage;
+        return Error{"Convert To Grayscale Error", "Input image is empty."};
     }
     if (inputImage.channels() == 3) {
         cv::cvtColor(inputImage, outputImage, cv::COLOR_BGR2GRAY);
@@ -37,11 +324,50 @@ cv::Mat convertToGrayscale(const cv::Mat& inputImage) {
     return outputImage;
 }
 
-cv::Mat removeAlphaChannel(const cv::Mat& inputImage) {
+ImageContent analyzeContent(const cv::Mat& inputImage) {
+    ImageContent content;
+    const int channels = inputImage.channels();
+    if (inputImage.empty() || (channels != 1 && channels != 3 && channels != 4)) return content;
+
+    unsigned flags = 0;
+    if (inputImage.depth() == CV_8U) {
+        const unsigned allFlags = NonBinary | (channels >= 3 ? ChannelsDiffer : 0u) | (channels == 4 ? AlphaUsed : 0u);
+        std::atomic<unsigned> found{0};
+        cv::parallel_for_(cv::Range(0, inputImage.rows), [&](const cv::Range& range) {
+            unsigned local = 0;
+            for (int y = range.start; y < range.end; ++y) {
+                if ((found.load(std::memory_order_relaxed) | local) == allFlags) break;
+                const uchar* row = inputImage.ptr<uchar>(y);
+                switch (channels) {
+                case 1: local |= scanContentRow<1>(row, inputImage.cols); break;
+                case 3: local |= scanContentRow<3>(row, inputImage.cols); break;
+                default: local |= scanContentRow<4>(row, inputImage.cols); break;
+                }
+            }
+            found.fetch_or(local, std::memory_order_relaxed);
+        });
+        flags = found.load();
+    } else {
+        // Other depths are rare here, plain OpenCV calls are enough
+        std::vector<cv::Mat> planes;
+        cv::split(inputImage, planes);
+        if (cv::countNonZero((planes[0] != 0) & (planes[0] != 255)) > 0) flags |= NonBinary;
+        if (channels >= 3 && (cv::countNonZero(planes[0] != planes[1]) > 0 || cv::countNonZero(planes[0] != planes[2]) > 0)) {
+            flags |= ChannelsDiffer;
+        }
+        if (channels == 4 && cv::countNonZero(planes[3]) > 0) flags |= AlphaUsed;
+    }
+
+    content.alphaUnused = channels == 4 && !(flags & AlphaUsed);
+    content.channelsEqual = channels >= 3 && !(flags & ChannelsDiffer);
+    content.binary = !(flags & NonBinary);
+    return content;
+}
+
+MatResult removeAlphaChannel(const cv::Mat& inputImage) {
     cv::Mat outputImage;
     if (inputImage.empty()) {
-        QMessageBox::warning(nullptr, "Remove alpha channel Error", "Input image is empty.");
-        return outputImage;
+        return Error{"Remove alpha channel Error", "Input image is empty."};
     }
     if (inputImage.channels() == 4) {
         cv::cvtColor(inputImage, outputImage, cv::COLOR_BGRA2BGR);
@@ -51,10 +377,9 @@ cv::Mat removeAlphaChannel(const cv::Mat& inputImage) {
     return outputImage;
 }
 
-cv::Mat convertToColor(const cv::Mat &input) {
+MatResult convertToColor(const cv::Mat &input) {
     if (input.empty()) {
-        QMessageBox::warning(nullptr, "Convert To Color Error", "Input image is empty.");
-        return cv::Mat();
+        return Error{"Convert To Color Error", "Input image is empty."};
     }
     cv::Mat output;
     if (input.channels() == 1) {
@@ -64,9 +389,7 @@ cv::Mat convertToColor(const cv::Mat &input) {
     } else if (input.channels() == 3){
         output = input.clone(); // Already color
     } else {
-        qWarning("convertToColor: Unsupported channel count %d", input.channels());
-        // Return a black image of same size? Or empty?
-        output = cv::Mat::zeros(input.size(), CV_8UC3);
+        return Error{"Convert To Color Error", "Unsupported channel count."};
     }
     return output;
 }
@@ -104,124 +427,226 @@ std::vector<cv::Mat> convertToLab(const cv::Mat& inputImage) {
 // Group 6: Image Processing - Point Operations
 // ==========================================================================
 
-cv::Mat applyNegation(const cv::Mat& inputImage) {
-    if (inputImage.empty()) {
-        QMessageBox::warning(nullptr, "Negation Error", "Input image is empty.");
-        return cv::Mat();
+PointTable identityTable() {
+    PointTable table;
+    for (int i = 0; i < 256; ++i) table[i] = static_cast<uchar>(i);
+    return table;
+}
+
+PointTable negationTable() {
+    PointTable table;
+    for (int i = 0; i < 256; ++i) table[i] = static_cast<uchar>(255 - i);
+    return table;
+}
+
+TableResult rangeStretchingTable(int p1, int p2, int q3, int q4) {
+    if (p1 >= p2 || q3 >= q4) {
+        return Error{"Range Stretching Error", "Invalid params were given."};
+    }
+    PointTable table = identityTable(); // Values outside [p1, p2] remain unchanged
+    const float scale = static_cast<float>(q4 - q3) / (p2 - p1);
+    for (int i = std::max(p1, 0); i <= std::min(p2, 255); ++i) {
+        table[i] = cv::saturate_cast<uchar>(static_cast<int>((i - p1) * scale + q3));
     }
-    return cv::Scalar::all(255) - inputImage;
+    return table;
 }
 
-cv::Mat applyRangeStretching(const cv::Mat& inputImage, int p1, int p2, int q3, int q4) {
-    if (inputImage.empty() || inputImage.channels() != 1) {
-        QMessageBox::warning(nullptr, "Range Stretching Error", "Input image is empty or not grayscale.");
-        return inputImage.clone(); // Return copy if invalid input
+TableResult posterizationTable(int levels) {
+    if (levels < 2 || levels > 256) {
+        return Error{"Posterization Error", "The number of levels must be between 2 and 256."};
     }
-    if (p1 >= p2 || q3 >= q4) {
-        QMessageBox::warning(nullptr, "Range Stretching Error", "Invalid params were given.");
-        // Consider logging a warning or throwing an exception for invalid params
-        return inputImage.clone();
-    }
-
-    cv::Mat stretchedImage = inputImage.clone();
-    float scale = static_cast<float>(q4 - q3) / (p2 - p1);
-
-    for (int y = 0; y < stretchedImage.rows; y++) {
-        uchar* rowPtr = stretchedImage.ptr<uchar>(y);
-        for (int x = 0; x < stretchedImage.cols; x++) {
-            int pixel = rowPtr[x];
-            // Apply stretching only if the pixel is in range [p1, p2]
-            if (pixel >= p1 && pixel <= p2) {
-                // Apply linear transformation
-                pixel = static_cast<int>((pixel - p1) * scale + q3);
-                // Clamp result to [0, 255] just in case, although logic should prevent overflow if q3/q4 are valid
-                rowPtr[x] = cv::saturate_cast<uchar>(pixel);
-            }
-            // Pixels outside [p1, p2] remain unchanged
+    PointTable table;
+    const double step = 255.0 / (levels - 1);
+    for (int i = 0; i < 256; ++i) {
+        table[i] = cv::saturate_cast<uchar>(std::round(i / step) * step);
+    }
+    return table;
+}
+
+PointTable thresholdTable(double thresholdValue, double maxValue) {
+    // Same rule as cv::threshold with THRESH_BINARY on 8-bit images
+    const int threshold = cvFloor(thresholdValue);
+    const uchar high = cv::saturate_cast<uchar>(maxValue);
+    PointTable table;
+    for (int i = 0; i < 256; ++i) table[i] = i > threshold ? high : 0;
+    return table;
+}
+
+TableResult gammaTable(double gamma) {
+    if (!(gamma > 0.0)) {
+        return Error{"Gamma Correction Error", "Gamma must be greater than 0."};
+    }
+    PointTable table;
+    for (int i = 0; i < 256; ++i) {
+        table[i] = cv::saturate_cast<uchar>(255.0 * std::pow(i / 255.0, gamma));
+    }
+    return table;
+}
+
+PointTable equalizationTable(const Histogram& histogram) {
+    // Cumulative distribution, then the first non-zero value of it
+    std::array<int, 256> cdf;
+    cdf[0] = histogram[0];
+    for (int i = 1; i < 256; i++) {
+        cdf[i] = cdf[i - 1] + histogram[i];
+    }
+    const int total = cdf[255];
+    int minCDF = 0;
+    for (int val : cdf) {
+        if (val > 0) {
+            minCDF = val;
+            break;
         }
     }
-    return stretchedImage;
+    if (total == minCDF) return identityTable(); // All pixels have the same value, avoid division by zero
+
+    PointTable table;
+    const float scale = 255.0f / (total - minCDF);
+    for (int i = 0; i < 256; i++) {
+        // cdf[i] is below minCDF only before the first value present in the image
+        table[i] = cdf[i] < minCDF ? 0 : cv::saturate_cast<uchar>((cdf[i] - minCDF) * scale);
+    }
+    return table;
+}
+
+PointTable histogramStretchTable(const Histogram& histogram) {
+    int minValue = 0;
+    while (minValue < 255 && histogram[minValue] == 0) ++minValue;
+    int maxValue = 255;
+    while (maxValue > minValue && histogram[maxValue] == 0) --maxValue;
+    if (maxValue == minValue) return identityTable(); // Uniform image
+
+    // Computed by convertTo itself, with the same factors, so the result matches stretchHistogram() exactly
+    PointTable identity = identityTable();
+    PointTable table;
+    const cv::Mat ramp(1, 256, CV_8U, identity.data());
+    cv::Mat stretched(1, 256, CV_8U, table.data());
+    ramp.convertTo(stretched, CV_8U, 255.0 / (maxValue - minValue), -minValue * 255.0 / (maxValue - minValue));
+    return table;
+}
+
+PointTable composeTables(const PointTable& first, const PointTable& second) {
+    PointTable table;
+    for (int i = 0; i < 256; ++i) table[i] = second[first[i]];
+    return table;
 }
 
-cv::Mat applyPosterization(const cv::Mat& inputImage, int levels) {
-    if (inputImage.empty() || inputImage.channels() != 1 || levels < 2 || levels > 256) {
-        QMessageBox::warning(nullptr, "Posterization Error", "Input image is empty or not grayscale.");
-        return inputImage.clone(); // Return copy if invalid input
+Histogram mapHistogram(const Histogram& histogram, const PointTable& table) {
+    Histogram mapped;
+    mapped.fill(0);
+    for (int i = 0; i < 256; ++i) mapped[table[i]] += histogram[i];
+    return mapped;
+}
+
+MatResult applyPointTable(const cv::Mat& inputImage, const PointTable& table) {
+    if (inputImage.empty() || inputImage.depth() != CV_8U) {
+        return Error{"Point Operation Error", "Input image is empty or not 8-bit."};
     }
+    return applyLookupTable(inputImage, cv::Mat(1, 256, CV_8U, const_cast<uchar*>(table.data())));
+}
 
-    cv::Mat outputImage = inputImage.clone();
-    uchar lookupTable[256];
-    double step = 255.0 / (levels - 1);
+MatResult applyNegation(const cv::Mat& inputImage) {
+    if (inputImage.empty()) {
+        return Error{"Negation Error", "Input image is empty."};
+    }
+    if (inputImage.depth() == CV_8U) {
+        return applyPointTable(inputImage, negationTable());
+    }
+    return cv::Mat(cv::Scalar::all(255) - inputImage);
+}
 
-    for (int i = 0; i < 256; ++i) {
-        lookupTable[i] = cv::saturate_cast<uchar>(std::round(i / step) * step);
+MatResult applyRangeStretching(const cv::Mat& inputImage, int p1, int p2, int q3, int q4) {
+    if (inputImage.empty() || inputImage.type() != CV_8UC1) {
+        return Error{"Range Stretching Error", "Input image is empty or not 8-bit grayscale."};
     }
+    const TableResult table = rangeStretchingTable(p1, p2, q3, q4);
+    if (!table) return table.error();
+    return applyPointTable(inputImage, table.value());
+}
 
-    // Apply LUT efficiently
-    cv::LUT(inputImage, cv::Mat(1, 256, CV_8U, lookupTable), outputImage);
+MatResult applyPosterization(const cv::Mat& inputImage, int levels) {
+    if (inputImage.empty() || inputImage.type() != CV_8UC1) {
+        return Error{"Posterization Error", "Input image is empty or not 8-bit grayscale."};
+    }
+    const TableResult table = posterizationTable(levels);
+    if (!table) return table.error();
+    return applyPointTable(inputImage, table.value());
+}
 
-    return outputImage;
+MatResult applyGammaCorrection(const cv::Mat& inputImage, double gamma) {
+    if (inputImage.empty() || inputImage.depth() != CV_8U) {
+        return Error{"Gamma Correction Error", "Input image is empty or not 8-bit."};
+    }
+    const TableResult table = gammaTable(gamma);
+    if (!table) return table.error();
+    if (inputImage.channels() != 4) return applyPointTable(inputImage, table.value());
+
+    // Per-channel table that leaves the alpha channel as it is
+    PointTable identity = identityTable();
+    PointTable corrected = table.value();
+    cv::Mat lookupTable;
+    const cv::Mat color(1, 256, CV_8U, corrected.data());
+    cv::merge(std::vector<cv::Mat>{color, color, color, cv::Mat(1, 256, CV_8U, identity.data())}, lookupTable);
+    return applyLookupTable(inputImage, lookupTable);
 }
 
-cv::Mat applyBitwiseAnd(const cv::Mat& img1, const cv::Mat& img2) {
+MatResult applyBitwiseAnd(const cv::Mat& img1, const cv::Mat& img2) {
     cv::Mat result;
     if (!img1.empty() && !img2.empty() && img1.size() == img2.size() && img1.type() == img2.type()) {
         cv::bitwise_and(img1, img2, result);
     } else {
-        // Handle error: incompatible images
-        // Consider logging or throwing
-        result = img1.clone(); // Or return empty
+        return Error{"Bitwise AND Error", "Images must be non-empty and have the same size and type."};
     }
     return result;
 }
 
-cv::Mat applyBitwiseOr(const cv::Mat& img1, const cv::Mat& img2) {
+MatResult applyBitwiseOr(const cv::Mat& img1, const cv::Mat& img2) {
     cv::Mat result;
     if (!img1.empty() && !img2.empty() && img1.size() == img2.size() && img1.type() == img2.type()) {
         cv::bitwise_or(img1, img2, result);
     } else {
-        result = img1.clone();
+        return Error{"Bitwise OR Error", "Images must be non-empty and have the same size and type."};
     }
     return result;
 }
 
-cv::Mat applyBitwiseXor(const cv::Mat& img1, const cv::Mat& img2) {
+MatResult applyBitwiseXor(const cv::Mat& img1, const cv::Mat& img2) {
     cv::Mat result;
     if (!img1.empty() && !img2.empty() && img1.size() == img2.size() && img1.type() == img2.type()) {
         cv::bitwise_xor(img1, img2, result);
     } else {
-        result = img1.clone();
+        return Error{"Bitwise XOR Error", "Images must be non-empty and have the same size and type."};
     }
     return result;
 }
 
-cv::Mat applyAddition(const cv::Mat& img1, const cv::Mat& img2) {
+MatResult applyAddition(const cv::Mat& img1, const cv::Mat& img2) {
     cv::Mat result;
     if (!img1.empty() && !img2.empty() && img1.size() == img2.size() && img1.type() == img2.type()) {
         cv::add(img1, img2, result);
     } else {
-        result = img1.clone();
+        return Error{"Addition Error", "Images must be non-empty and have the same size and type."};
     }
     return result;
 }
 
-cv::Mat applySubtraction(const cv::Mat& img1, const cv::Mat& img2) {
+MatResult applySubtraction(const cv::Mat& img1, const cv::Mat& img2) {
     cv::Mat result;
     if (!img1.empty() && !img2.empty() && img1.size() == img2.size() && img1.type() == img2.type()) {
         cv::subtract(img1, img2, result);
     } else {
-        result = img1.clone();
+        return Error{"Subtraction Error", "Images must be non-empty and have the same size and type."};
     }
     return result;
 }
 
-cv::Mat applyBlending(const cv::Mat& img1, const cv::Mat& img2, double alpha, double gamma) {
+MatResult applyBlending(const cv::Mat& img1, const cv::Mat& img2, double alpha, double gamma) {
     cv::Mat result;
     if (!img1.empty() && !img2.empty() && img1.size() == img2.size() && img1.type() == img2.type()) {
         double beta = 1.0 - alpha;
         cv::addWeighted(img1, alpha, img2, beta, gamma, result);
     } else {
-        result = img1.clone();
+        return Error{"Blending Error", "Images must be non-empty and have the same size and type."};
     }
     return result;
 }
@@ -230,10 +655,12 @@ cv::Mat applyBlending(const cv::Mat& img1, const cv::Mat& img2, double alpha, do
 // Group 7: Image Processing - Histogram Operations
 // ==========================================================================
 
-cv::Mat stretchHistogram(const cv::Mat& inputImage) {
+MatResult stretchHistogram(const cv::Mat& inputImage) {
     if (inputImage.empty() || inputImage.channels() != 1) {
-        QMessageBox::warning(nullptr, "Stretch Histogram Error", "Input image is empty or not grayscale.");
-        return inputImage.clone();
+        return Error{"Stretch Histogram Error", "Input image is empty or not grayscale."};
+    }
+    if (inputImage.depth() == CV_8U) {
+        return applyPointTable(inputImage, histogramStretchTable(computeGrayHistogram(inputImage)));
     }
     cv::Mat outputImage;
     double minVal, maxVal;
@@ -252,126 +679,117 @@ cv::Mat stretchHistogram(const cv::Mat& inputImage) {
     return outputImage;
 }
 
-cv::Mat equalizeHistogram(const cv::Mat& inputImage) {
-    if (inputImage.empty() || inputImage.channels() != 1) {
-        QMessageBox::warning(nullptr, "Equalize Histogram Error", "Input image is empty or not grayscale.");
-        return inputImage.clone();
-    }
-
-        cv::Mat outputImage = inputImage.clone();
-        // Step 1: Compute Histogram
-        std::vector<int> histogram(256, 0);
-        for (int y = 0; y < outputImage.rows; y++) {
-            for (int x = 0; x < outputImage.cols; x++) {
-                histogram[outputImage.at<uchar>(y, x)]++;
-            }
-        }
-
-        // Step 2: Compute CDF
-        std::vector<int> cdf(256, 0);
-        cdf[0] = histogram[0];
-        for (int i = 1; i < 256; i++) {
-            cdf[i] = cdf[i - 1] + histogram[i];
-        }
+std::vector<Histogram> computeChannelHistograms(const cv::Mat& inputImage) {
+    if (inputImage.empty() || inputImage.depth() != CV_8U) return {};
+    return countHistograms(inputImage, inputImage.channels(), nullptr);
+}
 
-        // Find the first non-zero CDF value
-        int minCDF = 0;
-        for(int val : cdf) {
-            if (val > 0) {
-                minCDF = val;
-                break;
-            }
-        }
-        if (outputImage.total() == minCDF) return outputImage; // Avoid division by zero if all pixels are the same value > 0
-
-        // Step 3: Create LUT and Apply Equalization
-        uchar equalizationMap[256];
-        float scale = 255.0f / (outputImage.total() - minCDF);
-        for (int i = 0; i < 256; i++) {
-             if (cdf[i] < minCDF) { // Handle cases where cdf[i] might be 0 before minCDF
-                 equalizationMap[i] = 0;
-             } else {
-                 equalizationMap[i] = cv::saturate_cast<uchar>((cdf[i] - minCDF) * scale);
-             }
-        }
-        cv::LUT(inputImage, cv::Mat(1, 256, CV_8U, equalizationMap), outputImage);
+Histogram computeGrayHistogram(const cv::Mat& inputImage) {
+    Histogram empty;
+    empty.fill(0);
+    if (inputImage.empty() || inputImage.depth() != CV_8U) return empty;
+
+    switch (inputImage.channels()) {
+    case 1:
+        return countHistograms(inputImage, 1, nullptr).front();
+    case 3:
+    case 4: {
+        const int code = inputImage.channels() == 3 ? cv::COLOR_BGR2GRAY : cv::COLOR_BGRA2GRAY;
+        return countHistograms(inputImage, 1, [code](const cv::Mat& rows, cv::Mat& buffer) {
+            cv::cvtColor(rows, buffer, code); // Same per-pixel result as converting the whole image
+            return buffer;
+        }).front();
+    }
+    default:
+        return empty;
+    }
+}
 
-        return outputImage;
+MatResult equalizeHistogram(const cv::Mat& inputImage) {
+    if (inputImage.empty() || inputImage.type() != CV_8UC1) {
+        return Error{"Equalize Histogram Error", "Input image is empty or not 8-bit grayscale."};
+    }
+    return applyPointTable(inputImage, equalizationTable(computeGrayHistogram(inputImage)));
 }
 
 // ==========================================================================
 // Group 8: Image Processing - Filtering & Edge Detection
 // ==========================================================================
 
-cv::Mat applyBoxBlur(const cv::Mat& inputImage, int kernelSize, int borderOption) {
+MatResult applyBoxBlur(const cv::Mat& inputImage, int kernelSize, int borderOption) {
     if (inputImage.empty()) {
-        QMessageBox::warning(nullptr, "Box Blur Error", "Input image is empty.");
-        return cv::Mat();
+        return Error{"Box Blur Error", "Input image is empty."};
     }
-    cv::Mat outputImage;
-    cv::blur(inputImage, outputImage, cv::Size(kernelSize, kernelSize), cv::Point(-1, -1), borderOption);
-    return outputImage;
+    return applyTiled(inputImage, kernelSize / 2, borderOption, [=](const cv::Mat& tile) -> MatResult {
+        cv::Mat outputImage;
+        cv::blur(tile, outputImage, cv::Size(kernelSize, kernelSize), cv::Point(-1, -1), borderOption);
+        return outputImage;
+    });
 }
 
-cv::Mat applyGaussianBlur(const cv::Mat& inputImage, int kernelSize, double sigmaX, double sigmaY, int borderOption) {
+MatResult applyGaussianBlur(const cv::Mat& inputImage, int kernelSize, double sigmaX, double sigmaY, int borderOption) {
     if (inputImage.empty()) {
-        QMessageBox::warning(nullptr, "Gaussian Blur Error", "Input image is empty.");
-        return cv::Mat();
+        return Error{"Gaussian Blur Error", "Input image is empty."};
     }
-    cv::Mat outputImage;
-    cv::GaussianBlur(inputImage, outputImage, cv::Size(kernelSize, kernelSize), sigmaX, sigmaY, borderOption);
-    return outputImage;
+    // With kernelSize 0 OpenCV derives the size from sigma (at most 4 sigma per side)
+    const int halo = kernelSize > 0 ? kernelSize / 2 : cvCeil(4 * std::max(sigmaX, sigmaY));
+    return applyTiled(inputImage, halo, borderOption, [=](const cv::Mat& tile) -> MatResult {
+        cv::Mat outputImage;
+        cv::GaussianBlur(tile, outputImage, cv::Size(kernelSize, kernelSize), sigmaX, sigmaY, borderOption);
+        return outputImage;
+    });
 }
 
-cv::Mat applySobelEdgeDetection(const cv::Mat& inputImage, int kernelSize, double scale, double delta, int borderOption) {
+MatResult applySobelEdgeDetection(const cv::Mat& inputImage, int kernelSize, double scale, double delta, int borderOption) {
     if (inputImage.empty() || inputImage.channels() != 1) {
-        QMessageBox::warning(nullptr, "Sobel Edge Detection Error", "Input image is empty or not grayscale.");
-        return inputImage.clone();
+        return Error{"Sobel Edge Detection Error", "Input image is empty or not grayscale."};
     }
-    cv::Mat gradX, gradY;
-    cv::Mat absGradX, absGradY;
-    cv::Mat outputImage;
+    // Tiled so the 16-bit gradient temporaries never exist for the whole image
+    return applyTiled(inputImage, std::max(1, kernelSize / 2), borderOption, [=](const cv::Mat& tile) -> MatResult {
+        cv::Mat gradX, gradY;
+        cv::Mat absGradX, absGradY;
+        cv::Mat outputImage;
 
-    // Gradient X
-    cv::Sobel(inputImage, gradX, CV_16S, 1, 0, kernelSize, scale, delta, borderOption);
-    // Gradient Y
-    cv::Sobel(inputImage, gradY, CV_16S, 0, 1, kernelSize, scale, delta, borderOption);
+        // Gradient X
+        cv::Sobel(tile, gradX, CV_16S, 1, 0, kernelSize, scale, delta, borderOption);
+        // Gradient Y
+        cv::Sobel(tile, gradY, CV_16S, 0, 1, kernelSize, scale, delta, borderOption);
 
-    // Convert gradients to absolute versions
-    cv::convertScaleAbs(gradX, absGradX);
-    cv::convertScaleAbs(gradY, absGradY);
+        // Convert gradients to absolute versions
+        cv::convertScaleAbs(gradX, absGradX);
+        cv::convertScaleAbs(gradY, absGradY);
 
-    // Total Gradient (approximate)
-    cv::addWeighted(absGradX, 0.5, absGradY, 0.5, 0, outputImage);
+        // Total Gradient (approximate)
+        cv::addWeighted(absGradX, 0.5, absGradY, 0.5, 0, outputImage);
 
-    return outputImage;
+        return outputImage;
+    });
 }
 
-cv::Mat applyLaplacianEdgeDetection(const cv::Mat& inputImage, int kernelSize, double scale, double delta, int borderOption) {
+MatResult applyLaplacianEdgeDetection(const cv::Mat& inputImage, int kernelSize, double scale, double delta, int borderOption) {
     if (inputImage.empty() || inputImage.channels() != 1) {
-        QMessageBox::warning(nullptr, "Laplacian Edge Detection Error", "Input image is empty or not grayscale.");
-        return inputImage.clone();
+        return Error{"Laplacian Edge Detection Error", "Input image is empty or not grayscale."};
     }
-    cv::Mat laplacian_16s, outputImage;
-    cv::Laplacian(inputImage, laplacian_16s, CV_16S, kernelSize, scale, delta, borderOption);
-    cv::convertScaleAbs(laplacian_16s, outputImage);
-    return outputImage;
+    return applyTiled(inputImage, std::max(1, kernelSize / 2), borderOption, [=](const cv::Mat& tile) -> MatResult {
+        cv::Mat laplacian_16s, outputImage;
+        cv::Laplacian(tile, laplacian_16s, CV_16S, kernelSize, scale, delta, borderOption);
+        cv::convertScaleAbs(laplacian_16s, outputImage);
+        return outputImage;
+    });
 }
 
-cv::Mat applyCannyEdgeDetection(const cv::Mat& inputImage, double threshold1, double threshold2, int apertureSize, bool L2gradient) {
+MatResult applyCannyEdgeDetection(const cv::Mat& inputImage, double threshold1, double threshold2, int apertureSize, bool L2gradient) {
     if (inputImage.empty() || inputImage.channels() != 1) {
-        QMessageBox::warning(nullptr, "Canny Edge Detection Error", "Input image is empty or not grayscale.");
-        return inputImage.clone();
+        return Error{"Canny Edge Detection Error", "Input image is empty or not grayscale."};
     }
     cv::Mat outputImage;
     cv::Canny(inputImage, outputImage, threshold1, threshold2, apertureSize, L2gradient);
     return outputImage;
 }
 
-cv::Mat applySharpening(const cv::Mat& inputImage, int option, int borderOption) {
+MatResult applySharpening(const cv::Mat& inputImage, int option, int borderOption) {
     if (inputImage.empty()) {
-        QMessageBox::warning(nullptr, "Sharpening Filter Error", "Input image is empty.");
-        return cv::Mat();
+        return Error{"Sharpening Filter Error", "Input image is empty."};
     }
     cv::Mat kernel;
     switch (option) {
@@ -394,18 +812,19 @@ cv::Mat applySharpening(const cv::Mat& inputImage, int option, int borderOption)
                   1, -2,  1);
         break;
     default:
-        return inputImage.clone(); // Return copy if invalid option
+        return Error{"Sharpening Filter Error", "Unknown sharpening option."};
     }
 
-    cv::Mat outputImage;
-    cv::filter2D(inputImage, outputImage, -1, kernel, cv::Point(-1, -1), 0, borderOption);
-    return outputImage;
+    return applyTiled(inputImage, 1, borderOption, [=](const cv::Mat& tile) -> MatResult {
+        cv::Mat outputImage;
+        cv::filter2D(tile, outputImage, -1, kernel, cv::Point(-1, -1), 0, borderOption);
+        return outputImage;
+    });
 }
 
-cv::Mat applyPrewittEdgeDetection(const cv::Mat& inputImage, int direction, int borderOption) {
+MatResult applyPrewittEdgeDetection(const cv::Mat& inputImage, int direction, int borderOption) {
     if (inputImage.empty() || inputImage.channels() != 1) {
-        QMessageBox::warning(nullptr, "Prewitt Edge Detection Error", "Input image is empty or not grayscale.");
-        return inputImage.clone();
+        return Error{"Prewitt Edge Detection Error", "Input image is empty or not grayscale."};
     }
 
     cv::Mat kernel;
@@ -419,19 +838,80 @@ cv::Mat applyPrewittEdgeDetection(const cv::Mat& inputImage, int direction, int
     case 6: kernel = (cv::Mat_<float>(3,3) <<  0, 1, 1, -1, 0, 1, -1,-1, 0); break; // BL
     case 7: kernel = (cv::Mat_<float>(3,3) <<  1, 1, 1,  0, 0, 0, -1,-1,-1); break; // B
     case 8: kernel = (cv::Mat_<float>(3,3) <<  1, 1, 0,  1, 0,-1,  0,-1,-1); break; // BR
-    default: return inputImage.clone(); // Invalid direction
+    default: return Error{"Prewitt Edge Detection Error", "Invalid direction."};
     }
 
-    cv::Mat outputImage_16s, outputImage;
-    cv::filter2D(inputImage, outputImage_16s, CV_16S, kernel, cv::Point(-1,-1), 0, borderOption);
-    cv::convertScaleAbs(outputImage_16s, outputImage); // Convert to 8U for display
-    return outputImage;
+    return applyTiled(inputImage, 1, borderOption, [=](const cv::Mat& tile) -> MatResult {
+        cv::Mat outputImage_16s, outputImage;
+        cv::filter2D(tile, outputImage_16s, CV_16S, kernel, cv::Point(-1,-1), 0, borderOption);
+        cv::convertScaleAbs(outputImage_16s, outputImage); // Convert to 8U for display
+        return outputImage;
+    });
+}
+
+const char* convolutionMethodName(ConvolutionMethod method) {
+    switch (method) {
+    case ConvolutionMethod::Separable: return "Separable (row and column passes)";
+    case ConvolutionMethod::Frequency: return "Frequency domain (DFT)";
+    default: return "Direct (dense kernel)";
+    }
+}
+
+ConvolutionMethod chooseConvolutionMethod(const cv::Mat& kernel) {
+    if (kernel.total() <= 1) return ConvolutionMethod::Direct;
+    cv::Mat columnKernel, rowKernel;
+    if (separateKernel(kernel, columnKernel, rowKernel)) return ConvolutionMethod::Separable;
+    return static_cast<int>(kernel.total()) >= FrequencyMinTaps ? ConvolutionMethod::Frequency : ConvolutionMethod::Direct;
+}
+
+cv::Mat combineKernels(const cv::Mat& first, const cv::Mat& second) {
+    cv::Mat combined = cv::Mat::zeros(first.rows + second.rows - 1, first.cols + second.cols - 1, CV_32F);
+    for (int i = 0; i < first.rows; ++i) {
+        for (int j = 0; j < first.cols; ++j) {
+            cv::Mat window = combined(cv::Rect(j, i, second.cols, second.rows));
+            window += first.at<float>(i, j) * second;
+        }
+    }
+    return combined;
+}
+
+MatResult convolve(const cv::Mat& inputImage, const cv::Mat& kernel, int borderOption, ConvolutionInfo* info) {
+    if (inputImage.empty() || kernel.empty() || kernel.channels() != 1) {
+        return Error{"Convolution Error", "Input image is empty or the kernel is invalid."};
+    }
+    const auto start = std::chrono::steady_clock::now();
+    cv::Mat kernel32;
+    kernel.convertTo(kernel32, CV_32F);
+    const int halo = std::max(kernel32.cols, kernel32.rows) / 2;
+
+    const ConvolutionMethod method = chooseConvolutionMethod(kernel32);
+    cv::Mat columnKernel, rowKernel;
+    if (method == ConvolutionMethod::Separable) separateKernel(kernel32, columnKernel, rowKernel);
+
+    MatResult result = applyTiled(inputImage, halo, borderOption, [=](const cv::Mat& tile) -> MatResult {
+        cv::Mat outputImage;
+        switch (method) {
+        case ConvolutionMethod::Separable:
+            cv::sepFilter2D(tile, outputImage, -1, rowKernel, columnKernel, cv::Point(-1, -1), 0, borderOption);
+            return outputImage;
+        case ConvolutionMethod::Frequency:
+            return correlateInFrequency(tile, kernel32, halo);
+        default:
+            cv::filter2D(tile, outputImage, -1, kernel32, cv::Point(-1, -1), 0, borderOption);
+            return outputImage;
+        }
+    });
+
+    if (info) {
+        info->method = method;
+        info->milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    return result;
 }
 
-cv::Mat applyCustomFilter(const cv::Mat& inputImage, cv::Mat kernel, bool normalize, int borderOption) {
+MatResult applyCustomFilter(const cv::Mat& inputImage, cv::Mat kernel, bool normalize, int borderOption, ConvolutionInfo* info) {
     if (inputImage.empty() || kernel.empty()) {
-        QMessageBox::warning(nullptr, "Custom Filter Error", "Input image or kernel is empty.");
-        return inputImage.clone();
+        return Error{"Custom Filter Error", "Input image or kernel is empty."};
     }
     // Ensure kernel is float
     if(kernel.type() != CV_32F) {
@@ -445,50 +925,66 @@ cv::Mat applyCustomFilter(const cv::Mat& inputImage, cv::Mat kernel, bool normal
         }
     }
 
-    cv::Mat outputImage;
-    cv::filter2D(inputImage, outputImage, -1, kernel, cv::Point(-1, -1), 0, borderOption);
-    return outputImage;
+    return convolve(inputImage, kernel, borderOption, info);
 }
 
 // Custom implementation of Median Filtering to support border handling
-cv::Mat applyMedianFilter(const cv::Mat& inputImage, int kernelSize, int borderType) {
-    if (inputImage.empty() || inputImage.channels() != 1 || kernelSize <= 1 || kernelSize % 2 == 0) {
-        QMessageBox::warning(nullptr, "Median Filter Error", "Input image is empty.");
-        return inputImage.clone();
-    }
-
-    cv::Mat borderedImage;
-    int border = kernelSize / 2;
-    cv::copyMakeBorder(inputImage, borderedImage, border, border, border, border, borderType);
-
-    cv::Mat filteredImage = inputImage.clone(); // Initialize with correct size
-
-    std::vector<uchar> neighbors(kernelSize * kernelSize);
-
-    for (int y = 0; y < inputImage.rows; ++y) {
-        uchar* filteredRowPtr = filteredImage.ptr<uchar>(y);
-        for (int x = 0; x < inputImage.cols; ++x) {
-            // Collect neighbors from the bordered image
-            int k = 0;
-            for (int ky = -border; ky <= border; ++ky) {
-                const uchar* borderedRowPtr = borderedImage.ptr<uchar>(y + border + ky);
-                for (int kx = -border; kx <= border; ++kx) {
-                    neighbors[k++] = borderedRowPtr[x + border + kx];
+MatResult applyMedianFilter(const cv::Mat& inputImage, int kernelSize, int borderType, OperationProgress* progress) {
+    if (inputImage.empty() || inputImage.type() != CV_8UC1 || kernelSize <= 1 || kernelSize % 2 == 0) {
+        return Error{"Median Filter Error", "Input image is empty or not 8-bit grayscale, or the kernel size is not odd and greater than 1."};
+    }
+
+    const int border = kernelSize / 2;
+
+    if (kernelSize > 7) {
+        // Constant time per pixel whatever the kernel size. Tiles grow with the kernel so the halo,
+        // computed by every tile, stays a small part of the work.
+        const int tileSize = std::max(512, 8 * kernelSize);
+        const bool wideCounts = kernelSize * kernelSize > std::numeric_limits<uint16_t>::max();
+        return applyTiled(inputImage, border, borderType, [=](const cv::Mat& borderedImage) -> MatResult {
+            return wideCounts ? constantTimeMedian<uint32_t>(borderedImage, border)
+                              : constantTimeMedian<uint16_t>(borderedImage, border);
+        }, progress, tileSize);
+    }
+
+    // Small kernels: selecting among a handful of neighbours beats maintaining histograms
+    return applyTiled(inputImage, border, borderType, [=](const cv::Mat& borderedImage) -> MatResult {
+        cv::Mat filteredImage(borderedImage.rows - 2 * border, borderedImage.cols - 2 * border, CV_8UC1);
+        std::vector<uchar> neighbors(kernelSize * kernelSize);
+
+        for (int y = 0; y < filteredImage.rows; ++y) {
+            uchar* filteredRowPtr = filteredImage.ptr<uchar>(y);
+            for (int x = 0; x < filteredImage.cols; ++x) {
+                // Collect neighbors from the bordered tile
+                int k = 0;
+                for (int ky = -border; ky <= border; ++ky) {
+                    const uchar* borderedRowPtr = borderedImage.ptr<uchar>(y + border + ky);
+                    for (int kx = -border; kx <= border; ++kx) {
+                        neighbors[k++] = borderedRowPtr[x + border + kx];
+                    }
                 }
+                // Find the median using nth_element (efficient)
+                std::nth_element(neighbors.begin(), neighbors.begin() + neighbors.size() / 2, neighbors.end());
+                filteredRowPtr[x] = neighbors[neighbors.size() / 2];
             }
-            // Find the median using nth_element (efficient)
-            std::nth_element(neighbors.begin(), neighbors.begin() + neighbors.size() / 2, neighbors.end());
-            filteredRowPtr[x] = neighbors[neighbors.size() / 2];
         }
-    }
-    return filteredImage;
+        return filteredImage;
+    }, progress);
 }
 
 
-cv::Mat applyTwoStepFilter(const cv::Mat& inputImage, const cv::Mat& kernel1, const cv::Mat& kernel2, int borderOption) {
+const char* twoStepStrategyName(TwoStepStrategy strategy) {
+    switch (strategy) {
+    case TwoStepStrategy::Sequential: return "Two 3x3 passes";
+    case TwoStepStrategy::Separable: return "Separable 1-D passes";
+    default: return "Combined 5x5";
+    }
+}
+
+MatResult applyTwoStepFilter(const cv::Mat& inputImage, const cv::Mat& kernel1, const cv::Mat& kernel2, int borderOption,
+                             TwoStepStrategy strategy, ConvolutionInfo* info) {
     if (inputImage.empty() || kernel1.empty() || kernel2.empty() || kernel1.size() != cv::Size(3,3) || kernel2.size() != cv::Size(3,3)) {
-        QMessageBox::warning(nullptr, "Two Step Filter Error", "Input image is empty or input kernels are incorrect.");
-        return inputImage.clone();
+        return Error{"Two Step Filter Error", "Input image is empty or input kernels are incorrect."};
     }
 
     // Ensure kernels are float
@@ -496,34 +992,69 @@ cv::Mat applyTwoStepFilter(const cv::Mat& inputImage, const cv::Mat& kernel1, co
     kernel1.convertTo(k1, CV_32F);
     kernel2.convertTo(k2, CV_32F);
 
+    // The combined kernel is normalized by its sum, which is sum(k1) * sum(k2)
+    double scale = cv::sum(k1)[0] * cv::sum(k2)[0];
+    scale = std::abs(scale) > DBL_EPSILON ? 1.0 / scale : 1.0;
 
-    // --- Calculate the equivalent 5x5 kernel ---
-    cv::Mat combined5x5 = cv::Mat::zeros(5, 5, CV_32F);
-
-    for (int i = 0; i < 3; ++i) {
-        for (int j = 0; j < 3; ++j) {
-            for (int k = 0; k < 3; ++k) {
-                for (int l = 0; l < 3; ++l) {
-                    combined5x5.at<float>(i + k, j + l) += kernel1.at<float>(i, j) * kernel2.at<float>(k, l);
-                }
-            }
-        }
+    if (strategy == TwoStepStrategy::Combined) {
+        return convolve(inputImage, combineKernels(k1, k2) * scale, borderOption, info);
     }
-    // --- End 5x5 kernel calculation ---
 
+    const auto start = std::chrono::steady_clock::now();
+    cv::Mat column1, row1, column2, row2;
+    const bool separable1 = strategy == TwoStepStrategy::Separable && separateKernel(k1, column1, row1);
+    const bool separable2 = strategy == TwoStepStrategy::Separable && separateKernel(k2, column2, row2);
+    const cv::Mat k2Scaled = k2 * scale;
+    const cv::Mat row2Scaled = separable2 ? cv::Mat(row2 * scale) : cv::Mat();
 
-    // Normalize the combined kernel
-    double sum = cv::sum(combined5x5)[0];
-    if (std::abs(sum) > DBL_EPSILON) {
-        combined5x5 /= sum;
-    }
+    MatResult result = applyTiled(inputImage, 2, borderOption, [=](const cv::Mat& tile) -> MatResult {
+        cv::Mat outputImage;
+        if (separable1 && separable2) {
+            // Both kernels have rank 1: their row and column vectors combine into one 5-tap pair
+            cv::sepFilter2D(tile, outputImage, -1, combineKernels(row1, row2Scaled), combineKernels(column1, column2),
+                            cv::Point(-1, -1), 0, borderOption);
+            return outputImage;
+        }
+        // The intermediate stays float so the result is rounded once, as with the combined kernel.
+        // Only its outer ring sees borderOption at the padded tile's edge, and that ring is cropped.
+        cv::Mat firstPass, secondPass;
+        if (separable1) {
+            cv::sepFilter2D(tile, firstPass, CV_32F, row1, column1, cv::Point(-1, -1), 0, borderOption);
+        } else {
+            cv::filter2D(tile, firstPass, CV_32F, k1, cv::Point(-1, -1), 0, borderOption);
+        }
+        if (separable2) {
+            cv::sepFilter2D(firstPass, secondPass, CV_32F, row2Scaled, column2, cv::Point(-1, -1), 0, borderOption);
+        } else {
+            cv::filter2D(firstPass, secondPass, CV_32F, k2Scaled, cv::Point(-1, -1), 0, borderOption);
+        }
+        secondPass.convertTo(outputImage, tile.depth());
+        return outputImage;
+    });
 
-    // Apply the computed 5x5 kernel
-    cv::Mat result;
-    cv::filter2D(inputImage, result, -1, combined5x5, cv::Point(-1, -1), 0, borderOption);
+    if (info) {
+        info->method = separable1 || separable2 ? ConvolutionMethod::Separable : ConvolutionMethod::Direct;
+        info->milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
     return result;
 }
 
+Result<std::vector<StrategyTiming>> benchmarkTwoStepFilter(const cv::Mat& inputImage, const cv::Mat& kernel1,
+                                                           const cv::Mat& kernel2, int borderOption, int runs) {
+    std::vector<StrategyTiming> timings;
+    for (TwoStepStrategy strategy : {TwoStepStrategy::Combined, TwoStepStrategy::Sequential, TwoStepStrategy::Separable}) {
+        double best = std::numeric_limits<double>::max();
+        for (int run = 0; run < std::max(1, runs); ++run) {
+            ConvolutionInfo info;
+            MatResult result = applyTwoStepFilter(inputImage, kernel1, kernel2, borderOption, strategy, &info);
+            if (!result) return result.error();
+            best = std::min(best, info.milliseconds);
+        }
+        timings.push_back(StrategyTiming{strategy, best});
+    }
+    return timings;
+}
+
 // ==========================================================================
 // Group 9: Image Processing - Morphology
 // ==========================================================================
@@ -546,10 +1077,9 @@ cv::Mat getStructuringElement(StructuringElementType type) {
     }
 }
 
-cv::Mat applyErosion(const cv::Mat& inputImage, StructuringElementType elementType, int iterations, int borderOption) {
+MatResult applyErosion(const cv::Mat& inputImage, StructuringElementType elementType, int iterations, int borderOption) {
     if (inputImage.empty()) {
-        QMessageBox::warning(nullptr, "Erosion Error", "Input image is empty.");
-        return cv::Mat();
+        return Error{"Erosion Error", "Input image is empty."};
     }
     cv::Mat element = getStructuringElement(elementType);
     cv::Mat outputImage;
@@ -560,10 +1090,9 @@ cv::Mat applyErosion(const cv::Mat& inputImage, StructuringElementType elementTy
     return outputImage;
 }
 
-cv::Mat applyDilation(const cv::Mat& inputImage, StructuringElementType elementType, int iterations, int borderOption) {
+MatResult applyDilation(const cv::Mat& inputImage, StructuringElementType elementType, int iterations, int borderOption) {
     if (inputImage.empty()) {
-        QMessageBox::warning(nullptr, "Dilation Error", "Input image is empty.");
-        return cv::Mat();
+        return Error{"Dilation Error", "Input image is empty."};
     }
     cv::Mat element = getStructuringElement(elementType);
     cv::Mat outputImage;
@@ -571,10 +1100,9 @@ cv::Mat applyDilation(const cv::Mat& inputImage, StructuringElementType elementT
     return outputImage;
 }
 
-cv::Mat applyOpening(const cv::Mat& inputImage, StructuringElementType elementType, int iterations, int borderOption) {
+MatResult applyOpening(const cv::Mat& inputImage, StructuringElementType elementType, int iterations, int borderOption) {
     if (inputImage.empty()) {
-        QMessageBox::warning(nullptr, "Opening Error", "Input image is empty.");
-        return cv::Mat();
+        return Error{"Opening Error", "Input image is empty."};
     }
     cv::Mat element = getStructuringElement(elementType);
     cv::Mat outputImage;
@@ -582,10 +1110,9 @@ cv::Mat applyOpening(const cv::Mat& inputImage, StructuringElementType elementTy
     return outputImage;
 }
 
-cv::Mat applyClosing(const cv::Mat& inputImage, StructuringElementType elementType, int iterations, int borderOption) {
+MatResult applyClosing(const cv::Mat& inputImage, StructuringElementType elementType, int iterations, int borderOption) {
     if (inputImage.empty()) {
-        QMessageBox::warning(nullptr, "Closing Error", "Input image is empty.");
-        return cv::Mat();
+        return Error{"Closing Error", "Input image is empty."};
     }
     cv::Mat element = getStructuringElement(elementType);
     cv::Mat outputImage;
@@ -593,10 +1120,9 @@ cv::Mat applyClosing(const cv::Mat& inputImage, StructuringElementType elementTy
     return outputImage;
 }
 
-cv::Mat applySkeletonization(const cv::Mat& inputImage, StructuringElementType elementType) {
+MatResult applySkeletonization(const cv::Mat& inputImage, StructuringElementType elementType, OperationProgress* progress) {
     if (inputImage.empty()) {
-        QMessageBox::warning(nullptr, "Skeletonization Error", "Input image is empty.");
-        return cv::Mat();
+        return Error{"Skeletonization Error", "Input image is empty."};
     }
     // Ensure image is binary (0 or 255)
     cv::Mat binary = inputImage.clone();
@@ -609,14 +1135,19 @@ cv::Mat applySkeletonization(const cv::Mat& inputImage, StructuringElementType e
     cv::Mat temp, eroded;
     cv::Mat element = getStructuringElement(elementType);
 
+    // Progress is the share of foreground pixels already eroded away
+    const double initialForeground = std::max(1, cv::countNonZero(binary));
     bool done;
     do {
+        if (isCancelled(progress)) return Error{"Skeletonization", "Operation cancelled."};
         cv::erode(binary, eroded, element);
         cv::dilate(eroded, temp, element); // temp = open(binary)
         cv::subtract(binary, temp, temp); // temp = binary - open(binary)
         cv::bitwise_or(skeleton, temp, skeleton); // skeleton |= temp
         eroded.copyTo(binary);
-        done = (cv::countNonZero(binary) == 0); // Check if image is empty
+        const int remaining = cv::countNonZero(binary);
+        done = (remaining == 0); // Check if image is empty
+        reportProgress(progress, static_cast<int>(100.0 * (1.0 - remaining / initialForeground)));
     } while (!done);
 
     return skeleton;
@@ -627,10 +1158,9 @@ cv::Mat applySkeletonization(const cv::Mat& inputImage, StructuringElementType e
 // ==========================================================================
 
 
-cv::Mat detectHoughLines(const cv::Mat& binaryEdgeImage, double rho, double theta, int threshold) {
+MatResult detectHoughLines(const cv::Mat& binaryEdgeImage, double rho, double theta, int threshold) {
     if (binaryEdgeImage.empty()) {
-        QMessageBox::warning(nullptr, "Hough Lines Error", "Input image is empty.");
-        return cv::Mat();
+        return Error{"Hough Lines Error", "Input image is empty."};
     }
     std::vector<cv::Vec2f> lines;
     cv::Mat outputImage = binaryEdgeImage.clone();
@@ -646,8 +1176,7 @@ cv::Mat detectHoughLines(const cv::Mat& binaryEdgeImage, double rho, double thet
     } else if (outputImage.channels() == 4) {
         cv::cvtColor(outputImage, colorImage, cv::COLOR_BGRA2BGR); // Drop alpha
     } else {
-        QMessageBox::warning(nullptr, "Hough Draw Error", "Cannot draw lines on image with unsupported channel count.");
-        return cv::Mat();
+        return Error{"Hough Draw Error", "Cannot draw lines on image with unsupported channel count."};
     }
 
     // Draw detected lines
@@ -663,23 +1192,27 @@ cv::Mat detectHoughLines(const cv::Mat& binaryEdgeImage, double rho, double thet
             cv::Point pt2(cvRound(x0 - imgDiagonal * (-b)), cvRound(y0 - imgDiagonal * (a)));
             cv::line(colorImage, pt1, pt2, cv::Scalar(0, 0, 255), 1, cv::LINE_AA); // Draw red lines
         }
-        outputImage = colorImage; // Update originalImage only if lines were drawn
+        outputImage = colorImage;
     } else {
-        QMessageBox::information(nullptr, "Hough Lines", "No lines detected with the given parameters.");
-        // Don't change originalImage, effectively cancelling the operation visually
-        // The state pushed to undo stack is the original image before attempting Hough.
-        // No need to pop here, user can undo if they want.
+        // Reported as an error so callers leave the current image untouched
+        return Error{"Hough Lines", "No lines detected with the given parameters."};
     }
     return outputImage;
 }
 
-cv::Mat applyGlobalThreshold(const cv::Mat& inputImage, int threshold) {
+MatResult applyGlobalThreshold(const cv::Mat& inputImage, int threshold) {
+    if (inputImage.empty() || inputImage.channels() != 1) {
+        return Error{"Global Threshold Error", "Input image is empty or not grayscale."};
+    }
     cv::Mat resultImage;
     cv::threshold(inputImage, resultImage, threshold, 255, cv::ThresholdTypes::THRESH_BINARY);
     return resultImage;
 }
 
-cv::Mat applyAdaptiveThreshold(const cv::Mat& inputImage) {
+MatResult applyAdaptiveThreshold(const cv::Mat& inputImage) {
+    if (inputImage.empty() || inputImage.type() != CV_8UC1) {
+        return Error{"Adaptive Threshold Error", "Input image is empty or not 8-bit grayscale."};
+    }
     cv::Mat resultImage;
     cv::adaptiveThreshold(inputImage, resultImage, 255,
                           cv::AdaptiveThresholdTypes::ADAPTIVE_THRESH_MEAN_C,
@@ -687,7 +1220,10 @@ cv::Mat applyAdaptiveThreshold(const cv::Mat& inputImage) {
     return resultImage;
 }
 
-cv::Mat applyOtsuThreshold(const cv::Mat& inputImage) {
+MatResult applyOtsuThreshold(const cv::Mat& inputImage) {
+    if (inputImage.empty() || inputImage.type() != CV_8UC1) {
+        return Error{"Otsu Threshold Error", "Input image is empty or not 8-bit grayscale."};
+    }
     cv::Mat resultImage;
     cv::threshold(inputImage, resultImage, 0, 255, cv::ThresholdTypes::THRESH_BINARY | cv::THRESH_OTSU);
     return resultImage;
@@ -696,10 +1232,9 @@ cv::Mat applyOtsuThreshold(const cv::Mat& inputImage) {
 #include <queue>
 
 // Magic Wand segmentation supporting both grayscale and RGB images
-cv::Mat magicWandSegmentation(const cv::Mat& inputImage, const cv::Point& seed, int tolerance) {
+MatResult magicWandSegmentation(const cv::Mat& inputImage, const cv::Point& seed, int tolerance) {
     if (inputImage.empty()) {
-        QMessageBox::warning(nullptr, "Magic Wand Error", "Input image is empty.");
-        return cv::Mat();
+        return Error{"Magic Wand Error", "Input image is empty."};
     }
 
     cv::Mat resultImage;
@@ -711,7 +1246,12 @@ cv::Mat magicWandSegmentation(const cv::Mat& inputImage, const cv::Point& seed,
         resultImage = inputImage;
     }
 
-    CV_Assert(resultImage.type() == CV_8UC1 || resultImage.type() == CV_8UC3);
+    if (resultImage.type() != CV_8UC1 && resultImage.type() != CV_8UC3) {
+        return Error{"Magic Wand Error", "Unsupported image format."};
+    }
+    if (!cv::Rect(0, 0, resultImage.cols, resultImage.rows).contains(seed)) {
+        return Error{"Magic Wand Error", "Seed point lies outside the image."};
+    }
 
     cv::Mat visited = cv::Mat::zeros(resultImage.size(), CV_8U);
     cv::Mat mask = cv::Mat::zeros(resultImage.size(), CV_8U);
@@ -786,10 +1326,9 @@ cv::Mat magicWandSegmentation(const cv::Mat& inputImage, const cv::Point& seed,
     return mask;
 }
 
-cv::Mat grabCutSegmentation(const cv::Mat& inputImage, const cv::Rect& rect, int iterCount) {
+MatResult grabCutSegmentation(const cv::Mat& inputImage, const cv::Rect& rect, int iterCount, OperationProgress* progress) {
     if (inputImage.empty()) {
-        QMessageBox::warning(nullptr, "Grab Cut Error", "Input image is empty.");
-        return cv::Mat();
+        return Error{"Grab Cut Error", "Input image is empty."};
     }
 
     cv::Mat image;
@@ -801,15 +1340,24 @@ cv::Mat grabCutSegmentation(const cv::Mat& inputImage, const cv::Rect& rect, int
     } else if (inputImage.channels() == 3) {
         image = inputImage.clone();
     } else {
-        throw std::invalid_argument("Unsupported image format for GrabCut");
+        return Error{"Grab Cut Error", "Unsupported image format."};
+    }
+
+    if (rect.area() <= 0 || (rect & cv::Rect(0, 0, image.cols, image.rows)) != rect) {
+        return Error{"Grab Cut Error", "Selection rectangle is empty or outside the image."};
     }
 
     // Initialize mask and models
     cv::Mat mask(image.size(), CV_8UC1, cv::GC_BGD); // default: background
     cv::Mat bgdModel, fgdModel;
 
-    // Apply GrabCut
-    cv::grabCut(image, mask, rect, bgdModel, fgdModel, iterCount, cv::GC_INIT_WITH_RECT);
+    // Apply GrabCut one iteration at a time (continuing from the learned models) so progress can be
+    // reported and cancellation honoured between iterations
+    for (int iter = 0; iter < std::max(1, iterCount); ++iter) {
+        if (isCancelled(progress)) return Error{"Grab Cut", "Operation cancelled."};
+        cv::grabCut(image, mask, rect, bgdModel, fgdModel, 1, iter == 0 ? cv::GC_INIT_WITH_RECT : cv::GC_EVAL);
+        reportProgress(progress, (iter + 1) * 100 / std::max(1, iterCount));
+    }
 
     // Convert result mask to binary foreground mask
     cv::Mat binMask = (mask == cv::GC_FGD) | (mask == cv::GC_PR_FGD);
@@ -871,7 +1419,10 @@ Mat peakLocalMaxWithLabels(const Mat& image, const Mat& labels, int min_distance
     return output;
 }
 
-cv::Mat applyWatershedSegmentation(const cv::Mat &inputImage) {
+MatResult applyWatershedSegmentation(const cv::Mat &inputImage, OperationProgress* progress) {
+    if (inputImage.empty()) {
+        return Error{"Watershed Error", "Input image is empty."};
+    }
     cv::Mat image;
     inputImage.copyTo(image);
 
@@ -883,6 +1434,9 @@ cv::Mat applyWatershedSegmentation(const cv::Mat &inputImage) {
         colorInput = image.clone();
     }
 
+    if (isCancelled(progress)) return Error{"Watershed", "Operation cancelled."};
+    reportProgress(progress, 0);
+
     // Apply mean shift filtering only for color images
     cv::Mat shifted;
     if (colorInput.channels() == 3) {
@@ -891,6 +1445,9 @@ cv::Mat applyWatershedSegmentation(const cv::Mat &inputImage) {
         shifted = colorInput.clone();
     }
 
+    if (isCancelled(progress)) return Error{"Watershed", "Operation cancelled."};
+    reportProgress(progress, 60);
+
     // Convert to grayscale if not already
     cv::Mat gray;
     if (shifted.channels() == 3) {
@@ -912,6 +1469,9 @@ cv::Mat applyWatershedSegmentation(const cv::Mat &inputImage) {
     cv::Mat opening;
     morphologyEx(thresh, opening, cv::MORPH_OPEN, kernel, cv::Point(-1, -1), 2);
 
+    if (isCancelled(progress)) return Error{"Watershed", "Operation cancelled."};
+    reportProgress(progress, 70);
+
     // Distance transform
     cv::Mat dist;
     distanceTransform(opening, dist, cv::DIST_L2, 5);
@@ -935,6 +1495,9 @@ cv::Mat applyWatershedSegmentation(const cv::Mat &inputImage) {
     cv::Mat unknown;
     subtract(sure_bg, sure_fg, unknown);
 
+    if (isCancelled(progress)) return Error{"Watershed", "Operation cancelled."};
+    reportProgress(progress, 80);
+
     // Connected components as markers
     cv::Mat markers;
     int numInitialLabels = connectedComponents(sure_fg, markers);
@@ -944,12 +1507,14 @@ cv::Mat applyWatershedSegmentation(const cv::Mat &inputImage) {
     markers += 1;
     markers.setTo(0, unknown); // unknown is 0
 
+    if (isCancelled(progress)) return Error{"Watershed", "Operation cancelled."};
+    reportProgress(progress, 85);
+
     // Apply watershed
     watershed(shifted, markers);
 
     if (markers.empty() || markers.type() != CV_32S) {
-        std::cerr << "Error: Watershed algorithm failed." << std::endl;
-        return cv::Mat();
+        return Error{"Watershed Error", "Watershed algorithm failed."};
     }
 
     // Draw final result
@@ -970,9 +1535,17 @@ cv::Mat applyWatershedSegmentation(const cv::Mat &inputImage) {
     return outputImage;
 }
 
-cv::Mat applyInpainting(const cv::Mat& inputImage, const cv::Mat& mask, double radius, int method) {
+MatResult applyInpainting(const cv::Mat& inputImage, const cv::Mat& mask, double radius, int method, OperationProgress* progress) {
+    if (inputImage.empty()) {
+        return Error{"Inpainting Error", "Input image is empty."};
+    }
+    if (mask.size() != inputImage.size() || mask.type() != CV_8UC1) {
+        return Error{"Inpainting Error", "Mask must be 8-bit single channel and match the image size."};
+    }
+    if (isCancelled(progress)) return Error{"Inpainting", "Operation cancelled."};
     cv::Mat result;
     cv::inpaint(inputImage, mask, result, radius, method);
+    reportProgress(progress, 100);
     return result;
 }
 
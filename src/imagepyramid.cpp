@@ -0,0 +1,73 @@
+#include "imagepyramid.h"
+#include <algorithm>
+#include <cmath>
+#include <opencv2/imgproc.hpp>
+
+ImagePyramid::ImagePyramid(const cv::Mat& image, int minSize) {
+    if (image.empty()) return;
+    levels.push_back(image);
+    while (std::min(levels.back().cols, levels.back().rows) / 2 >= minSize) {
+        cv::Mat next;
+        cv::pyrDown(levels.back(), next);
+        levels.push_back(next);
+    }
+}
+
+bool ImagePyramid::isBuiltFrom(const cv::Mat& image) const {
+    if (levels.empty()) return false;
+    const cv::Mat& source = levels.front();
+    return source.data == image.data && source.size() == image.size()
+           && source.type() == image.type() && source.step == image.step;
+}
+
+double ImagePyramid::levelScale(int index) {
+    return std::ldexp(1.0, -index);
+}
+
+int ImagePyramid::levelFor(double scale, double* blendToCoarser) const {
+    if (blendToCoarser) *blendToCoarser = 0.0;
+    if (levels.empty() || scale >= 1.0) return 0;
+
+    const double octaves = std::log2(1.0 / scale);
+    const int index = std::min(static_cast<int>(std::floor(octaves)), levelCount() - 1);
+    if (blendToCoarser && index + 1 < levelCount()) {
+        *blendToCoarser = octaves - index;
+    }
+    return index;
+}
+
+cv::Mat ImagePyramid::render(double scale, const cv::Rect& target) const {
+    if (levels.empty() || target.empty()) return cv::Mat();
+
+    // pyrDown samples every other pixel, so level pixel u sits at level-0 position u / levelScale.
+    // A display pixel x (centre-aligned with level 0, like cv::resize) therefore maps to
+    //   x = a * u + (scale - 1) / 2,  a = scale / levelScale
+    auto sample = [&](int index) {
+        const cv::Mat& level = levels[index];
+        const double a = scale / levelScale(index);
+        const double offset = 0.5 * scale - 0.5;
+
+        // Only hand warpAffine the part of the level it reads (remap cannot index past 32767 pixels)
+        const double u0 = (target.x - offset) / a;
+        const double v0 = (target.y - offset) / a;
+        const double u1 = (target.br().x - offset) / a;
+        const double v1 = (target.br().y - offset) / a;
+        const cv::Rect roi = cv::Rect(cv::Point(static_cast<int>(std::floor(u0)) - 2, static_cast<int>(std::floor(v0)) - 2),
+                                      cv::Point(static_cast<int>(std::ceil(u1)) + 3, static_cast<int>(std::ceil(v1)) + 3))
+                             & cv::Rect(0, 0, level.cols, level.rows);
+
+        const cv::Matx23d transform(a, 0, a * roi.x + offset - target.x,
+                                    0, a, a * roi.y + offset - target.y);
+        cv::Mat out;
+        cv::warpAffine(level(roi), out, transform, target.size(), cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+        return out;
+    };
+
+    double blend = 0.0;
+    const int fine = levelFor(scale, &blend);
+    cv::Mat result = sample(fine);
+    if (blend > 0.0) {
+        cv::addWeighted(result, 1.0 - blend, sample(fine + 1), blend, 0, result);
+    }
+    return result;
+}
@@ -0,0 +1,17 @@
+#include "imagesnapshot.h"
+
+ImageSnapshot::ImageSnapshot(const cv::Mat& image)
+    : pixels(image.empty() ? nullptr : std::make_shared<const cv::Mat>(image)) {}
+
+const cv::Mat& ImageSnapshot::mat() const {
+    static const cv::Mat none;
+    return pixels ? *pixels : none;
+}
+
+bool ImageSnapshot::sharesBufferWith(const cv::Mat& image) const {
+    return pixels && !image.empty() && pixels->datastart == image.datastart;
+}
+
+cv::Mat ImageSnapshot::clone() const {
+    return pixels ? pixels->clone() : cv::Mat();
+}
@@ -0,0 +1,151 @@
+#include "imagestacking.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <string>
+
+namespace ImageProcessing {
+
+namespace {
+
+// Floats a worker holds per block: the block's values times the frames stored for it (one for the mean)
+constexpr int BlockFloats = 1024 * 1024;
+// Narrowest block, so that even hundreds of frames leave enough values per block to be worth a task
+constexpr int MinBlockValues = 64;
+
+// Reorders `values`; for an even count, the average of the two middle values
+float medianOf(float* values, int count) {
+    float* middle = values + count / 2;
+    std::nth_element(values, middle, values + count);
+    if (count % 2) return *middle;
+    // nth_element leaves the lower half below the middle, so the other middle value is its largest
+    return 0.5f * (*middle + *std::max_element(values, middle));
+}
+
+// Mean and standard deviation of the values kept so far, then rejection of those outside
+// mean +- kappa * deviation, until a pass rejects nothing or `iterations` passes have run
+float sigmaClippedMeanOf(const float* values, int count, double kappa, int iterations) {
+    double low = -std::numeric_limits<double>::infinity();
+    double high = std::numeric_limits<double>::infinity();
+    double mean = 0.0;
+    int previouslyKept = -1;
+    for (int pass = 0; pass <= iterations; ++pass) {
+        double sum = 0.0;
+        double sumOfSquares = 0.0;
+        int kept = 0;
+        for (int i = 0; i < count; ++i) {
+            const double value = values[i];
+            if (value >= low && value <= high) {
+                sum += value;
+                sumOfSquares += value * value;
+                ++kept;
+            }
+        }
+        // Nothing rejected, or a tight threshold rejected everything: the last mean stands
+        if (kept == previouslyKept || kept == 0) break;
+        previouslyKept = kept;
+        mean = sum / kept;
+        const double deviation = std::sqrt(std::max(0.0, sumOfSquares / kept - mean * mean));
+        low = mean - kappa * deviation;
+        high = mean + kappa * deviation;
+    }
+    return static_cast<float>(mean);
+}
+
+} // namespace
+
+MatResult stackImages(const std::vector<cv::Mat>& frames, const StackOptions& options, OperationProgress* progress) {
+    if (frames.size() < 2) {
+        return Error{"Image Stacking", "Stacking needs at least two frames."};
+    }
+    for (size_t i = 0; i < frames.size(); ++i) {
+        if (frames[i].empty()) {
+            return Error{"Image Stacking", "Frame " + std::to_string(i + 1) + " is empty."};
+        }
+        if (frames[i].size() != frames[0].size() || frames[i].type() != frames[0].type()) {
+            return Error{"Image Stacking", "Frame " + std::to_string(i + 1) + " does not have the size and type of the first frame."};
+        }
+    }
+    const int depth = frames[0].depth();
+    if (depth != CV_8U && depth != CV_16U && depth != CV_32F) {
+        return Error{"Image Stacking", "Only 8-bit, 16-bit and float frames can be stacked."};
+    }
+    if (options.method == StackMethod::SigmaClippedMean && (options.kappa <= 0.0 || options.iterations < 1)) {
+        return Error{"Image Stacking", "Sigma clipping needs a positive threshold and at least one iteration."};
+    }
+
+    const int frameCount = static_cast<int>(frames.size());
+    const int rows = frames[0].rows;
+    const int rowLength = frames[0].cols * frames[0].channels();
+
+    // The mean only keeps running sums; the median and sigma clipping need every frame's value of a pixel.
+    // Blocks are whole rows while those are short, and parts of a row when they are long or frames many.
+    const bool mean = options.method == StackMethod::Mean;
+    const int storedFrames = mean ? 1 : frameCount;
+    const int blockValues = std::max(MinBlockValues, BlockFloats / storedFrames);
+    const int blockColumns = std::min(rowLength, blockValues);
+    const int blockRows = std::max(1, blockValues / rowLength);
+    const int columnBlocks = (rowLength + blockColumns - 1) / blockColumns;
+    const int blocks = (rows + blockRows - 1) / blockRows * columnBlocks;
+    const size_t slotFloats = static_cast<size_t>(blockRows) * blockColumns;
+
+    const int outputDepth = depth == CV_8U ? CV_16U : CV_32F;
+    const double outputScale = depth == CV_8U ? 257.0 : 1.0;
+    cv::Mat output(frames[0].size(), CV_MAKETYPE(outputDepth, frames[0].channels()));
+    std::atomic<int> blocksDone{0};
+    std::atomic<bool> cancelled{false};
+
+    cv::parallel_for_(cv::Range(0, blocks), [&](const cv::Range& range) {
+        std::vector<float> samples(storedFrames * slotFloats); // Frame after frame, each the block's values
+        std::vector<double> sums(mean ? slotFloats : 0);
+        std::vector<float> pixelValues(mean ? 0 : frameCount);
+        std::vector<float> combined(slotFloats);
+        for (int block = range.start; block < range.end; ++block) {
+            if ((progress && progress->isCancelled()) || cancelled) {
+                cancelled = true;
+                return;
+            }
+            const int firstRow = block / columnBlocks * blockRows;
+            const int rowCount = std::min(blockRows, rows - firstRow);
+            const int firstColumn = block % columnBlocks * blockColumns;
+            const int columnCount = std::min(blockColumns, rowLength - firstColumn);
+            const size_t count = static_cast<size_t>(rowCount) * columnCount;
+            auto region = [&](const cv::Mat& image) {
+                return image.rowRange(firstRow, firstRow + rowCount).reshape(1).colRange(firstColumn, firstColumn + columnCount);
+            };
+
+            if (mean) {
+                std::fill_n(sums.begin(), count, 0.0);
+                cv::Mat floats(rowCount, columnCount, CV_32F, samples.data());
+                for (const cv::Mat& frame : frames) {
+                    region(frame).convertTo(floats, CV_32F);
+                    // Plain loop over contiguous values, vectorized; double sums stay exact for hundreds of 16-bit frames
+                    for (size_t i = 0; i < count; ++i) sums[i] += samples[i];
+                }
+                const double scale = 1.0 / frameCount;
+                for (size_t i = 0; i < count; ++i) combined[i] = static_cast<float>(sums[i] * scale);
+            } else {
+                for (int f = 0; f < frameCount; ++f) {
+                    cv::Mat floats(rowCount, columnCount, CV_32F, samples.data() + f * count);
+                    region(frames[f]).convertTo(floats, CV_32F);
+                }
+                for (size_t i = 0; i < count; ++i) {
+                    for (int f = 0; f < frameCount; ++f) pixelValues[f] = samples[f * count + i];
+                    combined[i] = options.method == StackMethod::Median
+                                      ? medianOf(pixelValues.data(), frameCount)
+                                      : sigmaClippedMeanOf(pixelValues.data(), frameCount, options.kappa, options.iterations);
+                }
+            }
+
+            cv::Mat target = region(output);
+            cv::Mat(rowCount, columnCount, CV_32F, combined.data()).convertTo(target, outputDepth, outputScale);
+            if (progress) progress->report(static_cast<int>(++blocksDone * 100LL / blocks));
+        }
+    });
+
+    if (cancelled) return Error{"Image Stacking", "Operation cancelled."};
+    return output;
+}
+
+} // namespace ImageProcessing
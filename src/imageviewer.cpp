@@ -1,6 +1,6 @@
 #include "imageviewer.h"
 #include "imageprocessing.h" // Include the new algorithms header
-#include "clickablelabel.h"
+#include "imagecanvas.h"
 #include "houghdialog.h"
 #include "inpaintingdialog.h"
 #include "inputdialog.h"
@@ -13,6 +13,7 @@
 #include "histogramwidget.h" // Included for histogramWindow member
 #include "imageoperation.h" // Included for ImageOperation member
 #include "mainwindow.h" // Included for mainWindow member
+#include "rlecodec.h"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout> // Still needed for maybe other layouts, but not histogram
@@ -27,19 +28,64 @@
 #include <QEventLoop>
 #include <QtCharts/QtCharts>
 #include <QActionGroup>
+#include <QProgressBar>
+#include <QTimer>
+#include <QPushButton>
+#include <QScreen>
+#include <QScrollArea>
+#include <QScrollBar>
 #include <QDebug>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QPointer>
+#include <QThreadPool>
 #include <algorithm>
 #include <cmath>
 #include <string>
 #include <vector>
 
+namespace {
+
+// One macro step; a QVector of these describes how to reproduce an operation.
+QVector<PipelineStep> macroStep(const QString& name, const QMap<QString, QString>& params = {}) {
+    return {PipelineStep{name, params}};
+}
+
+QString elementName(StructuringElementType type) {
+    return type == Square ? "square" : "diamond";
+}
+
+// Pipeline "strategy" value of a two-step filter strategy
+QString strategyName(ImageProcessing::TwoStepStrategy strategy) {
+    switch (strategy) {
+    case ImageProcessing::TwoStepStrategy::Sequential: return "sequential";
+    case ImageProcessing::TwoStepStrategy::Separable: return "separable";
+    default: return "combined";
+    }
+}
+
+// Lets a filter job report its convolution method and timing to the dialog from a worker thread.
+// The dialog may be gone by the time the job finishes (always so for the accepted run).
+template <typename Dialog>
+std::function<void(const ImageProcessing::ConvolutionInfo&)> convolutionReporter(Dialog* dialog) {
+    QPointer<Dialog> target(dialog);
+    return [target](const ImageProcessing::ConvolutionInfo& info) {
+        QMetaObject::invokeMethod(qApp, [target, info]() {
+            if (target) target->setConvolutionInfo(info);
+        }, Qt::QueuedConnection);
+    };
+}
+
+} // namespace
+
 
 // ======================================================================
 // `Constructor & Core Management`
 // ======================================================================
 // Constructor: Sets up the image viewer window (image label, layout, menu, LUT).
 ImageViewer::ImageViewer(const cv::Mat &image, const QString &title, QWidget *parent, QPoint position, MainWindow *mainWindow)
-    : QWidget(parent), originalImage(image.clone()), currentScale(1.0f), histogramWindow(nullptr), mainWindow(mainWindow) { // Initialize histogramWindow to nullptr
+    : QWidget(parent), originalImage(image), currentScale(1.0f), histogramWindow(nullptr), mainWindow(mainWindow) { // Initialize histogramWindow to nullptr
 
     if (!mainWindow) {
         this->destroy(true, true);
@@ -47,6 +93,9 @@ ImageViewer::ImageViewer(const cv::Mat &image, const QString &title, QWidget *pa
         // Or close the widget and return
     } else {
         mainWindow->openedImages.push_back(this);
+        originalImage = adoptImage(image);
+        history.setBudget(mainWindow->getUndoMemoryBudget(), originalImage);
+        history.setSpillDirectory(mainWindow->getUndoSpillDirectory());
     }
 
     LUT = new QTableWidget(this);
@@ -66,11 +115,17 @@ ImageViewer::ImageViewer(const cv::Mat &image, const QString &title, QWidget *pa
 
     setWindowTitle(title);
 
-    imageLabel = new ClickableLabel(this);
-    connect(imageLabel, &ClickableLabel::mouseClicked, this, &ImageViewer::onImageClicked);
-    imageLabel->setAlignment(Qt::AlignLeft | Qt::AlignTop);
+    imageCanvas = new ImageCanvas(this);
+    connect(imageCanvas, &ImageCanvas::mouseClicked, this, &ImageViewer::onImageClicked);
     // Display initial image later in constructor after layout is set
 
+    // The canvas keeps the full scaled size; the scroll area shows (and the canvas renders) only the viewport
+    scrollArea = new QScrollArea(this);
+    scrollArea->setWidget(imageCanvas);
+    scrollArea->setWidgetResizable(false);
+    scrollArea->setAlignment(Qt::AlignLeft | Qt::AlignTop);
+    scrollArea->viewport()->installEventFilter(this); // The wheel zooms instead of scrolling
+
     mainLayout = new QVBoxLayout(this);
     // Initialize member layout
 
@@ -78,12 +133,56 @@ ImageViewer::ImageViewer(const cv::Mat &image, const QString &title, QWidget *pa
     createMenu();
     // This sets up menuBar and adds it via mainLayout->setMenuBar()
 
-    // Main content area: Just the image label for now
-    mainLayout->addWidget(imageLabel);
+    // Main content area: the scrollable image canvas
+    mainLayout->addWidget(scrollArea);
     // LUT and Zoom Input at the bottom
     mainLayout->addWidget(LUT);
     // Add LUT
 
+    // Progress row for background operations (hidden while idle)
+    progressPanel = new QWidget(this);
+    QHBoxLayout *progressLayout = new QHBoxLayout(progressPanel);
+    progressLayout->setContentsMargins(0, 0, 0, 0);
+    progressBar = new QProgressBar(progressPanel);
+    progressBar->setRange(0, 100);
+    QPushButton *cancelButton = new QPushButton("Cancel", progressPanel);
+    progressLayout->addWidget(progressBar);
+    progressLayout->addWidget(cancelButton);
+    progressPanel->hide();
+    mainLayout->addWidget(progressPanel);
+
+    operationRunner = new OperationRunner(this);
+    connect(cancelButton, &QPushButton::clicked, operationRunner, &OperationRunner::cancel);
+    connect(operationRunner, &OperationRunner::progressChanged, progressBar, &QProgressBar::setValue);
+    connect(operationRunner, &OperationRunner::finished, this, [this](const ImageProcessing::MatResult &result) {
+        setBusy(false);
+        commitResult(result, runningSteps);
+    });
+    connect(operationRunner, &OperationRunner::cancelled, this, [this]() {
+        setBusy(false);
+        updateImage();
+    });
+
+    previewRunner = new OperationRunner(this);
+    previewTimer = new QTimer(this);
+    previewTimer->setSingleShot(true);
+    previewTimer->setInterval(40);
+    connect(previewTimer, &QTimer::timeout, this, &ImageViewer::startPendingPreview);
+    connect(previewRunner, &OperationRunner::finished, this, [this](const ImageProcessing::MatResult &result) {
+        // Preview errors are not shown (they would pop up on every slider tick); the original stays visible
+        if (runningPreviewGeneration == previewGeneration) {
+            if (result) {
+                showTempImage(result.value());
+            } else {
+                updateImage();
+            }
+        }
+        if (pendingPreviewJob) startPendingPreview();
+    });
+    connect(previewRunner, &OperationRunner::cancelled, this, [this]() {
+        if (pendingPreviewJob) startPendingPreview();
+    });
+
     zoomInput = new QLineEdit(this);
     zoomInput->setStyleSheet("QLineEdit { background-color: rgba(0, 0, 0, 100); color: white; padding: 3px; border-radius: 5px; }");
     zoomInput->setAlignment(Qt::AlignRight | Qt::AlignBottom);
@@ -103,10 +202,7 @@ ImageViewer::ImageViewer(const cv::Mat &image, const QString &title, QWidget *pa
     setLayout(mainLayout);
     // Explicitly set layout
 
-    // Display initial image and set size
-    if (!originalImage.empty()) {
-        imageLabel->setPixmap(QPixmap::fromImage(MatToQImage(originalImage)));
-    }
+    // Set the initial size; the image itself is displayed by updateImage() below
     int initialWidth = originalImage.cols > 0 ? originalImage.cols + 30 : 400;
     // Simplified size calculation
     int initialHeight = originalImage.rows > 0 ?
@@ -145,7 +241,7 @@ void ImageViewer::closeEvent(QCloseEvent *event) {
         // Or LUT->deleteLater();
         LUT = nullptr;
     }
-    // Note: Widgets parented to 'this' (like LUT, imageLabel, zoomInput, menuBar)
+    // Note: Widgets parented to 'this' (like LUT, imageCanvas, zoomInput, menuBar)
     // will be deleted automatically by Qt's parent-child mechanism when 'this' is deleted.
     // Operations in operationsList might need explicit deletion if not parented.
     qDeleteAll(operationsList);
@@ -227,6 +323,9 @@ void ImageViewer::createMenu() {
                                          ImageOperation::Grayscale, [this]() { this->rangeStretching(); }));
     registerOperation(new ImageOperation("Apply Posterization...", this, pointOpsMenu,
                                          ImageOperation::Grayscale, [this]() { this->applyPosterization(); }));
+    registerOperation(new ImageOperation("Gamma Correction...", this, pointOpsMenu,
+                                         ImageOperation::Grayscale | ImageOperation::Color,
+                                         [this]() { this->applyGammaCorrection(); }));
     registerOperation(new ImageOperation("Bitwise Operations...", this, pointOpsMenu,
                                          ImageOperation::Grayscale, [this]() { this->applyBitwiseOperation(); }));
     registerOperation(new ImageOperation("Show Line Profile", this, pointOpsMenu,
@@ -364,6 +463,17 @@ void ImageViewer::createMenu() {
     menuBar->addMenu(viewMenu);
     menuBar->addMenu(processingMenu);
 
+    // --- Macro Menu ---
+    QMenu *macroMenu = new QMenu("Macro", this);
+    QAction *recordMacroAction = new QAction("Record Macro", this);
+    recordMacroAction->setCheckable(true);
+    connect(recordMacroAction, &QAction::toggled, this, &ImageViewer::toggleMacroRecording);
+    macroMenu->addAction(recordMacroAction);
+    QAction *runMacroAction = new QAction("Run Macro...", this);
+    connect(runMacroAction, &QAction::triggered, this, &ImageViewer::runMacroFromFile);
+    macroMenu->addAction(runMacroAction);
+    menuBar->addMenu(macroMenu);
+
     mainLayout->setMenuBar(menuBar);
 
     updateOperationsEnabledState();
@@ -381,56 +491,24 @@ void ImageViewer::updateOperationsEnabledState() {
     ImageType type = ImageType::None;
 
     if (!originalImage.empty()) {
-        // Step 1: Handle 4-channel images (e.g., RGBA)
-        if (originalImage.channels() == 4) {
-            std::vector<cv::Mat> channels(4);
-            cv::split(originalImage, channels);
-
-            // Check if the alpha channel is all zeros
-            if (cv::countNonZero(channels[3]) == 0) {
-                // Discard the alpha channel
-                cv::merge(std::vector<cv::Mat>{channels[0], channels[1], channels[2]}, originalImage);
-            }
+        // Images are never modified in place, so a classification holds until originalImage is replaced
+        const bool classified = classifiedImage.data == originalImage.data && classifiedImage.size() == originalImage.size()
+                                && classifiedImage.type() == originalImage.type() && classifiedImage.step == originalImage.step;
+        if (!classified) {
+            // Only classified here: redundant channels were already dropped when the image was adopted
+            classifiedImage = originalImage;
+            classifiedBinary = ImageProcessing::analyzeContent(originalImage).binary;
         }
 
-        // Step 2: Check if it's a grayscale image (all channels are equal)
-        if (originalImage.channels() == 3) {
-            std::vector<cv::Mat> channels(3);
-            cv::split(originalImage, channels);
-
-            // Check if all three channels are exactly the same
-            cv::Mat cmp1, cmp2;
-            cv::compare(channels[0], channels[1], cmp1, cv::CMP_NE); // Non-equal comparison
-            cv::compare(channels[0], channels[2], cmp2, cv::CMP_NE);
-
-            if (cv::countNonZero(cmp1) == 0 && cv::countNonZero(cmp2) == 0) {
-                // All channels are the same, convert to single-channel grayscale
-                originalImage = channels[0];
-            }
-        }
-
-
-        // Step 3: Classify the image
         if (originalImage.channels() == 1) {
-            // Check if binary or grayscale
-            cv::Mat diff1 = (originalImage != 0);
-            cv::Mat diff2 = (originalImage != 255);
-            cv::Mat nonBinaryPixels = diff1 & diff2;
-            if (cv::countNonZero(nonBinaryPixels) == 0) {
-                type = ImageType::Binary;
-            } else {
-                type = ImageType::Grayscale;
-            }
+            type = classifiedBinary ? ImageType::Binary : ImageType::Grayscale;
         } else if (originalImage.channels() == 3) {
             type = ImageType::Color;
         } else if (originalImage.channels() == 4) {
             type = ImageType::RGBA;
-        } else {
-            type = ImageType::None;
         }
     }
 
-
     // Update registered operations
     for (ImageOperation* op : operationsList) {
         if(op) op->updateActionState(type);
@@ -456,13 +534,37 @@ void ImageViewer::updateOperationsEnabledState() {
 }
 
 
+// Classifies an image about to become the viewer's image (on opening or as an operation result), discarding
+// an all-zero alpha channel and collapsing color images whose channels are all equal. Done before the image
+// enters the history, so the history and the display always hold the same image.
+cv::Mat ImageViewer::adoptImage(const cv::Mat &image) {
+    if (image.empty()) return image;
+    const ImageProcessing::ImageContent content = ImageProcessing::analyzeContent(image);
+    cv::Mat adopted = image;
+    if (content.alphaUnused) {
+        cv::Mat color;
+        cv::cvtColor(adopted, color, cv::COLOR_BGRA2BGR);
+        adopted = color;
+    }
+    if (content.channelsEqual && adopted.channels() == 3) {
+        cv::Mat gray;
+        cv::extractChannel(adopted, gray, 0);
+        adopted = gray;
+    }
+    // The first channel is kept either way, so the binary flag still holds
+    classifiedImage = adopted;
+    classifiedBinary = content.binary;
+    return adopted;
+}
+
+
 // ======================================================================
 // `Internal UI Update Helpers`
 // ======================================================================
 // Updates the displayed pixmap based on the original image and current scale. Also updates dependent UI elements.
 void ImageViewer::updateImage() {
     if (originalImage.empty()) {
-        imageLabel->clear();
+        imageCanvas->clear();
         setWindowTitle("Image Viewer");
         updateOperationsEnabledState();
         if (histogramWindow) histogramWindow->computeHistogram(cv::Mat());
@@ -470,73 +572,44 @@ void ImageViewer::updateImage() {
         return;
     }
 
-    // --- Clamp currentScale to pyramid-friendly values if pyramid is active ---
-    if (usePyramidScaling) {
-        static const std::vector<double> pyramidScales = {0.25, 0.5, 1.0, 2.0, 4.0};
-        auto closest = std::min_element(pyramidScales.begin(), pyramidScales.end(),
-                                        [=](double a, double b) {
-                                            return std::abs(currentScale - a) < std::abs(currentScale - b);
-                                        });
-        currentScale = *closest;
-    }
-
-    cv::Mat displayImage;
-    if (showingMaskMode && !drawnMask.empty() && drawnMask.size() == originalImage.size()) {
-        cv::Mat display;
+    // The mask is a separate layer of the canvas, blended per tile, so strokes only redraw what they touch
+    const bool overlayMask = showingMaskMode && !drawnMask.empty() && drawnMask.size() == originalImage.size();
+    imageCanvas->setOverlay(overlayMask ? drawnMask : cv::Mat());
 
-        if (originalImage.channels() == 4) {
-            cv::cvtColor(originalImage, display, cv::COLOR_BGRA2BGR);
-        } else if (originalImage.channels() == 1) {
-            cv::cvtColor(originalImage, display, cv::COLOR_GRAY2BGR);
-        } else {
-            display = originalImage.clone();
-        }
-
-        cv::Mat maskColored;
-        cv::cvtColor(drawnMask, maskColored, cv::COLOR_GRAY2BGR);
-        cv::addWeighted(display, 1.0, maskColored, 0.5, 0, display);
-        displayImage = display;
-    } else {
-        displayImage = originalImage.clone();
+    // Keep the image point at the centre of the viewport in place when zooming
+    const QScrollBar *hBar = scrollArea->horizontalScrollBar();
+    const QScrollBar *vBar = scrollArea->verticalScrollBar();
+    const bool zoomChanged = std::abs(currentScale - displayedScale) > 1e-9;
+    QPointF viewCenter;
+    if (displayedScale > 0) {
+        viewCenter = QPointF((hBar->value() + scrollArea->viewport()->width() / 2.0) / displayedScale,
+                             (vBar->value() + scrollArea->viewport()->height() / 2.0) / displayedScale);
     }
+    const QSize previousCanvasSize = imageCanvas->size();
 
+    // Either way only the visible tiles are resampled, when they are painted
+    bool displayed = false;
     if (usePyramidScaling) {
-        if (currentScale == 0.5) {
-            cv::pyrDown(displayImage, displayImage);
-        } else if (currentScale == 0.25) {
-            cv::pyrDown(displayImage, displayImage);
-            cv::pyrDown(displayImage, displayImage);
-        } else if (currentScale == 2.0) {
-            cv::pyrUp(displayImage, displayImage);
-        } else if (currentScale == 4.0) {
-            cv::pyrUp(displayImage, displayImage);
-            cv::pyrUp(displayImage, displayImage);
+        // The pyramid of the image is kept until the image changes
+        displayed = imageCanvas->setPyramid(originalPyramid(), currentScale);
+    } else {
+        if (!imagePyramid.isBuiltFrom(originalImage)) {
+            imagePyramid = ImagePyramid(); // Don't keep a stale image and its levels alive
         }
+        displayed = imageCanvas->setImage(originalImage, currentScale); // Only read from, never modified
     }
-
-
-    QImage qimg = MatToQImage(displayImage);
-    if (qimg.isNull()) {
+    if (!displayed) {
         QMessageBox::warning(this, "Display Error", "Failed to convert image format for display.");
-        imageLabel->clear();
         updateOperationsEnabledState();
         return;
     }
-
-    QPixmap pixmap;
-    if (usePyramidScaling) {
-        pixmap = QPixmap::fromImage(qimg);
-        // Already scaled, no additional scaling
-    } else {
-        int newWidth = std::max(1, static_cast<int>(std::round(qimg.width() * currentScale)));
-        int newHeight = std::max(1, static_cast<int>(std::round(qimg.height() * currentScale)));
-        pixmap = QPixmap::fromImage(qimg).scaled(newWidth, newHeight, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    displayedScale = currentScale;
+    if (zoomChanged || imageCanvas->size() != previousCanvasSize) {
+        fitWindowToImage();
     }
-
-    imageLabel->setPixmap(pixmap);
-    imageLabel->setFixedSize(pixmap.size());
-    if (!isMaximized() && !isFullScreen()) {
-        adjustSize();
+    if (zoomChanged) {
+        scrollArea->horizontalScrollBar()->setValue(static_cast<int>(viewCenter.x() * currentScale - scrollArea->viewport()->width() / 2.0));
+        scrollArea->verticalScrollBar()->setValue(static_cast<int>(viewCenter.y() * currentScale - scrollArea->viewport()->height() / 2.0));
     }
 
     updateHistogram();
@@ -549,6 +622,20 @@ void ImageViewer::updateImage() {
     if(selectingPoints) drawTemporaryPoints();
 }
 
+// Grows or shrinks the window so the whole image is visible, as far as the screen allows.
+void ImageViewer::fitWindowToImage() {
+    if (isMaximized() || isFullScreen()) return;
+    mainLayout->activate();
+
+    const int frame = 2 * scrollArea->frameWidth();
+    const QSize wanted = imageCanvas->size() + QSize(frame, frame);
+    QSize target = size() + (wanted - scrollArea->size());
+    if (const QScreen *currentScreen = screen()) {
+        target = target.boundedTo(currentScreen->availableGeometry().size() * 0.9);
+    }
+    resize(target.expandedTo(minimumSizeHint()));
+}
+
 // Updates the text in the zoom percentage input field.
 void ImageViewer::updateZoomLabel() {
     if (!zoomInput) return;
@@ -563,28 +650,19 @@ void ImageViewer::updateZoomLabel() {
 void ImageViewer::updateHistogram() {
     // Check if the histogram window pointer is valid (i.e., window exists)
     if (histogramWindow) {
-        // Ensure image is grayscale before computing histogram
-        cv::Mat grayImage;
-        if (originalImage.channels() == 1) {
-            grayImage = originalImage;
-            // Already grayscale/binary
-        } else if (originalImage.channels() >= 3) {
-            grayImage = ImageProcessing::convertToGrayscale(originalImage);
-        } else {
-            // Handle unexpected channel count - clear histogram
-            histogramWindow->computeHistogram(cv::Mat());
-            // Pass empty Mat
-            return;
-        }
+        // Counted once per image (color images by their grayscale version), shared with the LUT table
+        histogramWindow->setHistogram(originalHistogram());
+    }
+}
 
-        if (!grayImage.empty()) {
-            histogramWindow->computeHistogram(grayImage);
-        } else {
-            // Handle case where grayscale conversion failed
-            histogramWindow->computeHistogram(cv::Mat());
-            // Pass empty Mat
-        }
+const ImageProcessing::Histogram& ImageViewer::originalHistogram() {
+    const bool counted = histogramImage.data == originalImage.data && histogramImage.size() == originalImage.size()
+                         && histogramImage.type() == originalImage.type() && histogramImage.step == originalImage.step;
+    if (!counted) {
+        grayHistogram = ImageProcessing::computeGrayHistogram(originalImage);
+        histogramImage = originalImage;
     }
+    return grayHistogram;
 }
 
 // Updates the embedded QTableWidget (LUT) with histogram data for grayscale images.
@@ -608,15 +686,7 @@ void ImageViewer::updateHistogramTable() {
         return;
     }
 
-    std::vector<int> histogramDataVec(256, 0); // Use std::vector
-
-    // Calculate histogram directly (only for CV_8UC1)
-    for (int y = 0; y < originalImage.rows; ++y) {
-        const uchar* row_ptr = originalImage.ptr<uchar>(y);
-        for (int x = 0; x < originalImage.cols; ++x) {
-            histogramDataVec[row_ptr[x]]++;
-        }
-    }
+    const ImageProcessing::Histogram& histogramDataVec = originalHistogram();
     // Ensure correct column count
     for (int i = 0; i < 256; ++i) {
         QTableWidgetItem *item = LUT->item(0, i);
@@ -632,19 +702,16 @@ void ImageViewer::updateHistogramTable() {
 
 // Temporarily displays an image (scaled to current view) without adding to undo stack. Used for previews.
 void ImageViewer::showTempImage(const cv::Mat &temp) {
-    if (temp.empty() || !imageLabel) return;
+    if (temp.empty() || !imageCanvas) return;
     // Safety checks
 
-    QImage qimg = MatToQImage(temp);
-    if (qimg.isNull()) return;
-    // Scale temp image to fit current label size
-    int currentLabelWidth = imageLabel->width();
-    int currentLabelHeight = imageLabel->height();
-    if (currentLabelWidth <= 0 || currentLabelHeight <= 0) return; // Avoid division by zero if label isn't visible yet
+    // Scale temp image to fit current canvas size (it may be a reduced-resolution preview)
+    int currentCanvasWidth = imageCanvas->width();
+    if (currentCanvasWidth <= 0) return; // Avoid a zero scale if the canvas isn't visible yet
 
-    QPixmap scaledPixmap = QPixmap::fromImage(qimg).scaled(currentLabelWidth, currentLabelHeight, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-    imageLabel->setPixmap(scaledPixmap);
-    // DO NOT call adjustSize() or updateImage() here, it's temporary
+    imageCanvas->setOverlay(cv::Mat()); // Previews are shown without the mask, updateImage() restores it
+    imageCanvas->setImage(temp, static_cast<double>(currentCanvasWidth) / temp.cols);
+    // DO NOT call fitWindowToImage() or updateImage() here, it's temporary
 }
 
 // Draws currently selected points and lines/rectangles on a temporary image overlay.
@@ -687,7 +754,7 @@ void ImageViewer::drawTemporaryPoints() {
 void ImageViewer::onImageClicked(QMouseEvent* event) {
     if (magicWandMode) {
         QPoint clickPos = event->pos();
-        QSize pixmapSize = imageLabel->pixmap(Qt::ReturnByValue).size();
+        QSize pixmapSize = imageCanvas->size();
         if (pixmapSize.isEmpty()) return;
 
         double xScale = static_cast<double>(originalImage.cols) / pixmapSize.width();
@@ -695,9 +762,13 @@ void ImageViewer::onImageClicked(QMouseEvent* event) {
         int imgX = std::clamp(static_cast<int>(std::round(clickPos.x() * xScale)), 0, originalImage.cols - 1);
         int imgY = std::clamp(static_cast<int>(std::round(clickPos.y() * yScale)), 0, originalImage.rows - 1);
         // Wykonaj segmentację
-        cv::Mat mask = ImageProcessing::magicWandSegmentation(originalImage, cv::Point(imgX, imgY), 15);
+        ImageProcessing::MatResult mask = ImageProcessing::magicWandSegmentation(originalImage, cv::Point(imgX, imgY), 15);
         // tolerancja 15
-        showTempImage(mask * 255);
+        if (mask) {
+            showTempImage(mask.value() * 255);
+        } else {
+            showError(mask.error());
+        }
         // maska jako obraz binarny
 
         magicWandMode = false;
@@ -708,7 +779,7 @@ void ImageViewer::onImageClicked(QMouseEvent* event) {
     if (!selectingPoints || pointsToSelect <= 0 || originalImage.empty())
         return;
     QPoint clickPos = event->pos();
-    QSize pixmapSize = imageLabel->pixmap(Qt::ReturnByValue).size();
+    QSize pixmapSize = imageCanvas->size();
     if (pixmapSize.isEmpty()) return;
 
     double xScale = static_cast<double>(originalImage.cols) / pixmapSize.width();
@@ -729,13 +800,12 @@ void ImageViewer::onImageClicked(QMouseEvent* event) {
 }
 
 void ImageViewer::mousePressEvent(QMouseEvent* event) {
-    if (drawingMaskMode && event->button() == Qt::LeftButton && imageLabel && imageLabel->underMouse()) {
-        // Map position from ImageViewer widget coordinates to imageLabel coordinates
-        QPoint relativePos = imageLabel->mapFrom(this, event->pos());
+    if (drawingMaskMode && event->button() == Qt::LeftButton && imageCanvas && imageCanvas->underMouse()) {
+        // Map position from ImageViewer widget coordinates to imageCanvas coordinates
+        QPoint relativePos = imageCanvas->mapFrom(this, event->pos());
 
-        // Check if the mapped position is within the actual pixmap bounds displayed in the label
-        QPixmap currentPixmapPtr = imageLabel->pixmap();
-        if (!currentPixmapPtr.isNull() && currentPixmapPtr.rect().contains(relativePos)) {
+        // Check if the mapped position is within the displayed image
+        if (!imageCanvas->image().empty() && imageCanvas->rect().contains(relativePos)) {
             lastDrawPos = QPoint(); // Reset last position for the start of a new stroke
             drawOnMask(relativePos); // Draw the first point/circle
             event->accept(); // Indicate the event was handled
@@ -769,12 +839,11 @@ void ImageViewer::mouseReleaseEvent(QMouseEvent* event) {
 }
 
 void ImageViewer::mouseMoveEvent(QMouseEvent* event) {
-    if (drawingMaskMode && (event->buttons() & Qt::LeftButton) && imageLabel && imageLabel->underMouse()) {
-        QPoint relativePos = imageLabel->mapFrom(this, event->pos());
+    if (drawingMaskMode && (event->buttons() & Qt::LeftButton) && imageCanvas && imageCanvas->underMouse()) {
+        QPoint relativePos = imageCanvas->mapFrom(this, event->pos());
 
-        // Only draw if the cursor is over the displayed pixmap area
-        QPixmap currentPixmapPtr = imageLabel->pixmap();
-        if (!currentPixmapPtr.isNull() && currentPixmapPtr.rect().contains(relativePos)) {
+        // Only draw if the cursor is over the displayed image area
+        if (!imageCanvas->image().empty() && imageCanvas->rect().contains(relativePos)) {
             // Check if lastDrawPos is valid (mouse didn't leave/re-enter image)
             if (!lastDrawPos.isNull()) {
                 drawOnMask(relativePos);
@@ -803,6 +872,10 @@ void ImageViewer::mouseMoveEvent(QMouseEvent* event) {
 
 
 bool ImageViewer::eventFilter(QObject *watched, QEvent *event) {
+    if (scrollArea && watched == scrollArea->viewport() && event->type() == QEvent::Wheel) {
+        wheelEvent(static_cast<QWheelEvent *>(event));
+        return true;
+    }
     if (event->type() == QEvent::ToolTip) {
         QHelpEvent *helpEvent = static_cast<QHelpEvent *>(event);
         QMenu *menu = qobject_cast<QMenu *>(watched);
@@ -820,13 +893,10 @@ bool ImageViewer::eventFilter(QObject *watched, QEvent *event) {
 
 void ImageViewer::drawOnMask(const QPoint& widgetPos) {
     // Guard clauses
-    if (!drawingMaskMode || originalImage.empty() || drawnMask.empty() || widgetPos.isNull() || !imageLabel) return;
+    if (!drawingMaskMode || originalImage.empty() || drawnMask.empty() || widgetPos.isNull() || !imageCanvas) return;
 
-    QPixmap currentPixmap = imageLabel->pixmap(Qt::ReturnByValue);
-    if (currentPixmap.isNull()) return;
-
-    // Calculate scale factors based on the displayed pixmap size vs original image size
-    QSize pixmapSize = currentPixmap.size();
+    // Calculate scale factors based on the displayed image size vs original image size
+    QSize pixmapSize = imageCanvas->size();
     if (pixmapSize.width() == 0 || pixmapSize.height() == 0) return; // Prevent division by zero
 
     double xScale = static_cast<double>(originalImage.cols) / pixmapSize.width();
@@ -836,26 +906,33 @@ void ImageViewer::drawOnMask(const QPoint& widgetPos) {
     int imgX = std::clamp(static_cast<int>(std::round(widgetPos.x() * xScale)), 0, originalImage.cols - 1);
     int imgY = std::clamp(static_cast<int>(std::round(widgetPos.y() * yScale)), 0, originalImage.rows - 1);
     cv::Point current(imgX, imgY);
+    cv::Point previous = current;
 
     // Use lastDrawPos for drawing lines; handle initial point separately
     if (!lastDrawPos.isNull()) {
         // Convert previous widget position to image coordinates
         int lastImgX = std::clamp(static_cast<int>(std::round(lastDrawPos.x() * xScale)), 0, originalImage.cols - 1);
         int lastImgY = std::clamp(static_cast<int>(std::round(lastDrawPos.y() * yScale)), 0, originalImage.rows - 1);
-        cv::Point previous(lastImgX, lastImgY);
+        previous = cv::Point(lastImgX, lastImgY);
 
         // Draw line on the mask using currentBrushThickness
         // LINE_8 is generally faster for thicker lines, LINE_AA is anti-aliased
+        detachMask();
         cv::line(drawnMask, previous, current, cv::Scalar(255), currentBrushThickness, cv::LINE_8);
     } else {
         // For the very first point of a stroke, draw a filled circle to make it visible immediately
+        detachMask();
         cv::circle(drawnMask, current, currentBrushThickness / 2, cv::Scalar(255), /*thickness*/ -1, cv::LINE_8);
     }
 
     // Update last position *after* drawing for the next segment
     lastDrawPos = widgetPos;
 
-    updateImage();
+    // Redraw only the stroke's bounding box; the histogram and the rest of the view don't depend on the mask
+    const int reach = currentBrushThickness / 2 + 2;
+    const cv::Rect stroke = cv::boundingRect(std::vector<cv::Point>{previous, current});
+    imageCanvas->invalidateImageRect(cv::Rect(stroke.x - reach, stroke.y - reach,
+                                              stroke.width + 2 * reach, stroke.height + 2 * reach));
 }
 
 void ImageViewer::setBrushThickness(int thickness) {
@@ -984,13 +1061,35 @@ void ImageViewer::disableMaskDrawing() {
     }
 }
 
+ImageSnapshot ImageViewer::getDrawnMask() const {
+    if (!maskSnapshot.sharesBufferWith(drawnMask)) {
+        maskSnapshot = ImageSnapshot(drawnMask);
+    }
+    return maskSnapshot;
+}
+
+void ImageViewer::setDrawnMask(const ImageSnapshot &mask) {
+    maskSnapshot = mask;
+    drawnMask = mask.mat();
+}
+
+// Copy-on-write: the mask is copied only if a snapshot of its buffer is still held somewhere else
+// (a dialog, another viewer), otherwise drawing continues in place.
+void ImageViewer::detachMask() {
+    if (maskSnapshot.empty()) return;
+    if (maskSnapshot.sharesBufferWith(drawnMask) && maskSnapshot.isShared()) {
+        drawnMask = drawnMask.clone();
+        if (showingMaskMode) imageCanvas->setOverlay(drawnMask); // The canvas showed the old buffer
+    }
+    maskSnapshot = ImageSnapshot();
+}
+
 void ImageViewer::clearDrawnMask() {
     if (!drawnMask.empty()) {
+        detachMask();
         drawnMask.setTo(cv::Scalar(0)); // Set all pixels to 0
-        // If drawing mode is active, update the display immediately to show cleared mask
-        if (drawingMaskMode) {
-            updateImage();
-        }
+        // The canvas shares the mask, so redraw it wherever it is shown
+        imageCanvas->invalidateImageRect(cv::Rect(0, 0, drawnMask.cols, drawnMask.rows));
     }
 }
 
@@ -1015,28 +1114,14 @@ void ImageViewer::disableMaskShowing() {
 // Handles mouse wheel events for zooming the image.
 void ImageViewer::wheelEvent(QWheelEvent *event) {
     double oldScale = currentScale;
-    if (usePyramidScaling) {
-        // Only allow switching between 0.25, 0.5, 1.0, 2.0, 4.0
-        static const std::vector<double> pyramidScales = {0.25, 0.5, 1.0, 2.0, 4.0};
-        auto it = std::find(pyramidScales.begin(), pyramidScales.end(), currentScale);
-        if (it != pyramidScales.end()) {
-            if (event->angleDelta().y() > 0 && it + 1 != pyramidScales.end()) {
-                currentScale = *(it + 1);
-                // Zoom in
-            } else if (event->angleDelta().y() < 0 && it != pyramidScales.begin()) {
-                currentScale = *(it - 1);
-                // Zoom out
-            }
-        }
+    // Any zoom level works in pyramid mode too: the two nearest levels are blended
+    const double scaleFactor = 1.15;
+    if (event->angleDelta().y() > 0) {
+        currentScale *= scaleFactor;
     } else {
-        const double scaleFactor = 1.15;
-        if (event->angleDelta().y() > 0) {
-            currentScale *= scaleFactor;
-        } else {
-            currentScale /= scaleFactor;
-        }
-        currentScale = qBound(0.1, currentScale, 5.0);
+        currentScale /= scaleFactor;
     }
+    currentScale = qBound(0.1, currentScale, 5.0);
 
     if (std::abs(currentScale - oldScale) > 1e-6) {
         updateImage();
@@ -1049,53 +1134,222 @@ void ImageViewer::wheelEvent(QWheelEvent *event) {
 // ======================================================================
 // `Undo/Redo Management`
 // ======================================================================
-// Pushes the current image state onto the undo stack.
-void ImageViewer::pushToUndoStack() {
-    if (!originalImage.empty()) {
-        // Consider using QStack for potentially better Qt integration, though std::stack is fine
-        const int MAX_UNDO_LEVELS = 20;
-        // Keep limit reasonable
-        // If using std::stack, we need to manage the size manually if a limit is desired
-        if (undoStack.size() >= MAX_UNDO_LEVELS) {
-            // To implement a limit with stack, we'd need to pop from the "bottom",
-            // which stack doesn't support.
-            // Easiest is to use std::deque or QQueue/QStack
-            // Or just let it grow, assuming memory isn't a huge concern for typical use.
-            qWarning() << "Undo stack limit potentially exceeded. Oldest states not automatically removed.";
+// Reverts to the previous image state from the undo history.
+void ImageViewer::undo() {
+    if (isOperationRunning()) return; // The running operation will commit on top of the current state
+    if (history.canUndo()) {
+        const cv::Mat previous = history.undo(originalImage);
+        if (previous.empty()) {
+            QMessageBox::warning(this, "Undo Error", "The previous image state could not be restored.");
+            return;
         }
-        undoStack.push(originalImage.clone());
-        clearRedoStack();
-        // Clear redo whenever a new action is performed
+        originalImage = previous;
+        if (recordingMacro && !macroSteps.isEmpty()) undoneMacroSteps.append(macroSteps.takeLast());
+        updateImage();
     }
 }
 
-// Reverts to the previous image state from the undo stack.
-void ImageViewer::undo() {
-    if (!undoStack.empty()) {
-        redoStack.push(originalImage.clone());
-        // Push current state to redo
-        originalImage = undoStack.top();
-        undoStack.pop();
+// Re-applies an undone image state from the undo history.
+void ImageViewer::redo() {
+    if (isOperationRunning()) return;
+    if (history.canRedo()) {
+        const cv::Mat next = history.redo(originalImage);
+        if (next.empty()) {
+            QMessageBox::warning(this, "Redo Error", "The next image state could not be restored.");
+            return;
+        }
+        originalImage = next;
+        if (recordingMacro && !undoneMacroSteps.isEmpty()) macroSteps.append(undoneMacroSteps.takeLast());
         updateImage();
     }
 }
 
-// Re-applies an undone image state from the redo stack.
-void ImageViewer::redo() {
-    if (!redoStack.empty()) {
-        undoStack.push(originalImage.clone());
-        // Push current state to undo
-        originalImage = redoStack.top();
-        redoStack.pop();
-        updateImage();
+// Applies the undo memory settings chosen in the main window.
+void ImageViewer::setUndoMemoryBudget(size_t bytes) {
+    history.setBudget(bytes, originalImage);
+}
+
+void ImageViewer::setUndoSpillDirectory(const QString& directory) {
+    history.setSpillDirectory(directory);
+}
+
+// Replaces the image with a successful operation result (recording undo state),
+// or shows the operation's error and leaves the image untouched.
+bool ImageViewer::commitResult(const ImageProcessing::MatResult& result, const QVector<PipelineStep>& steps) {
+    if (!result) {
+        showError(result.error());
+        return false;
+    }
+    // The previous image is shared with the history, not copied; images are never modified in place
+    const cv::Mat next = adoptImage(result.value());
+    history.push(originalImage, next);
+    originalImage = next;
+    if (recordingMacro) {
+        macroSteps.append(steps); // Kept even when empty, so undo stays aligned with the history
+        undoneMacroSteps.clear();
+    }
+    updateImage();
+    return true;
+}
+
+// Shows an operation error reported by ImageProcessing.
+void ImageViewer::showError(const ImageProcessing::Error& error) {
+    QMessageBox::warning(this, QString::fromStdString(error.title), QString::fromStdString(error.message));
+}
+
+
+// ======================================================================
+// `Macros`
+// ======================================================================
+// Starts recording committed operations, or stops and offers to save them as a pipeline file.
+void ImageViewer::toggleMacroRecording(bool recording) {
+    if (recording) {
+        macroSteps.clear();
+        undoneMacroSteps.clear();
+        recordingMacro = true;
+        return;
+    }
+    recordingMacro = false;
+
+    ProcessingPipeline pipeline;
+    int unrecorded = 0;
+    for (const QVector<PipelineStep>& steps : std::as_const(macroSteps)) {
+        if (steps.isEmpty()) ++unrecorded;
+        for (const PipelineStep& step : steps) pipeline.append(step);
+    }
+    macroSteps.clear();
+    undoneMacroSteps.clear();
+    if (pipeline.isEmpty()) {
+        QMessageBox::information(this, "Record Macro", "No recordable operations were applied.");
+        return;
+    }
+    if (unrecorded > 0) {
+        QMessageBox::warning(this, "Record Macro",
+                             QString("%1 operation(s) depend on other images, masks or selected points "
+                                     "and were left out of the macro.").arg(unrecorded));
+    }
+
+    const QString filePath = QFileDialog::getSaveFileName(this, "Save Macro", "", "Pipelines (*.txt);;All Files (*)");
+    if (filePath.isEmpty()) return;
+    QString error;
+    if (!pipeline.save(filePath, &error)) {
+        QMessageBox::critical(this, "Save Error", error);
+    }
+}
+
+// Loads a pipeline file and replays it on this image.
+void ImageViewer::runMacroFromFile() {
+    const QString filePath = QFileDialog::getOpenFileName(this, "Run Macro", "", "Pipelines (*.txt);;All Files (*)");
+    if (filePath.isEmpty()) return;
+    ProcessingPipeline pipeline;
+    QString error;
+    if (!pipeline.load(filePath, &error)) {
+        QMessageBox::warning(this, "Macro Error", error);
+        return;
+    }
+    runMacro(pipeline);
+}
+
+// Runs the whole pipeline as one background operation: a single undo step, recorded as its steps.
+// Unless disabled in the main window, the optimized pipeline runs (fused filters, dropped no-op pairs),
+// while the original steps are recorded.
+void ImageViewer::runMacro(const ProcessingPipeline& pipeline) {
+    if (originalImage.empty() || pipeline.isEmpty()) return;
+    const ProcessingPipeline replayed = mainWindow && mainWindow->isMacroOptimizationEnabled() ? pipeline.optimized() : pipeline;
+    runOperation("Macro", [image = originalImage, replayed](ImageProcessing::OperationProgress&) -> ImageProcessing::MatResult {
+        QString error;
+        cv::Mat result = replayed.run(image, &error);
+        if (result.empty()) return ImageProcessing::Error{"Macro Error", error.toStdString()};
+        return result;
+    }, pipeline.steps());
+}
+
+QString ImageViewer::borderParameter() {
+    return ProcessingPipeline::borderName(mainWindow ? mainWindow->getBorderOption() : cv::BORDER_DEFAULT);
+}
+
+
+// ======================================================================
+// `Background Operations`
+// ======================================================================
+// Starts a job on the thread pool; the result is committed (with undo) once it finishes.
+void ImageViewer::runOperation(const QString& name, ImageJob job, const QVector<PipelineStep>& steps) {
+    const QString title = name.isEmpty() ? QString("Operation") : name;
+    if (isOperationRunning()) {
+        QMessageBox::information(this, title, "Another operation is still running in this window.");
+        return;
+    }
+    if (operationRunner->start(std::move(job))) {
+        runningSteps = steps;
+        setBusy(true, title);
+    }
+}
+
+bool ImageViewer::isOperationRunning() const {
+    return operationRunner && operationRunner->isRunning();
+}
+
+// Queues a preview job. Requests arriving within the timer interval are coalesced into the last one.
+void ImageViewer::schedulePreview(ImageJob job) {
+    pendingPreviewJob = std::move(job);
+    ++previewGeneration;
+    previewTimer->start();
+}
+
+// Invalidates every requested preview so no late result overwrites the view.
+void ImageViewer::cancelPreview() {
+    ++previewGeneration;
+    pendingPreviewJob = nullptr;
+    if (previewTimer) previewTimer->stop();
+    if (previewRunner) previewRunner->cancel();
+}
+
+// Previews are shown scaled to the zoom anyway, so they are computed on the pyramid level
+// closest to the displayed size (never below 64 px). At 100% zoom and above, or when disabled
+// in the Options menu, the full image is used.
+PreviewSource ImageViewer::previewSource() {
+    if (!mainWindow || !mainWindow->isProxyPreviewEnabled() || currentScale >= 1.0) {
+        return PreviewSource{originalImage, 1.0};
+    }
+    const ImagePyramid& pyramid = originalPyramid();
+    int level = pyramid.levelFor(currentScale);
+    while (level > 0 && std::min(pyramid.level(level).cols, pyramid.level(level).rows) < 64) {
+        --level;
+    }
+    if (level == 0) {
+        return PreviewSource{originalImage, 1.0};
+    }
+    // pyrDown rounds odd sizes up, so use the real ratio rather than 2^-level
+    const cv::Mat& proxy = pyramid.level(level);
+    return PreviewSource{proxy, static_cast<double>(proxy.cols) / originalImage.cols};
+}
+
+// The pyramid of originalImage, rebuilt only when the image has changed since it was built.
+const ImagePyramid& ImageViewer::originalPyramid() {
+    if (!imagePyramid.isBuiltFrom(originalImage)) {
+        imagePyramid = ImagePyramid(originalImage);
+    }
+    return imagePyramid;
+}
+
+void ImageViewer::startPendingPreview() {
+    if (!pendingPreviewJob) return;
+    if (previewRunner->isRunning()) {
+        // The running preview is already stale; it restarts us from its finished/cancelled handler
+        previewRunner->cancel();
+        return;
     }
+    runningPreviewGeneration = previewGeneration;
+    previewRunner->start(std::move(pendingPreviewJob));
+    pendingPreviewJob = nullptr;
 }
 
-// Clears the redo stack.
-void ImageViewer::clearRedoStack() {
-    // Use QStack's clear() or std::stack's loop pop
-    while (!redoStack.empty()) redoStack.pop();
-    // redoStack.clear(); // If using QStack
+// Shows or hides the progress row and locks the menus while an operation is running.
+void ImageViewer::setBusy(bool busy, const QString& operationName) {
+    menuBar->setEnabled(!busy);
+    progressBar->setValue(0);
+    progressBar->setFormat(operationName + " %p%");
+    progressPanel->setVisible(busy);
 }
 
 
@@ -1109,16 +1363,15 @@ void ImageViewer::duplicateImage() {
     QString newTitle = QString("%1 - Copy %2").arg(this->windowTitle()).arg(duplicateCount++);
     // Use this->windowTitle()
     QPoint newPos = this->pos() + QPoint(150, 150);
-    ImageViewer *newViewer = new ImageViewer(originalImage.clone(),
+    ImageViewer *newViewer = new ImageViewer(originalImage, // Shared: viewers never modify images in place
                                              newTitle, nullptr, // Parent is null for new top-level window
                                              newPos, mainWindow);
     newViewer->setZoom(currentScale); // Apply current zoom to duplicate
     newViewer->show();
-    newViewer->undoStack = std::stack<cv::Mat>(undoStack);
-    newViewer->redoStack = std::stack<cv::Mat>(redoStack);
+    newViewer->history = history; // Shares the stored states with this viewer
     newViewer->setBrushThickness(currentBrushThickness);
     newViewer->setUsePyramidScaling(usePyramidScaling);
-    newViewer->drawnMask = drawnMask;
+    newViewer->setDrawnMask(getDrawnMask()); // Shared until either viewer draws into it
     newViewer->lastDrawPos = lastDrawPos;
     newViewer->updateImage();
 }
@@ -1130,7 +1383,7 @@ void ImageViewer::drawMask() {
     inpaintDialog->show();
 
     connect(inpaintDialog, &InpaintingDialog::maskChanged, this, [=]() {
-        drawnMask = inpaintDialog->getSelectedMask();
+        setDrawnMask(inpaintDialog->getSelectedMask());
         updateImage();
     });
 
@@ -1150,149 +1403,27 @@ void ImageViewer::drawMask() {
 }
 
 
-std::vector<std::pair<uchar, uchar>> compressRLE(const cv::Mat& image) {
-    std::vector<std::pair<uchar, uchar>> rleData;
-
-    const uchar* data = image.ptr<uchar>(0);
-    int totalPixels = image.rows * image.cols;
-
-    uchar current = data[0];
-    uchar runLength = 1;
-
-    for (int i = 1; i < totalPixels; ++i) {
-        if (data[i] == current && runLength < 255) {
-            ++runLength;
-        } else {
-            rleData.emplace_back(current, runLength);
-            current = data[i];
-            runLength = 1;
-        }
-    }
-    rleData.emplace_back(current, runLength);
-
-    return rleData;
-}
-
-
-std::vector<std::pair<cv::Vec3b, uchar>> compressColorRLE(const cv::Mat& image) {
-    std::vector<std::pair<cv::Vec3b, uchar>> rleData;
-
-    const cv::Vec3b* data = image.ptr<cv::Vec3b>(0);
-    int totalPixels = image.rows * image.cols;
-
-    cv::Vec3b current = data[0];
-    uchar runLength = 1;
-
-    for (int i = 1; i < totalPixels; ++i) {
-        if (data[i] == current && runLength < 255) {
-            ++runLength;
-        } else {
-            rleData.emplace_back(current, runLength);
-            current = data[i];
-            runLength = 1;
-        }
-    }
-    rleData.emplace_back(current, runLength); // last run
-
-    return rleData;
-}
-
-
-bool saveRLEToFile(const std::vector<std::pair<uchar, uchar>>& rleData,
-                   const QString& filePath, int width, int height) {
-    QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly)) return false;
-
-    QDataStream out(&file);
-    out.setByteOrder(QDataStream::LittleEndian);
-
-    // Write header: 'GRE' + width + height
-    out.writeRawData("GRE", 3);
-    out.writeRawData(reinterpret_cast<const char*>(&width), sizeof(int));
-    out.writeRawData(reinterpret_cast<const char*>(&height), sizeof(int));
-
-    // Write RLE data
-    for (const auto& [val, count] : rleData) {
-        out.writeRawData(reinterpret_cast<const char*>(&val), 1);    // gray value
-        out.writeRawData(reinterpret_cast<const char*>(&count), 1);  // count
-    }
-
-    return true;
-}
-
-
-bool saveColorRLEToFile(const std::vector<std::pair<cv::Vec3b, uchar>>& rleData,
-                        const QString& filePath, int width, int height) {
-    QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly)) return false;
-
-    QDataStream out(&file);
-    out.setByteOrder(QDataStream::LittleEndian);
-
-    // Write header: 'COL' + width + height (both as 32-bit ints)
-    out.writeRawData("COL", 3);
-    out.writeRawData(reinterpret_cast<const char*>(&width), sizeof(int));
-    out.writeRawData(reinterpret_cast<const char*>(&height), sizeof(int));
-
-    // Write RLE data
-    for (const auto& [val, count] : rleData) {
-        out.writeRawData(reinterpret_cast<const char*>(&val[0]), 3); // B, G, R
-        out.writeRawData(reinterpret_cast<const char*>(&count), 1);  // 1 byte count
-    }
-
-    return true;
-}
-
-
-
-
-double computeCompressionRatio(const cv::Mat& original, const std::vector<std::pair<uchar, uchar>>& rleData) {
-    int originalSize = original.rows * original.cols;
-    int compressedSize = rleData.size() * 2;
-    return static_cast<double>(originalSize) / compressedSize;
-}
-
-double computeColorCompressionRatio(const cv::Mat& original, const std::vector<std::pair<cv::Vec3b, uchar>>& rleData) {
-    int originalSize = original.rows * original.cols * 3;
-    int compressedSize = rleData.size() * 4;
-    return static_cast<double>(originalSize) / compressedSize;
-}
-
 // Opens a file dialog to save the current image.
 void ImageViewer::saveImageAs() {
     QString filePath = QFileDialog::getSaveFileName(this, "Save Image As", "",
                                                     "Images (*.png *.jpg *.jpeg *.bmp *.gif *.tiff *.rle)");
     if (filePath.isEmpty()) return;
 
-#ifdef _WIN32
-    std::string path = filePath.toLocal8Bit().constData();
-#else
-    std::string path = filePath.toUtf8().constData();
-#endif
-
     std::vector<int> compression_params;
 
     if (filePath.endsWith(".rle", Qt::CaseInsensitive)) {
-        if (originalImage.channels() == 1) {
-            auto rleData = compressRLE(originalImage);
-            double sk = computeCompressionRatio(originalImage, rleData);
-            if (!saveRLEToFile(rleData, filePath, originalImage.cols, originalImage.rows)) {
-                QMessageBox::critical(this, "Save Error", "Could not save grayscale RLE data to file.");
-            } else {
-                QMessageBox::information(this, "Compression Done",
-                                         QString("Grayscale image compressed.\nCompression ratio: %1").arg(sk, 0, 'f', 2));
-            }
-        } else if (originalImage.channels() == 3) {
-            auto rleData = compressColorRLE(originalImage);
-            double sk = computeColorCompressionRatio(originalImage, rleData);
-            if (!saveColorRLEToFile(rleData, filePath, originalImage.cols, originalImage.rows)) {
-                QMessageBox::critical(this, "Save Error", "Could not save color RLE data to file.");
-            } else {
-                QMessageBox::information(this, "Compression Done",
-                                         QString("Color image compressed.\nCompression ratio: %1").arg(sk, 0, 'f', 2));
-            }
+        if (!RleCodec::canEncode(originalImage)) {
+            QMessageBox::warning(this, "Unsupported Format", "Only 8-bit grayscale, color and color with alpha images are supported for RLE.");
+            return;
+        }
+        qint64 encodedBytes = 0;
+        QString error;
+        if (!RleCodec::write(originalImage, filePath, &encodedBytes, &error)) {
+            QMessageBox::critical(this, "Save Error", "Could not save RLE data to file: " + error);
         } else {
-            QMessageBox::warning(this, "Unsupported Format", "Only grayscale and 3-channel color images are supported for RLE.");
+            const double ratio = static_cast<double>(originalImage.total() * originalImage.elemSize()) / encodedBytes;
+            QMessageBox::information(this, "Compression Done",
+                                     QString("Image compressed.\nCompression ratio: %1").arg(ratio, 0, 'f', 2));
         }
         return;
     }
@@ -1306,12 +1437,24 @@ void ImageViewer::saveImageAs() {
         compression_params.push_back(3);
     }
 
+    // Encoded in memory and swapped in atomically: a failed save leaves the old file intact, and a batch run
+    // reading the target through a mapping (ImageFile::loadView) never sees it truncated in place
+    std::vector<uchar> buffer;
     try {
-        if (!cv::imwrite(path, originalImage, compression_params)) {
-            QMessageBox::warning(this, "Save Error", "Failed to save the image. Check file path and permissions.");
+        if (!cv::imencode("." + QFileInfo(filePath).suffix().toStdString(), originalImage, buffer, compression_params)) {
+            QMessageBox::warning(this, "Save Error", "Failed to encode the image in this format.");
+            return;
         }
     } catch (const cv::Exception& ex) {
         QMessageBox::critical(this, "OpenCV Save Error", QString("Error saving image: %1").arg(ex.what()));
+        return;
+    }
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)
+        || file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<qint64>(buffer.size())) != static_cast<qint64>(buffer.size())
+        || !file.commit()) {
+        QMessageBox::warning(this, "Save Error", "Failed to save the image: " + file.errorString());
     }
 }
 
@@ -1321,23 +1464,17 @@ void ImageViewer::saveImageAs() {
 // ======================================================================
 // Converts the current image to grayscale.
 void ImageViewer::convertToGrayscale() {
-    pushToUndoStack();
-    originalImage = ImageProcessing::convertToGrayscale(originalImage);
-    updateImage();
+    commitResult(ImageProcessing::convertToGrayscale(originalImage), macroStep("convertToGrayscale"));
 }
 
 
 void ImageViewer::removeAlphaChannel() {
-    pushToUndoStack();
-    originalImage = ImageProcessing::removeAlphaChannel(originalImage);
-    updateImage();
+    commitResult(ImageProcessing::removeAlphaChannel(originalImage), macroStep("removeAlphaChannel"));
 }
 
 // Converts the current grayscale image to binary using a default threshold.
 void ImageViewer::binarise() {
-    pushToUndoStack();
-    originalImage = ImageProcessing::binarise(originalImage);
-    updateImage();
+    commitResult(ImageProcessing::binarise(originalImage), macroStep("binarise"));
 }
 
 // Splits a color image into its B, G, R channels, displaying each in a new window.
@@ -1393,16 +1530,12 @@ void ImageViewer::convertToLab() {
 // ======================================================================
 // Applies histogram stretching to the grayscale image.
 void ImageViewer::stretchHistogram() {
-    pushToUndoStack();
-    originalImage = ImageProcessing::stretchHistogram(originalImage);
-    updateImage();
+    commitResult(ImageProcessing::stretchHistogram(originalImage), macroStep("stretchHistogram"));
 }
 
 // Applies histogram equalization to the grayscale image.
 void ImageViewer::equalizeHistogram() {
-    pushToUndoStack();
-    originalImage = ImageProcessing::equalizeHistogram(originalImage);
-    updateImage();
+    commitResult(ImageProcessing::equalizeHistogram(originalImage), macroStep("equalizeHistogram"));
 }
 
 
@@ -1411,17 +1544,20 @@ void ImageViewer::equalizeHistogram() {
 // ======================================================================
 // Applies negation (inversion) to the grayscale image.
 void ImageViewer::applyNegation() {
-    pushToUndoStack();
-    originalImage = ImageProcessing::applyNegation(originalImage);
-    updateImage();
+    commitResult(ImageProcessing::applyNegation(originalImage), macroStep("applyNegation"));
 }
 
 // Opens a dialog for applying range stretching to the grayscale image.
 void ImageViewer::rangeStretching() {
     RangeStretchingDialog dialog(this);
-    setupPreview(&dialog, dialog.getPreviewCheckBox(), [&]() {
-        return ImageProcessing::applyRangeStretching(originalImage, dialog.getP1(),
-                                                     dialog.getP2(), dialog.getQ3(), dialog.getQ4());
+    setupPreview(&dialog, dialog.getPreviewCheckBox(), [&](const PreviewSource& source) -> ImageJob {
+        return [image = source.image, p1 = dialog.getP1(), p2 = dialog.getP2(),
+                q3 = dialog.getQ3(), q4 = dialog.getQ4()](ImageProcessing::OperationProgress&) {
+            return ImageProcessing::applyRangeStretching(image, p1, p2, q3, q4);
+        };
+    }, [&]() {
+        return macroStep("applyRangeStretching", {{"p1", QString::number(dialog.getP1())}, {"p2", QString::number(dialog.getP2())},
+                                                  {"q3", QString::number(dialog.getQ3())}, {"q4", QString::number(dialog.getQ4())}});
     });
     dialog.exec();
 }
@@ -1433,8 +1569,31 @@ void ImageViewer::applyPosterization() {
     levelSpin->setRange(2, 256);
     levelSpin->setValue(4);
     dialog.addInput("Levels", levelSpin);
-    setupPreview(&dialog, dialog.getPreviewCheckBox(), [&]() {
-        return ImageProcessing::applyPosterization(originalImage, dialog.getValue("Levels").toInt());
+    setupPreview(&dialog, dialog.getPreviewCheckBox(), [&](const PreviewSource& source) -> ImageJob {
+        return [image = source.image, levels = dialog.getValue("Levels").toInt()](ImageProcessing::OperationProgress&) {
+            return ImageProcessing::applyPosterization(image, levels);
+        };
+    }, [&]() {
+        return macroStep("applyPosterization", {{"levels", dialog.getValue("Levels").toString()}});
+    });
+
+    dialog.exec();
+}
+
+// Opens a dialog for applying gamma correction to the image.
+void ImageViewer::applyGammaCorrection() {
+    InputDialog dialog(this);
+    auto *gammaSpin = new QDoubleSpinBox;
+    gammaSpin->setRange(0.1, 10.0);
+    gammaSpin->setSingleStep(0.1);
+    gammaSpin->setValue(1.0);
+    dialog.addInput("Gamma", gammaSpin);
+    setupPreview(&dialog, dialog.getPreviewCheckBox(), [&](const PreviewSource& source) -> ImageJob {
+        return [image = source.image, gamma = dialog.getValue("Gamma").toDouble()](ImageProcessing::OperationProgress&) {
+            return ImageProcessing::applyGammaCorrection(image, gamma);
+        };
+    }, [&]() {
+        return macroStep("applyGammaCorrection", {{"gamma", QString::number(dialog.getValue("Gamma").toDouble(), 'g', 9)}});
     });
 
     dialog.exec();
@@ -1444,8 +1603,12 @@ void ImageViewer::applyPosterization() {
 void ImageViewer::applyBitwiseOperation() {
     if (originalImage.empty() || !mainWindow) return;
     BitwiseOperationDialog dialog(this, mainWindow->openedImages);
-    setupPreview(&dialog, dialog.getPreviewCheckBox(), [&]() {
-        return dialog.getResult();
+    setupPreview(&dialog, dialog.getPreviewCheckBox(), [&](const PreviewSource&) -> ImageJob {
+        // The dialog computes its result itself; the job only hands it over
+        return [result = dialog.getResult()](ImageProcessing::OperationProgress&) -> ImageProcessing::MatResult {
+            if (result.empty()) return ImageProcessing::Error{"Bitwise Operation", "No result was computed."};
+            return result;
+        };
     });
     dialog.exec();
 }
@@ -1579,8 +1742,12 @@ void ImageViewer::applyGlobalThreshold() {
     levelSpin->setRange(0, 255);
     levelSpin->setValue(128);
     dialog.addInput("Threshold", levelSpin);
-    setupPreview(&dialog, dialog.getPreviewCheckBox(), [&]() {
-        return ImageProcessing::applyGlobalThreshold(originalImage, dialog.getValue("Threshold").toInt());
+    setupPreview(&dialog, dialog.getPreviewCheckBox(), [&](const PreviewSource& source) -> ImageJob {
+        return [image = source.image, threshold = dialog.getValue("Threshold").toInt()](ImageProcessing::OperationProgress&) {
+            return ImageProcessing::applyGlobalThreshold(image, threshold);
+        };
+    }, [&]() {
+        return macroStep("applyGlobalThreshold", {{"threshold", dialog.getValue("Threshold").toString()}});
     });
 
     dialog.exec();
@@ -1588,16 +1755,12 @@ void ImageViewer::applyGlobalThreshold() {
 
 // Applies adaptive thresholding to the grayscale image.
 void ImageViewer::applyAdaptiveThreshold() {
-    pushToUndoStack();
-    originalImage = ImageProcessing::applyAdaptiveThreshold(originalImage);
-    updateImage();
+    commitResult(ImageProcessing::applyAdaptiveThreshold(originalImage), macroStep("applyAdaptiveThreshold"));
 }
 
 // Applies Otsu's thresholding to the grayscale image.
 void ImageViewer::applyOtsuThreshold() {
-    pushToUndoStack();
-    originalImage = ImageProcessing::applyOtsuThreshold(originalImage);
-    updateImage();
+    commitResult(ImageProcessing::applyOtsuThreshold(originalImage), macroStep("applyOtsuThreshold"));
 }
 
 // Activates magic wand mode for a single click selection.
@@ -1633,24 +1796,27 @@ void ImageViewer::applyMagicWandSegmentation() {
             modesCombo->addItems({"Mask", "Masked image"});
             dialog.addInput("Output mode", modesCombo);
 
-            setupPreview(&dialog, dialog.getPreviewCheckBox(), [&]() {
-                cv::Mat previewSource;
-
-                if (originalImage.channels() == 4) {
-                    cv::cvtColor(originalImage, previewSource, cv::COLOR_BGRA2BGR);
-                }
-                else {
-                    previewSource = originalImage.clone();
-                }
-                cv::Mat mask = ImageProcessing::magicWandSegmentation(originalImage, selectedPoints[0], dialog.getValue("Tolerance").toInt());
-                if(dialog.getValue("Output mode").toString() == "Masked image") {
+            setupPreview(&dialog, dialog.getPreviewCheckBox(), [&](const PreviewSource& source) -> ImageJob {
+                const bool maskedOutput = dialog.getValue("Output mode").toString() == "Masked image";
+                const cv::Point seed(std::min(static_cast<int>(selectedPoints[0].x * source.scale), source.image.cols - 1),
+                                     std::min(static_cast<int>(selectedPoints[0].y * source.scale), source.image.rows - 1));
+                return [image = source.image, seed, tolerance = dialog.getValue("Tolerance").toInt(),
+                        maskedOutput](ImageProcessing::OperationProgress&) -> ImageProcessing::MatResult {
+                    ImageProcessing::MatResult mask = ImageProcessing::magicWandSegmentation(image, seed, tolerance);
+                    if (!mask || !maskedOutput) {
+                        return mask;
+                    }
+                    cv::Mat previewSource;
+                    if (image.channels() == 4) {
+                        cv::cvtColor(image, previewSource, cv::COLOR_BGRA2BGR);
+                    }
+                    else {
+                        previewSource = image;
+                    }
                     cv::Mat maskedImage = cv::Mat::zeros(previewSource.size(), previewSource.type());
-                    previewSource.copyTo(maskedImage, mask);
+                    previewSource.copyTo(maskedImage, mask.value());
                     return maskedImage;
-                }
-                else {
-                    return mask;
-                }
+                };
             });
 
             dialog.exec();
@@ -1687,7 +1853,7 @@ void ImageViewer::applyGrabCutSegmentation() {
             levelSpin->setValue(5);
             dialog.addInput("Iterations", levelSpin);
 
-            setupPreview(&dialog, dialog.getPreviewCheckBox(), [&]() {
+            setupPreview(&dialog, dialog.getPreviewCheckBox(), [&](const PreviewSource& source) -> ImageJob {
                 cv::Point p1 = selectedPoints[0];
                 cv::Point p2 = selectedPoints[1];
                 int x = std::min(p1.x, p2.x);
@@ -1695,8 +1861,13 @@ void ImageViewer::applyGrabCutSegmentation() {
                 int width = std::abs(p1.x - p2.x);
                 int height = std::abs(p1.y - p2.y);
                 cv::Rect rect(x, y, width, height);
-                return ImageProcessing::grabCutSegmentation(originalImage, rect, dialog.getValue("Iterations").toInt());
-
+                if (source.scale != 1.0) {
+                    rect = cv::Rect(cv::Point(cvRound(rect.x * source.scale), cvRound(rect.y * source.scale)),
+                                    cv::Point(cvRound(rect.br().x * source.scale), cvRound(rect.br().y * source.scale)));
+                }
+                return [image = source.image, rect, iterations = dialog.getValue("Iterations").toInt()](ImageProcessing::OperationProgress& progress) {
+                    return ImageProcessing::grabCutSegmentation(image, rect, iterations, &progress);
+                };
             });
 
             dialog.exec();
@@ -1713,9 +1884,9 @@ void ImageViewer::applyGrabCutSegmentation() {
 void ImageViewer::applyWatershedSegmentation() {
     if (originalImage.empty()) return;
 
-    pushToUndoStack();
-    originalImage = ImageProcessing::applyWatershedSegmentation(originalImage);
-    updateImage();
+    runOperation("Watershed", [image = originalImage](ImageProcessing::OperationProgress& progress) {
+        return ImageProcessing::applyWatershedSegmentation(image, &progress);
+    }, macroStep("applyWatershedSegmentation"));
 }
 
 void ImageViewer::applyInpainting() {
@@ -1734,11 +1905,12 @@ void ImageViewer::applyInpainting() {
     inpaintDialog->show();
 
     connect(inpaintDialog, &InpaintingDialog::maskChanged, this, [=]() {
-        drawnMask = inpaintDialog->getSelectedMask();
+        setDrawnMask(inpaintDialog->getSelectedMask());
         updateImage();
     });
     connect(inpaintDialog, &QDialog::accepted, this, [=]() {
-        cv::Mat mask = inpaintDialog->getSelectedMask();
+        // Held by the jobs below, so drawing on the mask meanwhile copies it instead of racing with them
+        const ImageSnapshot mask = inpaintDialog->getSelectedMask();
         updateImage();
 
         if (mask.empty()) {
@@ -1771,18 +1943,23 @@ void ImageViewer::applyInpainting() {
 
         inputDialog.addInput("Inpaint Radius:", radiusSpin);
         inputDialog.addInput("Inpaint Method:", methodCombo);
-        setupPreview(&inputDialog, inputDialog.getPreviewCheckBox(), [&]() {
+        setupPreview(&inputDialog, inputDialog.getPreviewCheckBox(), [&](const PreviewSource& source) -> ImageJob {
             int methodFlag = (methodCombo->currentText() == "Telea") ? cv::INPAINT_TELEA : cv::INPAINT_NS;
-            double radius = radiusSpin->value();
-
-            cv::Mat imageToInpaint;
-            if (originalImage.channels() == 4) {
-                cv::cvtColor(originalImage, imageToInpaint, cv::COLOR_BGRA2BGR);
-            } else {
-                imageToInpaint = originalImage.clone();
-            }
+            double radius = std::max(1.0, radiusSpin->value() * source.scale);
 
-            return ImageProcessing::applyInpainting(imageToInpaint, mask, radius, methodFlag);
+            return [image = source.image, mask, radius, methodFlag](ImageProcessing::OperationProgress& progress) {
+                cv::Mat scaledMask = mask.mat();
+                if (mask.size() != image.size()) {
+                    cv::resize(mask.mat(), scaledMask, image.size(), 0, 0, cv::INTER_NEAREST);
+                }
+                cv::Mat imageToInpaint;
+                if (image.channels() == 4) {
+                    cv::cvtColor(image, imageToInpaint, cv::COLOR_BGRA2BGR);
+                } else {
+                    imageToInpaint = image;
+                }
+                return ImageProcessing::applyInpainting(imageToInpaint, scaledMask, radius, methodFlag, &progress);
+            };
         });
 
         inputDialog.exec();
@@ -1807,37 +1984,32 @@ void ImageViewer::applyInpainting() {
 // ======================================================================
 // Applies a 3x3 box blur filter.
 void ImageViewer::applyBlur() {
-    pushToUndoStack();
-    originalImage = ImageProcessing::applyBoxBlur(originalImage, 3, mainWindow ? mainWindow->getBorderOption() : cv::BORDER_DEFAULT);
-    updateImage();
+    commitResult(ImageProcessing::applyBoxBlur(originalImage, 3, mainWindow ? mainWindow->getBorderOption() : cv::BORDER_DEFAULT),
+                 macroStep("applyBoxBlur", {{"size", "3"}, {"border", borderParameter()}}));
 }
 
 // Applies a 3x3 Gaussian blur filter.
 void ImageViewer::applyGaussianBlur() {
-    pushToUndoStack();
-    originalImage = ImageProcessing::applyGaussianBlur(originalImage, 3, 0, 0, mainWindow ? mainWindow->getBorderOption() : cv::BORDER_DEFAULT);
-    updateImage();
+    commitResult(ImageProcessing::applyGaussianBlur(originalImage, 3, 0, 0, mainWindow ? mainWindow->getBorderOption() : cv::BORDER_DEFAULT),
+                 macroStep("applyGaussianBlur", {{"size", "3"}, {"border", borderParameter()}}));
 }
 
 // Applies Sobel edge detection (default x-direction).
 void ImageViewer::applySobelEdgeDetection() {
-    pushToUndoStack();
-    originalImage = ImageProcessing::applySobelEdgeDetection(originalImage, 3, 1, 0, mainWindow ? mainWindow->getBorderOption() : cv::BORDER_DEFAULT);
-    updateImage();
+    commitResult(ImageProcessing::applySobelEdgeDetection(originalImage, 3, 1, 0, mainWindow ? mainWindow->getBorderOption() : cv::BORDER_DEFAULT),
+                 macroStep("applySobelEdgeDetection", {{"size", "3"}, {"border", borderParameter()}}));
 }
 
 // Applies Laplacian edge detection.
 void ImageViewer::applyLaplacianEdgeDetection() {
-    pushToUndoStack();
-    originalImage = ImageProcessing::applyLaplacianEdgeDetection(originalImage, 1, 1, 0, mainWindow ? mainWindow->getBorderOption() : cv::BORDER_DEFAULT);
-    updateImage();
+    commitResult(ImageProcessing::applyLaplacianEdgeDetection(originalImage, 1, 1, 0, mainWindow ? mainWindow->getBorderOption() : cv::BORDER_DEFAULT),
+                 macroStep("applyLaplacianEdgeDetection", {{"size", "1"}, {"border", borderParameter()}}));
 }
 
 // Applies Canny edge detection with default thresholds.
 void ImageViewer::applyCannyEdgeDetection() {
-    pushToUndoStack();
-    originalImage = ImageProcessing::applyCannyEdgeDetection(originalImage, 50, 150); // Default thresholds
-    updateImage();
+    commitResult(ImageProcessing::applyCannyEdgeDetection(originalImage, 50, 150), // Default thresholds
+                 macroStep("applyCannyEdgeDetection", {{"threshold1", "50"}, {"threshold2", "150"}}));
 }
 
 // Opens a dialog for Hough line detection on a binary image (prompts for Canny if needed).
@@ -1858,16 +2030,15 @@ void ImageViewer::applyHoughLineDetection() {
                                       QMessageBox::Yes|QMessageBox::No);
         if (reply == QMessageBox::Yes) {
             // Convert to grayscale if necessary before Canny
-            cv::Mat grayForCanny;
-            if (originalImage.channels() == 1) {
-                grayForCanny = originalImage;
-            } else {
-                grayForCanny = ImageProcessing::convertToGrayscale(originalImage);
+            ImageProcessing::MatResult grayForCanny = ImageProcessing::convertToGrayscale(originalImage);
+            // One undo step, recorded as the two steps it is made of
+            if (!grayForCanny || !commitResult(ImageProcessing::applyCannyEdgeDetection(grayForCanny.value(), 50, 150),
+                                               macroStep("convertToGrayscale")
+                                                   + macroStep("applyCannyEdgeDetection", {{"threshold1", "50"}, {"threshold2", "150"}}))) {
+                if (!grayForCanny) showError(grayForCanny.error());
+                return;
             }
-            edgeImage = ImageProcessing::applyCannyEdgeDetection(grayForCanny, 50, 150);
-            pushToUndoStack();
-            originalImage = edgeImage;
-            updateImage();
+            edgeImage = originalImage;
         } else {
             return;
             // User chose not to proceed
@@ -1884,26 +2055,40 @@ void ImageViewer::applyHoughLineDetection() {
 
     HoughDialog dialog(this);
 
-    setupPreview(&dialog, dialog.getPreviewCheckBox(), [&]() {
-        return ImageProcessing::detectHoughLines(edgeImage, dialog.getRho(),
-                                                 dialog.getThetaDegrees() * CV_PI / 180.0, dialog.getThreshold());
+    setupPreview(&dialog, dialog.getPreviewCheckBox(), [&](const PreviewSource& source) -> ImageJob {
+        // Votes are proportional to line length, so the accumulator threshold shrinks with the proxy
+        const int threshold = std::max(1, cvRound(dialog.getThreshold() * source.scale));
+        return [edgeImage, size = source.image.size(), rho = dialog.getRho(), theta = dialog.getThetaDegrees() * CV_PI / 180.0,
+                threshold](ImageProcessing::OperationProgress&) {
+            cv::Mat edges = edgeImage;
+            if (edgeImage.size() != size) {
+                // Area averaging keeps one-pixel edges alive; re-binarise afterwards
+                cv::resize(edgeImage, edges, size, 0, 0, cv::INTER_AREA);
+                cv::threshold(edges, edges, 0, 255, cv::THRESH_BINARY);
+            }
+            return ImageProcessing::detectHoughLines(edges, rho, theta, threshold);
+        };
     });
     dialog.exec();
 }
 
 // Applies a sharpening filter based on the selected option.
 void ImageViewer::applySharpening(int option) {
-    pushToUndoStack();
-    originalImage = ImageProcessing::applySharpening(originalImage, option, mainWindow ? mainWindow->getBorderOption() : cv::BORDER_DEFAULT);
-    updateImage();
+    commitResult(ImageProcessing::applySharpening(originalImage, option, mainWindow ? mainWindow->getBorderOption() : cv::BORDER_DEFAULT),
+                 macroStep("applySharpening", {{"option", QString::number(option)}, {"border", borderParameter()}}));
 }
 
 // Opens a dialog to select direction for Prewitt edge detection.
 void ImageViewer::applyPrewittEdgeDetection() {
     DirectionSelectionDialog dialog(this);
-    setupPreview(&dialog, dialog.getPreviewCheckBox(), [&]() {
-        return ImageProcessing::applyPrewittEdgeDetection(originalImage, dialog.getSelectedDirection(),
-                                                          mainWindow ? mainWindow->getBorderOption() : cv::BORDER_DEFAULT);
+    setupPreview(&dialog, dialog.getPreviewCheckBox(), [&](const PreviewSource& source) -> ImageJob {
+        return [image = source.image, direction = dialog.getSelectedDirection(),
+                border = mainWindow ? mainWindow->getBorderOption() : cv::BORDER_DEFAULT](ImageProcessing::OperationProgress&) {
+            return ImageProcessing::applyPrewittEdgeDetection(image, direction, border);
+        };
+    }, [&]() {
+        return macroStep("applyPrewittEdgeDetection", {{"direction", QString::number(dialog.getSelectedDirection())},
+                                                       {"border", borderParameter()}});
     });
     dialog.exec();
 }
@@ -1911,9 +2096,17 @@ void ImageViewer::applyPrewittEdgeDetection() {
 // Opens a dialog to define and apply a custom convolution kernel.
 void ImageViewer::applyCustomFilter() {
     CustomFilterDialog dialog(this);
-    setupPreview(&dialog, dialog.getPreviewCheckBox(), [&]() {
-        return ImageProcessing::applyCustomFilter(originalImage, dialog.getKernel(), true,
-                                                  mainWindow ? mainWindow->getBorderOption() : cv::BORDER_DEFAULT);
+    setupPreview(&dialog, dialog.getPreviewCheckBox(), [&](const PreviewSource& source) -> ImageJob {
+        return [image = source.image, kernel = dialog.getKernel(), border = mainWindow ? mainWindow->getBorderOption() : cv::BORDER_DEFAULT,
+                report = convolutionReporter(&dialog)](ImageProcessing::OperationProgress&) {
+            ImageProcessing::ConvolutionInfo info;
+            ImageProcessing::MatResult result = ImageProcessing::applyCustomFilter(image, kernel, true, border, &info);
+            report(info);
+            return result;
+        };
+    }, [&]() {
+        return macroStep("applyCustomFilter", {{"kernel", ProcessingPipeline::kernelToString(dialog.getKernel())},
+                                               {"normalize", "true"}, {"border", borderParameter()}});
     });
     dialog.exec();
 }
@@ -1924,15 +2117,22 @@ void ImageViewer::applyMedianFilter() {
 
     // Create kernel size dropdown
     auto *kernelCombo = new QComboBox;
-    kernelCombo->addItems({"3", "5", "7", "9"});
+    kernelCombo->addItems({"3", "5", "7", "9", "15", "25", "51", "101"});
     dialog.addInput("Kernel Size", kernelCombo);
 
-    setupPreview(&dialog, dialog.getPreviewCheckBox(), [&]() {
-        return ImageProcessing::applyMedianFilter(
-            originalImage,
-            dialog.getValue("Kernel Size").toString().toInt(),
-            mainWindow ? mainWindow->getBorderOption() : cv::BORDER_DEFAULT
-            );
+    setupPreview(&dialog, dialog.getPreviewCheckBox(), [&](const PreviewSource& source) -> ImageJob {
+        // Keep the window covering the same area of the image: nearest odd size on the proxy
+        const int kernelSize = dialog.getValue("Kernel Size").toString().toInt();
+        const int scaledSize = source.scale == 1.0 ? kernelSize : (cvRound(kernelSize * source.scale) | 1);
+        return [image = source.image, kernelSize = scaledSize,
+                border = mainWindow ? mainWindow->getBorderOption() : cv::BORDER_DEFAULT](ImageProcessing::OperationProgress& progress) -> ImageProcessing::MatResult {
+            if (kernelSize < 3) {
+                return image.clone(); // The filter is below the displayed resolution
+            }
+            return ImageProcessing::applyMedianFilter(image, kernelSize, border, &progress);
+        };
+    }, [&]() {
+        return macroStep("applyMedianFilter", {{"size", dialog.getValue("Kernel Size").toString()}, {"border", borderParameter()}});
     });
     dialog.exec();
 }
@@ -1940,9 +2140,40 @@ void ImageViewer::applyMedianFilter() {
 // Opens a dialog to define and apply a two-step (separable) filter.
 void ImageViewer::applyTwoStepFilter() {
     TwoStepFilterDialog filterDialog(this);
-    setupPreview(&filterDialog, filterDialog.getPreviewCheckBox(), [&]() {
-        return ImageProcessing::applyTwoStepFilter(originalImage.clone(), filterDialog.getKernel1(),
-                                                   filterDialog.getKernel2(), mainWindow->getBorderOption());
+    setupPreview(&filterDialog, filterDialog.getPreviewCheckBox(), [&](const PreviewSource& source) -> ImageJob {
+        return [image = source.image, kernel1 = filterDialog.getKernel1(), kernel2 = filterDialog.getKernel2(),
+                border = mainWindow ? mainWindow->getBorderOption() : cv::BORDER_DEFAULT, strategy = filterDialog.getStrategy(),
+                report = convolutionReporter(&filterDialog)](ImageProcessing::OperationProgress&) {
+            ImageProcessing::ConvolutionInfo info;
+            ImageProcessing::MatResult result = ImageProcessing::applyTwoStepFilter(image, kernel1, kernel2, border, strategy, &info);
+            report(info);
+            return result;
+        };
+    }, [&]() {
+        return macroStep("applyTwoStepFilter", {{"kernel1", ProcessingPipeline::kernelToString(filterDialog.getKernel1())},
+                                                {"kernel2", ProcessingPipeline::kernelToString(filterDialog.getKernel2())},
+                                                {"strategy", strategyName(filterDialog.getStrategy())},
+                                                {"border", borderParameter()}});
+    });
+
+    // Times every strategy on the full-resolution image, off the GUI thread
+    connect(&filterDialog, &TwoStepFilterDialog::benchmarkRequested, this, [&]() {
+        QPointer<TwoStepFilterDialog> target(&filterDialog);
+        QThreadPool::globalInstance()->start([target, image = originalImage, kernel1 = filterDialog.getKernel1(),
+                                              kernel2 = filterDialog.getKernel2(),
+                                              border = mainWindow ? mainWindow->getBorderOption() : cv::BORDER_DEFAULT]() {
+            const auto timings = ImageProcessing::benchmarkTwoStepFilter(image, kernel1, kernel2, border);
+            QMetaObject::invokeMethod(qApp, [target, timings]() {
+                if (!target) return;
+                if (timings) {
+                    target->setBenchmarkResults(timings.value());
+                } else {
+                    target->setBenchmarkResults({});
+                    QMessageBox::warning(target, QString::fromStdString(timings.error().title),
+                                         QString::fromStdString(timings.error().message));
+                }
+            }, Qt::QueuedConnection);
+        });
     });
     filterDialog.exec();
 }
@@ -1953,38 +2184,34 @@ void ImageViewer::applyTwoStepFilter() {
 // ======================================================================
 // Applies erosion using the selected structuring element type.
 void ImageViewer::applyErosion(StructuringElementType type) {
-    pushToUndoStack();
-    originalImage = ImageProcessing::applyErosion(originalImage, type, 1, mainWindow ? mainWindow->getBorderOption() : cv::BORDER_DEFAULT);
-    updateImage();
+    commitResult(ImageProcessing::applyErosion(originalImage, type, 1, mainWindow ? mainWindow->getBorderOption() : cv::BORDER_DEFAULT),
+                 macroStep("applyErosion", {{"element", elementName(type)}, {"border", borderParameter()}}));
 }
 
 // Applies dilation using the selected structuring element type.
 void ImageViewer::applyDilation(StructuringElementType type) {
-    pushToUndoStack();
-    originalImage = ImageProcessing::applyDilation(originalImage, type, 1, mainWindow ? mainWindow->getBorderOption() : cv::BORDER_DEFAULT);
-    updateImage();
+    commitResult(ImageProcessing::applyDilation(originalImage, type, 1, mainWindow ? mainWindow->getBorderOption() : cv::BORDER_DEFAULT),
+                 macroStep("applyDilation", {{"element", elementName(type)}, {"border", borderParameter()}}));
 }
 
 // Applies morphological opening using the selected structuring element type.
 void ImageViewer::applyOpening(StructuringElementType type) {
-    pushToUndoStack();
-    originalImage = ImageProcessing::applyOpening(originalImage, type, 1, mainWindow ? mainWindow->getBorderOption() : cv::BORDER_DEFAULT);
-    updateImage();
+    commitResult(ImageProcessing::applyOpening(originalImage, type, 1, mainWindow ? mainWindow->getBorderOption() : cv::BORDER_DEFAULT),
+                 macroStep("applyOpening", {{"element", elementName(type)}, {"border", borderParameter()}}));
 }
 
 // Applies morphological closing using the selected structuring element type.
 void ImageViewer::applyClosing(StructuringElementType type) {
-    pushToUndoStack();
-    originalImage = ImageProcessing::applyClosing(originalImage, type, 1, mainWindow ? mainWindow->getBorderOption() : cv::BORDER_DEFAULT);
-    updateImage();
+    commitResult(ImageProcessing::applyClosing(originalImage, type, 1, mainWindow ? mainWindow->getBorderOption() : cv::BORDER_DEFAULT),
+                 macroStep("applyClosing", {{"element", elementName(type)}, {"border", borderParameter()}}));
 }
 
 // Applies skeletonization to the binary image.
 void ImageViewer::applySkeletonization() {
-    pushToUndoStack();
     // Assuming Diamond is default or appropriate here
-    originalImage = ImageProcessing::applySkeletonization(originalImage, Diamond);
-    updateImage();
+    runOperation("Skeletonization", [image = originalImage](ImageProcessing::OperationProgress& progress) {
+        return ImageProcessing::applySkeletonization(image, Diamond, &progress);
+    }, macroStep("applySkeletonization", {{"element", elementName(Diamond)}}));
 }
 
 // ======================================================================
@@ -2061,18 +2288,3 @@ void ImageViewer::analyzeShapeFeatures() {
     layout->addWidget(closeButton);
     dialog->show();
 }
-
-// ======================================================================
-// `Helper Functions`
-// ======================================================================
-// Converts a cv::Mat to a QImage based on its type.
-QImage ImageViewer::MatToQImage(const cv::Mat &mat) {
-    if (mat.type() == CV_8UC3) {
-        return QImage(mat.data, mat.cols, mat.rows, mat.step, QImage::Format_RGB888).rgbSwapped();
-    } else if (mat.type() == CV_8UC4) {
-        return QImage(mat.data, mat.cols, mat.rows, mat.step, QImage::Format_ARGB32);
-    } else if (mat.type() == CV_8UC1) {
-        return QImage(mat.data, mat.cols, mat.rows, mat.step, QImage::Format_Grayscale8);
-    }
-    return QImage(); // Invalid image
-}
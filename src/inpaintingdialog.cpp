@@ -51,10 +51,13 @@ InpaintingDialog::InpaintingDialog(ImageViewer *parent, const QVector<QWidget*>&
     });
 
     connect(maskSourceCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [=](){
-        if(maskSourceCombo->currentText() == "Use another image")
-            drawnMask = parentViewer->getDrawnMask().clone();
-        else
-            emit maskChanged();
+        if(maskSourceCombo->currentText() == "Use another image") {
+            drawnMask = parentViewer->getDrawnMask(); // Kept to restore the drawing when switching back
+        } else {
+            emit maskChanged(); // The viewer takes drawnMask back
+            // From here on the viewer owns the mask: strokes go into its copy, which getSelectedMask() returns
+            drawnMask = ImageSnapshot();
+        }
         updateUi();
     });
 
@@ -90,7 +93,7 @@ void InpaintingDialog::refreshImageList() {
 
     for (QWidget* widget : openedImages) {
         ImageViewer* viewer = qobject_cast<ImageViewer*>(widget);
-        if (viewer && viewer != parentViewer && !viewer->getOriginalImage().empty()) {
+        if (viewer && viewer != parentViewer && !viewer->getSnapshot().empty()) {
             QString title = viewer->windowTitle();
             if (!title.isEmpty()) {
                 QListWidgetItem* item = new QListWidgetItem(title, imageList);
@@ -233,7 +236,7 @@ void InpaintingDialog::openMaskInNewViewer() {
         return;
     }
 
-    cv::Mat maskToOpen = parentViewer->getDrawnMask(); // Get clone from getter
+    const ImageSnapshot maskToOpen = parentViewer->getDrawnMask();
     if (maskToOpen.empty()) {
         QMessageBox::warning(this, "Open Mask", "No mask has been drawn yet or the mask is empty.");
         return;
@@ -257,7 +260,7 @@ void InpaintingDialog::openMaskInNewViewer() {
     // Calculate a slightly offset position for the new window
     QPoint newPos = parentViewer->pos() + QPoint(20, 20);
 
-    ImageViewer *newViewer = new ImageViewer(maskToOpen, // Pass the mask (ImageViewer takes ownership via clone)
+    ImageViewer *newViewer = new ImageViewer(maskToOpen.clone(), // The viewer keeps a plain Mat, invisible to the mask's copy-on-write
                                              newTitle,
                                              nullptr, // No QWidget parent for top-level window
                                              newPos,    // Position hint
@@ -279,51 +282,53 @@ void InpaintingDialog::openMaskInNewViewer() {
 
 /**
  * @brief Gets the selected mask, preparing it if necessary.
- * @return cv::Mat The mask (CV_8UC1, binary) or empty Mat on failure.
+ * @return ImageSnapshot The mask (CV_8UC1, binary) or an empty snapshot on failure.
  */
-cv::Mat InpaintingDialog::getSelectedMask() const {
+ImageSnapshot InpaintingDialog::getSelectedMask() const {
     if (maskSourceCombo->currentText() == "Draw on image") {
         return !drawnMask.empty() ? drawnMask : parentViewer->getDrawnMask();
     } else {
         QListWidgetItem* selectedItem = imageList->currentItem();
         if (!selectedItem) {
             QMessageBox::warning(nullptr, "Mask Selection Error", "No image selected from the list to use as a mask.");
-            return cv::Mat();
+            return ImageSnapshot();
         }
 
         ImageViewer* selectedViewer = imageViewerMap.value(selectedItem->text(), nullptr);
         if (!selectedViewer) {
             QMessageBox::critical(nullptr, "Mask Selection Error", "Internal error: Could not find the selected image viewer.");
-            return cv::Mat();
+            return ImageSnapshot();
         }
 
-        cv::Mat sourceMask = selectedViewer->getOriginalImage();
+        const ImageSnapshot sourceMask = selectedViewer->getSnapshot();
         if (sourceMask.empty()) {
             QMessageBox::warning(nullptr, "Mask Selection Error", "The selected image is empty.");
-            return cv::Mat();
+            return ImageSnapshot();
         }
 
-        cv::Mat preparedMask;
+        // Read straight from the shared source; every step below writes to a new Mat
+        cv::Mat gray = sourceMask.mat();
         if (sourceMask.channels() == 3) {
-            cv::cvtColor(sourceMask, preparedMask, cv::COLOR_BGR2GRAY);
+            cv::cvtColor(sourceMask.mat(), gray, cv::COLOR_BGR2GRAY);
         } else if (sourceMask.channels() == 4) {
-            cv::cvtColor(sourceMask, preparedMask, cv::COLOR_BGRA2GRAY);
-        } else {
-            preparedMask = sourceMask.clone();
+            cv::cvtColor(sourceMask.mat(), gray, cv::COLOR_BGRA2GRAY);
         }
 
-        if (preparedMask.depth() != CV_8U) {
-            preparedMask.convertTo(preparedMask, CV_8U, 255.0 / 65535.0);
+        if (gray.depth() != CV_8U) {
+            cv::Mat converted;
+            gray.convertTo(converted, CV_8U, 255.0 / 65535.0);
+            gray = converted;
         }
 
-        cv::threshold(preparedMask, preparedMask, 1, 255, cv::THRESH_BINARY);
+        cv::Mat preparedMask;
+        cv::threshold(gray, preparedMask, 1, 255, cv::THRESH_BINARY);
 
         if (preparedMask.empty() || preparedMask.type() != CV_8UC1) {
             QMessageBox::critical(nullptr, "Mask Preparation Error", "Failed to prepare the selected image as a valid mask (must be convertible to 8-bit single channel).");
-            return cv::Mat();
+            return ImageSnapshot();
         }
 
-        return preparedMask;
+        return ImageSnapshot(preparedMask);
     }
 }
 
@@ -42,6 +42,7 @@ QVariant InputDialog::getValue(const QString &label) const {
     if (!widget) return QVariant();
 
     if (auto spin = qobject_cast<QSpinBox*>(widget)) return spin->value();
+    if (auto doubleSpin = qobject_cast<QDoubleSpinBox*>(widget)) return doubleSpin->value();
     if (auto combo = qobject_cast<QComboBox*>(widget)) return combo->currentText();
     if (auto lineEdit = qobject_cast<QLineEdit*>(widget)) return lineEdit->text();
 
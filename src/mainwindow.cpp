@@ -1,8 +1,24 @@
 #include "mainwindow.h"
 #include "bitwiseoperationdialog.h"
+#include "expressiondialog.h"
+#include "imageexpression.h"
+#include "imagestacking.h"
+#include "stackingdialog.h"
 #include "imageviewer.h"
+#include "batchprocessor.h"
+#include "processingpipeline.h"
+#include "imageloader.h"
 #include <QVBoxLayout>
 #include <QActionGroup>
+#include <QApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QInputDialog>
+#include <QListWidget>
+#include <QPointer>
+#include <QSaveFile>
+#include <QThreadPool>
+#include <memory>
 #include <qcombobox.h>
 #include <qmimedata.h>
 
@@ -10,6 +26,13 @@
 // Application Core & Main Window
 // ==========================================================================
 
+namespace {
+
+// Batches up to this many files open a viewer per file; larger ones only fill the thumbnail strip
+constexpr int AutoOpenLimit = 8;
+
+} // namespace
+
 // Constructor: Sets up the main window menu bar (File, Info, Options).
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     resize(800, 30);
@@ -20,6 +43,40 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     connect(openAction, &QAction::triggered, this, [=](){ openImage(); });
     fileMenu->addAction(openAction);
 
+    QAction *clearThumbnailsAction = new QAction("Clear Thumbnails", this);
+    connect(clearThumbnailsAction, &QAction::triggered, this, &MainWindow::clearThumbnails);
+    fileMenu->addAction(clearThumbnailsAction);
+
+    imageLoader = new ImageLoader(this);
+    imageLoader->setCacheLimit(static_cast<size_t>(imageCacheMB) * 1024 * 1024);
+    connect(imageLoader, &ImageLoader::imageReady, this, &MainWindow::showLoadedImage);
+    connect(imageLoader, &ImageLoader::imageFailed, this, [this](const QString &filePath, const QString &error) {
+        QMessageBox::critical(this, "Load Error", QString("Failed to load %1: %2").arg(QFileInfo(filePath).fileName(), error));
+    });
+    connect(imageLoader, &ImageLoader::thumbnailReady, this, &MainWindow::showThumbnail);
+    connect(imageLoader, &ImageLoader::thumbnailFailed, this, [this](const QString &filePath, const QString &error) {
+        if (QListWidgetItem *item = thumbnailItems.value(filePath)) {
+            item->setForeground(Qt::gray);
+            item->setToolTip(filePath + "\n" + error);
+        }
+    });
+
+    // Hidden until a large batch is opened
+    thumbnailStrip = new QListWidget(this);
+    thumbnailStrip->setViewMode(QListView::IconMode);
+    thumbnailStrip->setFlow(QListView::LeftToRight);
+    thumbnailStrip->setWrapping(false);
+    thumbnailStrip->setMovement(QListView::Static);
+    thumbnailStrip->setUniformItemSizes(true);
+    thumbnailStrip->setIconSize(QSize(ImageLoader::ThumbnailSize, ImageLoader::ThumbnailSize));
+    thumbnailStrip->setGridSize(QSize(ImageLoader::ThumbnailSize + 24, ImageLoader::ThumbnailSize + 32));
+    thumbnailStrip->setFixedHeight(ImageLoader::ThumbnailSize + 56);
+    thumbnailStrip->hide();
+    connect(thumbnailStrip, &QListWidget::itemActivated, this, [this](QListWidgetItem *item) {
+        imageLoader->requestImage(item->data(Qt::UserRole).toString());
+    });
+    setCentralWidget(thumbnailStrip);
+
     QMenu *infoMenu = menuBar()->addMenu("Info"); // New Info menu
     QAction *aboutAction = new QAction("About", this);
     connect(aboutAction, &QAction::triggered, this, &MainWindow::showInfo);
@@ -70,6 +127,41 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
 
     optionsMenu->addAction(pyramidScalingToggle);
 
+    proxyPreviewToggle = new QAction("Fast Previews (Reduced Resolution)", this);
+    proxyPreviewToggle->setCheckable(true);
+    proxyPreviewToggle->setChecked(true); // Default on
+
+    // Viewers query this when a preview is requested, so no need to push it to them
+    connect(proxyPreviewToggle, &QAction::triggered, this, [this](bool checked) {
+        useProxyPreview = checked;
+    });
+
+    optionsMenu->addAction(proxyPreviewToggle);
+
+    QMenu *undoMenu = optionsMenu->addMenu("Undo History");
+    QAction *undoLimitAction = new QAction("Memory Limit...", this);
+    connect(undoLimitAction, &QAction::triggered, this, &MainWindow::setUndoMemoryLimit);
+    undoMenu->addAction(undoLimitAction);
+
+    undoSpillToggle = new QAction("Move Old States to Disk", this);
+    undoSpillToggle->setCheckable(true);
+    undoSpillToggle->setChecked(false); // Default off: states over the limit are discarded
+
+    connect(undoSpillToggle, &QAction::triggered, this, [this]() {
+        for (QWidget* widget : openedImages) {
+            auto viewer = qobject_cast<ImageViewer*>(widget);
+            if (viewer) {
+                viewer->setUndoSpillDirectory(getUndoSpillDirectory());
+            }
+        }
+    });
+
+    undoMenu->addAction(undoSpillToggle);
+
+    QAction *imageCacheAction = new QAction("Decoded Image Cache...", this);
+    connect(imageCacheAction, &QAction::triggered, this, &MainWindow::setImageCacheLimit);
+    optionsMenu->addAction(imageCacheAction);
+
 
 
     QMenu *imagesInteractionMenu = menuBar()->addMenu("Images Interaction");
@@ -81,6 +173,31 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     QAction* bitwiseOperations = new QAction("Bitwise operations...", this);
     connect(bitwiseOperations, &QAction::triggered, this, &MainWindow::showBitwiseOperationDialog);
     imagesInteractionMenu->addAction(bitwiseOperations);
+
+    QAction* imageExpression = new QAction("Image Expression...", this);
+    connect(imageExpression, &QAction::triggered, this, &MainWindow::evaluateImageExpression);
+    imagesInteractionMenu->addAction(imageExpression);
+
+    QAction* stackFrames = new QAction("Stack Images...", this);
+    connect(stackFrames, &QAction::triggered, this, &MainWindow::stackOpenImages);
+    imagesInteractionMenu->addAction(stackFrames);
+
+    QMenu *macroMenu = menuBar()->addMenu("Macro");
+
+    QAction* runOnImages = new QAction("Run Macro on Open Images...", this);
+    connect(runOnImages, &QAction::triggered, this, &MainWindow::runMacroOnOpenImages);
+    macroMenu->addAction(runOnImages);
+
+    QAction* runOnFolder = new QAction("Run Macro on Folder...", this);
+    connect(runOnFolder, &QAction::triggered, this, &MainWindow::runMacroOnFolder);
+    macroMenu->addAction(runOnFolder);
+
+    macroMenu->addSeparator();
+    // Replays query this when they start, like the preview option
+    optimizeMacrosToggle = new QAction("Optimize Macros (Fuse Filters)", this);
+    optimizeMacrosToggle->setCheckable(true);
+    optimizeMacrosToggle->setChecked(true); // Default on
+    macroMenu->addAction(optimizeMacrosToggle);
 }
 
 // Returns the currently selected border handling option for OpenCV functions.
@@ -93,122 +210,122 @@ bool MainWindow::isPyramidScalingEnabled() const {
     return usePyramidScaling;
 }
 
-// Sets the border handling option and updates menu checks.
-void MainWindow::setBorderOption(int option, QAction *selectedAction) {
-    borderOption = option;
-    borderIsolated->setChecked(false);
-    borderReflect->setChecked(false);
-    borderReplicate->setChecked(false);
-    selectedAction->setChecked(true);
+// Returns whether dialog previews may run on a reduced-resolution copy of the image.
+bool MainWindow::isProxyPreviewEnabled() const {
+    return useProxyPreview;
 }
 
-cv::Mat decompressRLE(const std::vector<std::pair<uchar, uchar>>& rleData, int width, int height) {
-    cv::Mat image(height, width, CV_8UC1);
-    uchar* data = image.ptr<uchar>(0);
-    uchar idx = 0;
-
-    for (const auto& [val, count] : rleData) {
-        std::fill(data + idx, data + idx + count, val);
-        idx += count;
-    }
-
-    return image;
+// Returns whether macros are rewritten by ProcessingPipeline::optimized() before they are replayed.
+bool MainWindow::isMacroOptimizationEnabled() const {
+    return optimizeMacrosToggle->isChecked();
 }
 
-
-cv::Mat decompressColorRLE(const std::vector<std::pair<cv::Vec3b, uchar>>& rleData, int width, int height) {
-    cv::Mat image(height, width, CV_8UC3);
-    cv::Vec3b* data = image.ptr<cv::Vec3b>(0);
-    uchar idx = 0;
-
-    for (const auto& [val, count] : rleData) {
-        std::fill(data + idx, data + idx + count, val);
-        idx += count;
-    }
-
-    return image;
+// Returns the undo history memory budget of each image window, in bytes.
+size_t MainWindow::getUndoMemoryBudget() const {
+    return static_cast<size_t>(undoBudgetMB) * 1024 * 1024;
 }
 
-cv::Mat loadRLEFile(const QString& filePath) {
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly)) return {};
-
-    QDataStream in(&file);
-    in.setByteOrder(QDataStream::LittleEndian);
-
-    char type[3];
-    if (file.read(type, 3) != 3) return {};
-
-    int width, height;
-    if (file.read(reinterpret_cast<char*>(&width), 4) != 4 ||
-        file.read(reinterpret_cast<char*>(&height), 4) != 4) return {};
-
-    QString format = QString::fromLatin1(type, 3);
-    if (format == "GRE") {
-        cv::Mat image(height, width, CV_8UC1);
-        uchar* data = image.ptr<uchar>(0);
-        int idx = 0;
-
-        while (!file.atEnd() && idx < width * height) {
-            uchar val, count;
-            if (file.read(reinterpret_cast<char*>(&val), 1) != 1 ||
-                file.read(reinterpret_cast<char*>(&count), 1) != 1) break;
+// Returns where undo states over the budget are written, or an empty string to discard them.
+QString MainWindow::getUndoSpillDirectory() const {
+    return undoSpillToggle->isChecked() ? QDir::tempPath() : QString();
+}
 
-            std::fill(data + idx, data + idx + count, val);
-            idx += count;
+// Asks for a new undo memory limit and applies it to all opened image viewers.
+void MainWindow::setUndoMemoryLimit() {
+    bool ok = false;
+    const int limit = QInputDialog::getInt(this, "Undo History", "Memory limit per image (MB):",
+                                           undoBudgetMB, 16, 65536, 64, &ok);
+    if (!ok) return;
+    undoBudgetMB = limit;
+
+    for (QWidget* widget : openedImages) {
+        auto viewer = qobject_cast<ImageViewer*>(widget);
+        if (viewer) {
+            viewer->setUndoMemoryBudget(getUndoMemoryBudget());
         }
-
-        return image;
-    } else if (format == "COL") {
-        // Delegate to color loading function (as shown earlier)
-        // Or copy in the "COL" logic here
     }
-
-    return {};
 }
 
+// Asks for the memory limit of decoded images kept for re-opening; 0 disables the cache.
+void MainWindow::setImageCacheLimit() {
+    bool ok = false;
+    const int limit = QInputDialog::getInt(this, "Decoded Image Cache", "Memory limit (MB, 0 to disable):",
+                                           imageCacheMB, 0, 65536, 64, &ok);
+    if (!ok) return;
+    imageCacheMB = limit;
+    imageLoader->setCacheLimit(static_cast<size_t>(imageCacheMB) * 1024 * 1024);
+}
 
-
-
+// Sets the border handling option and updates menu checks.
+void MainWindow::setBorderOption(int option, QAction *selectedAction) {
+    borderOption = option;
+    borderIsolated->setChecked(false);
+    borderReflect->setChecked(false);
+    borderReplicate->setChecked(false);
+    selectedAction->setChecked(true);
+}
 
 // Wrapper for menu action
 void MainWindow::openImage() {
-    QString filePath = QFileDialog::getOpenFileName(
+    const QStringList filePaths = QFileDialog::getOpenFileNames(
         this, "Open Image", "", "Images (*.png *.jpg *.jpeg *.bmp *.gif *.tiff *.rle)");
-    if (!filePath.isEmpty()) {
-        openImage(filePath);  // call the main logic
+    if (!filePaths.isEmpty()) {
+        openImages(filePaths);  // call the main logic
     }
 }
 
-// Core image opening logic
-void MainWindow::openImage(const QString &filePath) {
-    cv::Mat image;
-
-    if (filePath.endsWith(".rle", Qt::CaseInsensitive)) {
-        image = loadRLEFile(filePath);
-        if (image.empty()) {
-            QMessageBox::critical(this, "Load Error", "Failed to load RLE image.");
-            return;
-        }
-    } else {
-        QFile file(filePath);
-        if (file.open(QIODevice::ReadOnly)) {
-            QByteArray imageData = file.readAll();
-            std::vector<uchar> buffer(imageData.begin(), imageData.end());
-            image = cv::imdecode(buffer, cv::IMREAD_UNCHANGED);
-        }
-        if (image.empty()) {
-            QMessageBox::critical(this, "Load Error", "Failed to decode image.");
-            return;
+// Core image opening logic: files are only queued here and decoded on the loader's worker threads,
+// so the first image shows up after one decode however many files were dropped.
+void MainWindow::openImages(const QStringList &filePaths) {
+    if (filePaths.size() <= AutoOpenLimit) {
+        for (const QString &filePath : filePaths) {
+            imageLoader->requestImage(filePath);
         }
+        return;
+    }
+
+    // Large batch: placeholders first, thumbnails fill in as they are decoded
+    for (const QString &filePath : filePaths) {
+        if (thumbnailItems.contains(filePath)) continue;
+        addThumbnailItem(filePath);
+        imageLoader->requestThumbnail(filePath);
+    }
+    if (thumbnailStrip->isHidden()) {
+        thumbnailStrip->show();
+        resize(width(), menuBar()->sizeHint().height() + thumbnailStrip->height());
+    }
+}
+
+QListWidgetItem *MainWindow::addThumbnailItem(const QString &filePath) {
+    auto *item = new QListWidgetItem(QFileInfo(filePath).fileName(), thumbnailStrip);
+    item->setData(Qt::UserRole, filePath);
+    item->setToolTip(filePath);
+    thumbnailItems.insert(filePath, item);
+    return item;
+}
+
+void MainWindow::showThumbnail(const QString &filePath, const QImage &thumbnail) {
+    if (QListWidgetItem *item = thumbnailItems.value(filePath)) {
+        item->setIcon(QIcon(QPixmap::fromImage(thumbnail)));
     }
+}
 
+void MainWindow::showLoadedImage(const QString &filePath, const cv::Mat &image) {
     ImageViewer *viewer = new ImageViewer(image, filePath, nullptr, QPoint(100, 100), this);
     viewer->show();
     if(!openedImages.contains(viewer))
         openedImages.append(viewer);
 }
 
+// Drops queued thumbnail decodes too, so clearing a huge batch also stops loading it.
+void MainWindow::clearThumbnails() {
+    imageLoader->cancelPending();
+    thumbnailItems.clear();
+    thumbnailStrip->clear();
+    thumbnailStrip->hide();
+    resize(width(), menuBar()->sizeHint().height());
+}
+
 void MainWindow::dragEnterEvent(QDragEnterEvent *event) {
     if (event->mimeData()->hasUrls()) {
         event->acceptProposedAction();
@@ -216,13 +333,15 @@ void MainWindow::dragEnterEvent(QDragEnterEvent *event) {
 }
 
 void MainWindow::dropEvent(QDropEvent *event) {
+    QStringList filePaths;
     const QList<QUrl> urls = event->mimeData()->urls();
     for (const QUrl &url : urls) {
         QString filePath = url.toLocalFile();
         if (!filePath.isEmpty()) {
-            openImage(filePath);  // ← new, cleaner usage
+            filePaths.append(filePath);
         }
     }
+    openImages(filePaths);
     event->acceptProposedAction();
 }
 
@@ -252,7 +371,7 @@ void MainWindow::mergeGrayscaleChannels()
 
     for (QWidget *w : openedImages) {
         if (auto *v = qobject_cast<ImageViewer*>(w);
-            v && v->getOriginalImage().channels() == 1)
+            v && v->getSnapshot().channels() == 1)
         {
             imageTitles   << v->windowTitle();
             imageMap[v->windowTitle()] = v;
@@ -320,11 +439,15 @@ void MainWindow::mergeGrayscaleChannels()
     }
 
     /* ---------- 6.  Gather grayscale planes ---------- */
+    // Snapshots share the viewers' pixels, so the planes are read without copying them first
+    std::vector<ImageSnapshot> snapshots;
     std::vector<cv::Mat> planes;
+    snapshots.reserve(labels.size());
     planes.reserve(labels.size());
     for (int i = 0; i < labels.size(); ++i) {
         const QString title = rows[i].cb->currentText();
-        planes.push_back(imageMap[title]->getOriginalImage());
+        snapshots.push_back(imageMap[title]->getSnapshot());
+        planes.push_back(snapshots.back().mat());
     }
 
     /* ---------- 7.  Merge and colour-convert if needed ---------- */
@@ -362,6 +485,164 @@ void MainWindow::showBitwiseOperationDialog() {
     }
 }
 
+// Evaluates an expression over any number of open images in one pass on the thread pool.
+// The inputs are snapshots, so their viewers stay usable (and editable) while it runs.
+void MainWindow::evaluateImageExpression() {
+    ExpressionDialog dialog(openedImages, this);
+    if (dialog.exec() != QDialog::Accepted) return;
+
+    auto expression = ImageProcessing::ImageExpression::parse(dialog.getExpression().toStdString());
+    const QVector<ImageViewer*> viewers = dialog.getBoundViewers();
+    if (!expression || viewers.isEmpty()) return; // The dialog only accepts valid, fully bound expressions
+
+    std::vector<ImageSnapshot> snapshots;
+    for (ImageViewer* viewer : viewers) {
+        snapshots.push_back(viewer->getSnapshot());
+    }
+    const QString title = "Expression: " + dialog.getExpression();
+    QPointer<MainWindow> self(this);
+    QThreadPool::globalInstance()->start([expression = std::move(expression).value(), snapshots, self, title]() {
+        std::vector<cv::Mat> images;
+        for (const ImageSnapshot& snapshot : snapshots) {
+            images.push_back(snapshot.mat());
+        }
+        const ImageProcessing::MatResult result = expression.evaluate(images);
+        QMetaObject::invokeMethod(qApp, [self, result, title]() {
+            if (!self) return;
+            if (!result) {
+                QMessageBox::warning(self, QString::fromStdString(result.error().title),
+                                     QString::fromStdString(result.error().message));
+                return;
+            }
+            auto *viewer = new ImageViewer(result.value(), title, nullptr, QPoint(100, 100), self);
+            viewer->show();
+        }, Qt::QueuedConnection);
+    });
+}
+
+// Combines many aligned open images (mean, median or sigma-clipped mean) on the thread pool.
+// The result has a higher bit depth than the frames: it is saved at full depth if a file was given,
+// and shown rounded to 8 bits, which is what viewers display.
+void MainWindow::stackOpenImages() {
+    StackingDialog dialog(openedImages, this);
+    if (dialog.exec() != QDialog::Accepted) return;
+
+    std::vector<ImageSnapshot> snapshots;
+    for (ImageViewer* viewer : dialog.getSelectedViewers()) {
+        snapshots.push_back(viewer->getSnapshot());
+    }
+    const ImageProcessing::StackOptions options = dialog.getOptions();
+    const QString outputPath = dialog.getOutputPath();
+    const QString title = QString("Stack of %1 images").arg(snapshots.size());
+    QPointer<MainWindow> self(this);
+    QThreadPool::globalInstance()->start([snapshots, options, outputPath, self, title]() {
+        std::vector<cv::Mat> frames;
+        for (const ImageSnapshot& snapshot : snapshots) {
+            frames.push_back(snapshot.mat());
+        }
+        const ImageProcessing::MatResult result = ImageProcessing::stackImages(frames, options);
+
+        // Encoded here rather than on the GUI thread: 16-bit PNG and TIFF encoding of a large image takes a while
+        QString saveError;
+        if (result && !outputPath.isEmpty()) {
+            std::vector<uchar> buffer;
+            try {
+                if (!cv::imencode("." + QFileInfo(outputPath).suffix().toStdString(), result.value(), buffer)) {
+                    saveError = "This format cannot store the result's bit depth; use PNG or TIFF.";
+                }
+            } catch (const cv::Exception& ex) {
+                saveError = ex.what();
+            }
+            QSaveFile file(outputPath);
+            if (saveError.isEmpty()
+                && (!file.open(QIODevice::WriteOnly)
+                    || file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<qint64>(buffer.size())) != static_cast<qint64>(buffer.size())
+                    || !file.commit())) {
+                saveError = file.errorString();
+            }
+        }
+        cv::Mat display;
+        if (result) {
+            // Frames come from viewers, which only hold 8-bit images, so the result is 16-bit scaled by 257
+            result.value().convertTo(display, CV_8U, result.value().depth() == CV_16U ? 1.0 / 257.0 : 1.0);
+        }
+
+        QMetaObject::invokeMethod(qApp, [self, result, display, saveError, title]() {
+            if (!self) return;
+            if (!result) {
+                QMessageBox::warning(self, QString::fromStdString(result.error().title),
+                                     QString::fromStdString(result.error().message));
+                return;
+            }
+            if (!saveError.isEmpty()) {
+                QMessageBox::warning(self, "Save Error", "Failed to save the stacked image: " + saveError);
+            }
+            auto *viewer = new ImageViewer(display, title, nullptr, QPoint(100, 100), self);
+            viewer->show();
+        }, Qt::QueuedConnection);
+    });
+}
+
+// ==========================================================================
+// Macros
+// ==========================================================================
+
+bool MainWindow::loadMacro(ProcessingPipeline& pipeline) {
+    const QString filePath = QFileDialog::getOpenFileName(this, "Open Macro", "", "Pipelines (*.txt);;All Files (*)");
+    if (filePath.isEmpty()) return false;
+    QString error;
+    if (!pipeline.load(filePath, &error)) {
+        QMessageBox::warning(this, "Macro Error", error);
+        return false;
+    }
+    return true;
+}
+
+// Replays a recorded macro on every open image; each viewer runs it on the thread pool
+// as one undoable operation, so the images are processed concurrently.
+void MainWindow::runMacroOnOpenImages() {
+    if (openedImages.isEmpty()) {
+        QMessageBox::information(this, "Run Macro", "No images are open.");
+        return;
+    }
+    ProcessingPipeline pipeline;
+    if (!loadMacro(pipeline)) return;
+    for (QWidget* widget : openedImages) {
+        if (auto viewer = qobject_cast<ImageViewer*>(widget)) {
+            viewer->runMacro(pipeline);
+        }
+    }
+}
+
+// Replays a recorded macro on every image of a folder, writing the results to another folder.
+// The batch runs in the background; a summary is shown when it finishes.
+void MainWindow::runMacroOnFolder() {
+    ProcessingPipeline pipeline;
+    if (!loadMacro(pipeline)) return;
+    BatchOptions options;
+    options.inputDir = QFileDialog::getExistingDirectory(this, "Input Folder");
+    if (options.inputDir.isEmpty()) return;
+    options.outputDir = QFileDialog::getExistingDirectory(this, "Output Folder");
+    if (options.outputDir.isEmpty()) return;
+
+    auto processor = std::make_shared<BatchProcessor>(isMacroOptimizationEnabled() ? pipeline.optimized() : pipeline, options);
+    QPointer<MainWindow> self(this);
+    QThreadPool::globalInstance()->start([processor, self, outputDir = options.outputDir]() {
+        const BatchResult result = processor->run();
+        QMetaObject::invokeMethod(qApp, [self, result, outputDir]() {
+            if (!self) return;
+            const QString summary = QString("%1 image(s) processed, %2 failed in %3 s.\nResults saved to %4")
+                                        .arg(result.succeeded).arg(result.failed)
+                                        .arg(result.elapsedMs / 1000.0, 0, 'f', 1).arg(outputDir);
+            if (result.failed > 0) {
+                QMessageBox::warning(self, "Run Macro", summary);
+            } else {
+                QMessageBox::information(self, "Run Macro", summary);
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
 void MainWindow::closeEvent(QCloseEvent *event) {
     for(auto image : openedImages) image->close();
     QWidget::closeEvent(event); // Call base class implementation
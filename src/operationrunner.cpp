@@ -0,0 +1,81 @@
+#include "operationrunner.h"
+#include <QCoreApplication>
+#include <QPointer>
+#include <QThreadPool>
+
+// State shared between the runner (GUI thread) and the worker running the job
+struct OperationRunner::JobState {
+    ImageProcessing::OperationProgress progress;
+};
+
+OperationRunner::OperationRunner(QObject *parent)
+    : QObject(parent) {
+    // Progress only: the result is posted back by the worker as soon as the job returns
+    progressTimer.setInterval(50);
+    connect(&progressTimer, &QTimer::timeout, this, &OperationRunner::reportProgress);
+}
+
+OperationRunner::~OperationRunner() {
+    // The worker keeps its own reference to the state; just tell it to stop early
+    if (state) state->progress.requestCancel();
+}
+
+bool OperationRunner::start(ImageJob job) {
+    if (state || !job) return false;
+
+    auto jobState = std::make_shared<JobState>();
+    state = jobState;
+    lastPercent = -1;
+
+    QPointer<OperationRunner> runner(this);
+    QThreadPool::globalInstance()->start([runner, jobState, job = std::move(job)]() {
+        ImageProcessing::MatResult result = ImageProcessing::Error{"Operation Error", "Unknown error."};
+        try {
+            result = job(jobState->progress);
+        } catch (const cv::Exception& e) {
+            result = ImageProcessing::Error{"OpenCV Error", e.what()};
+        } catch (const std::exception& e) {
+            result = ImageProcessing::Error{"Operation Error", e.what()};
+        }
+        // The runner may be gone by then (its viewer closed); the result is dropped
+        QMetaObject::invokeMethod(qApp, [runner, jobState, result]() {
+            if (runner) runner->complete(jobState, result);
+        }, Qt::QueuedConnection);
+    });
+
+    progressTimer.start();
+    return true;
+}
+
+void OperationRunner::cancel() {
+    if (state) state->progress.requestCancel();
+}
+
+// Forwards the job's progress while it runs.
+void OperationRunner::reportProgress() {
+    if (!state) {
+        progressTimer.stop();
+        return;
+    }
+    const int percent = state->progress.percent();
+    if (percent != lastPercent) {
+        lastPercent = percent;
+        emit progressChanged(percent);
+    }
+}
+
+// Called on the GUI thread with the result the worker posted.
+void OperationRunner::complete(const std::shared_ptr<JobState>& jobState, const ImageProcessing::MatResult& result) {
+    if (jobState != state) return;
+
+    const bool wasCancelled = state->progress.isCancelled();
+    state.reset();
+    progressTimer.stop();
+
+    // Slots may start the next job right away, so the runner must already be idle here
+    if (wasCancelled) {
+        emit cancelled();
+    } else {
+        emit finished(result);
+    }
+}
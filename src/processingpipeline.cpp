@@ -0,0 +1,485 @@
+#include "processingpipeline.h"
+#include "imageprocessing.h"
+#include <QFile>
+#include <QRegularExpression>
+#include <QSet>
+#include <QTextStream>
+#include <cmath>
+#include <functional>
+
+// ==========================================================================
+// Processing Pipeline - Step Parameters
+// ==========================================================================
+
+namespace {
+
+// Typed access to the raw key=value parameters of one step.
+// Every key that is read is marked as used, so typos like "sze=5" can be reported.
+class StepParameters {
+public:
+    explicit StepParameters(const QMap<QString, QString>& params) : params(params) {}
+
+    int getInt(const QString& key, int defaultValue) {
+        used.insert(key);
+        if (!params.contains(key)) return defaultValue;
+        bool ok = false;
+        int value = params.value(key).toInt(&ok);
+        if (!ok) fail(QString("'%1' must be an integer").arg(key));
+        return value;
+    }
+
+    double getDouble(const QString& key, double defaultValue) {
+        used.insert(key);
+        if (!params.contains(key)) return defaultValue;
+        bool ok = false;
+        double value = params.value(key).toDouble(&ok);
+        if (!ok) fail(QString("'%1' must be a number").arg(key));
+        return value;
+    }
+
+    bool getBool(const QString& key, bool defaultValue) {
+        used.insert(key);
+        if (!params.contains(key)) return defaultValue;
+        const QString value = params.value(key).toLower();
+        if (value == "true" || value == "1" || value == "yes") return true;
+        if (value == "false" || value == "0" || value == "no") return false;
+        fail(QString("'%1' must be true or false").arg(key));
+        return defaultValue;
+    }
+
+    // Border mode names match the Options menu of the GUI; the GUI default is "isolated".
+    int getBorder() {
+        used.insert("border");
+        const QString value = params.value("border", "isolated").toLower();
+        if (value == "isolated") return cv::BORDER_ISOLATED;
+        if (value == "reflect") return cv::BORDER_REFLECT;
+        if (value == "replicate") return cv::BORDER_REPLICATE;
+        fail("'border' must be isolated, reflect or replicate");
+        return cv::BORDER_ISOLATED;
+    }
+
+    StructuringElementType getElement() {
+        used.insert("element");
+        const QString value = params.value("element", "diamond").toLower();
+        if (value == "diamond") return Diamond;
+        if (value == "square") return Square;
+        fail("'element' must be diamond or square");
+        return Diamond;
+    }
+
+    ImageProcessing::TwoStepStrategy getStrategy() {
+        used.insert("strategy");
+        const QString value = params.value("strategy", "combined").toLower();
+        if (value == "combined") return ImageProcessing::TwoStepStrategy::Combined;
+        if (value == "sequential") return ImageProcessing::TwoStepStrategy::Sequential;
+        if (value == "separable") return ImageProcessing::TwoStepStrategy::Separable;
+        fail("'strategy' must be combined, sequential or separable");
+        return ImageProcessing::TwoStepStrategy::Combined;
+    }
+
+    // Square kernel given as comma-separated row-major values, e.g. "0,-1,0,-1,5,-1,0,-1,0".
+    cv::Mat getKernel(const QString& key) {
+        used.insert(key);
+        if (!params.contains(key)) {
+            fail(QString("missing '%1'").arg(key));
+            return cv::Mat();
+        }
+        const QStringList values = params.value(key).split(',', Qt::SkipEmptyParts);
+        const int size = static_cast<int>(std::lround(std::sqrt(static_cast<double>(values.size()))));
+        if (size * size != values.size() || size < 1) {
+            fail(QString("'%1' must contain a square number of values").arg(key));
+            return cv::Mat();
+        }
+        cv::Mat kernel(size, size, CV_32F);
+        for (int i = 0; i < values.size(); ++i) {
+            bool ok = false;
+            kernel.at<float>(i / size, i % size) = values[i].trimmed().toFloat(&ok);
+            if (!ok) {
+                fail(QString("'%1' contains a non-numeric value").arg(key));
+                return cv::Mat();
+            }
+        }
+        return kernel;
+    }
+
+    // Returns false (and fills errorMessage) if a value was malformed or a key was never read.
+    bool check(QString* errorMessage) {
+        for (auto it = params.constBegin(); it != params.constEnd(); ++it) {
+            if (!used.contains(it.key())) fail(QString("unknown parameter '%1'").arg(it.key()));
+        }
+        if (error.isEmpty()) return true;
+        if (errorMessage) *errorMessage = error;
+        return false;
+    }
+
+private:
+    void fail(const QString& message) {
+        if (error.isEmpty()) error = message;
+    }
+
+    const QMap<QString, QString>& params;
+    QSet<QString> used;
+    QString error;
+};
+
+using StepFunction = std::function<ImageProcessing::MatResult(const cv::Mat&, StepParameters&)>;
+
+// All operations reachable from a pipeline, keyed by their ImageProcessing name.
+const QMap<QString, StepFunction>& stepRegistry() {
+    using namespace ImageProcessing;
+    static const QMap<QString, StepFunction> registry = {
+        // Core operations
+        {"binarise", [](const cv::Mat& img, StepParameters& p) {
+             return binarise(img, p.getDouble("threshold", 127.0), p.getDouble("max", 255.0)); }},
+        {"convertToGrayscale", [](const cv::Mat& img, StepParameters&) { return convertToGrayscale(img); }},
+        {"grayscale", [](const cv::Mat& img, StepParameters&) { return convertToGrayscale(img); }},
+        {"removeAlphaChannel", [](const cv::Mat& img, StepParameters&) { return removeAlphaChannel(img); }},
+        {"convertToColor", [](const cv::Mat& img, StepParameters&) { return convertToColor(img); }},
+
+        // Point operations
+        {"applyNegation", [](const cv::Mat& img, StepParameters&) { return applyNegation(img); }},
+        {"applyRangeStretching", [](const cv::Mat& img, StepParameters& p) {
+             return applyRangeStretching(img, p.getInt("p1", 0), p.getInt("p2", 255),
+                                         p.getInt("q3", 0), p.getInt("q4", 255)); }},
+        {"applyPosterization", [](const cv::Mat& img, StepParameters& p) {
+             return applyPosterization(img, p.getInt("levels", 4)); }},
+        {"applyGammaCorrection", [](const cv::Mat& img, StepParameters& p) {
+             return applyGammaCorrection(img, p.getDouble("gamma", 1.0)); }},
+
+        // Histogram operations
+        {"stretchHistogram", [](const cv::Mat& img, StepParameters&) { return stretchHistogram(img); }},
+        {"equalizeHistogram", [](const cv::Mat& img, StepParameters&) { return equalizeHistogram(img); }},
+
+        // Filtering & edge detection
+        {"applyBoxBlur", [](const cv::Mat& img, StepParameters& p) {
+             return applyBoxBlur(img, p.getInt("size", 3), p.getBorder()); }},
+        {"applyGaussianBlur", [](const cv::Mat& img, StepParameters& p) {
+             return applyGaussianBlur(img, p.getInt("size", 3), p.getDouble("sigmaX", 0.0),
+                                      p.getDouble("sigmaY", 0.0), p.getBorder()); }},
+        {"applySobelEdgeDetection", [](const cv::Mat& img, StepParameters& p) {
+             return applySobelEdgeDetection(img, p.getInt("size", 3), p.getDouble("scale", 1.0),
+                                            p.getDouble("delta", 0.0), p.getBorder()); }},
+        {"applyLaplacianEdgeDetection", [](const cv::Mat& img, StepParameters& p) {
+             return applyLaplacianEdgeDetection(img, p.getInt("size", 3), p.getDouble("scale", 1.0),
+                                                p.getDouble("delta", 0.0), p.getBorder()); }},
+        {"applyCannyEdgeDetection", [](const cv::Mat& img, StepParameters& p) {
+             return applyCannyEdgeDetection(img, p.getDouble("threshold1", 100.0), p.getDouble("threshold2", 200.0),
+                                            p.getInt("aperture", 3), p.getBool("l2gradient", false)); }},
+        {"applySharpening", [](const cv::Mat& img, StepParameters& p) {
+             return applySharpening(img, p.getInt("option", 1), p.getBorder()); }},
+        {"applyPrewittEdgeDetection", [](const cv::Mat& img, StepParameters& p) {
+             return applyPrewittEdgeDetection(img, p.getInt("direction", 0), p.getBorder()); }},
+        {"applyCustomFilter", [](const cv::Mat& img, StepParameters& p) {
+             cv::Mat kernel = p.getKernel("kernel");
+             bool normalize = p.getBool("normalize", true);
+             int border = p.getBorder();
+             if (kernel.empty()) return MatResult(Error{"Custom Filter Error", "Invalid kernel."});
+             return applyCustomFilter(img, kernel, normalize, border); }},
+        {"applyMedianFilter", [](const cv::Mat& img, StepParameters& p) {
+             return applyMedianFilter(img, p.getInt("size", 3), p.getBorder()); }},
+        {"applyTwoStepFilter", [](const cv::Mat& img, StepParameters& p) {
+             cv::Mat kernel1 = p.getKernel("kernel1");
+             cv::Mat kernel2 = p.getKernel("kernel2");
+             int border = p.getBorder();
+             TwoStepStrategy strategy = p.getStrategy();
+             if (kernel1.empty() || kernel2.empty()) return MatResult(Error{"Two Step Filter Error", "Invalid kernels."});
+             return applyTwoStepFilter(img, kernel1, kernel2, border, strategy); }},
+
+        // Morphology
+        {"applyErosion", [](const cv::Mat& img, StepParameters& p) {
+             return applyErosion(img, p.getElement(), p.getInt("iterations", 1), p.getBorder()); }},
+        {"applyDilation", [](const cv::Mat& img, StepParameters& p) {
+             return applyDilation(img, p.getElement(), p.getInt("iterations", 1), p.getBorder()); }},
+        {"applyOpening", [](const cv::Mat& img, StepParameters& p) {
+             return applyOpening(img, p.getElement(), p.getInt("iterations", 1), p.getBorder()); }},
+        {"applyClosing", [](const cv::Mat& img, StepParameters& p) {
+             return applyClosing(img, p.getElement(), p.getInt("iterations", 1), p.getBorder()); }},
+        {"applySkeletonization", [](const cv::Mat& img, StepParameters& p) {
+             return applySkeletonization(img, p.getElement()); }},
+
+        // Feature detection
+        {"detectHoughLines", [](const cv::Mat& img, StepParameters& p) {
+             return detectHoughLines(img, p.getDouble("rho", 1.0), p.getDouble("theta", CV_PI / 180.0),
+                                     p.getInt("threshold", 100)); }},
+
+        // Segmentation
+        {"applyGlobalThreshold", [](const cv::Mat& img, StepParameters& p) {
+             return applyGlobalThreshold(img, p.getInt("threshold", 127)); }},
+        {"applyAdaptiveThreshold", [](const cv::Mat& img, StepParameters&) { return applyAdaptiveThreshold(img); }},
+        {"applyOtsuThreshold", [](const cv::Mat& img, StepParameters&) { return applyOtsuThreshold(img); }},
+        {"magicWandSegmentation", [](const cv::Mat& img, StepParameters& p) {
+             return magicWandSegmentation(img, cv::Point(p.getInt("x", 0), p.getInt("y", 0)),
+                                          p.getInt("tolerance", 10)); }},
+        {"applyWatershedSegmentation", [](const cv::Mat& img, StepParameters&) { return applyWatershedSegmentation(img); }},
+    };
+    return registry;
+}
+
+// A step that is a pure 8-bit point operation: it builds its lookup table instead of an image.
+// `histogram` is the histogram of the image the step receives (only computed if needsHistogram).
+struct PointStep {
+    bool needsHistogram;
+    std::function<ImageProcessing::TableResult(StepParameters&, const ImageProcessing::Histogram& histogram)> table;
+};
+
+// Steps that can be folded into one lookup table when they follow each other on a grayscale image.
+// Each must map pixels exactly like its entry in stepRegistry() and read the same parameters.
+const QMap<QString, PointStep>& pointStepRegistry() {
+    using namespace ImageProcessing;
+    static const QMap<QString, PointStep> registry = {
+        {"binarise", {false, [](StepParameters& p, const Histogram&) -> TableResult {
+             return thresholdTable(p.getDouble("threshold", 127.0), p.getDouble("max", 255.0)); }}},
+        {"applyNegation", {false, [](StepParameters&, const Histogram&) -> TableResult { return negationTable(); }}},
+        {"applyRangeStretching", {false, [](StepParameters& p, const Histogram&) {
+             return rangeStretchingTable(p.getInt("p1", 0), p.getInt("p2", 255), p.getInt("q3", 0), p.getInt("q4", 255)); }}},
+        {"applyPosterization", {false, [](StepParameters& p, const Histogram&) {
+             return posterizationTable(p.getInt("levels", 4)); }}},
+        {"applyGammaCorrection", {false, [](StepParameters& p, const Histogram&) {
+             return gammaTable(p.getDouble("gamma", 1.0)); }}},
+        {"stretchHistogram", {true, [](StepParameters&, const Histogram& histogram) -> TableResult {
+             return histogramStretchTable(histogram); }}},
+        {"equalizeHistogram", {true, [](StepParameters&, const Histogram& histogram) -> TableResult {
+             return equalizationTable(histogram); }}},
+        {"applyGlobalThreshold", {false, [](StepParameters& p, const Histogram&) -> TableResult {
+             return thresholdTable(p.getInt("threshold", 127)); }}},
+    };
+    return registry;
+}
+
+// Normalized kernel of a smoothing step, or an empty Mat if the step isn't one. Smoothing kernels have
+// non-negative weights summing to 1, so intermediate results stay within 0-255 and two of them in a
+// row act like one filter with the convolution of their kernels. Only odd sizes, which are centred.
+cv::Mat smoothingKernel(const PipelineStep& step) {
+    StepParameters p(step.params);
+    cv::Mat kernel;
+    if (step.name == "applyBoxBlur") {
+        const int size = p.getInt("size", 3);
+        if (size >= 1 && size % 2 == 1) kernel = cv::Mat::ones(size, size, CV_32F) / static_cast<float>(size * size);
+    } else if (step.name == "applyGaussianBlur") {
+        const int size = p.getInt("size", 3);
+        const double sigmaX = p.getDouble("sigmaX", 0.0);
+        const double sigmaY = p.getDouble("sigmaY", 0.0);
+        if (size >= 1 && size % 2 == 1) {
+            // Same kernels as cv::GaussianBlur, which takes sigmaY from sigmaX when it is 0
+            const cv::Mat kernelX = cv::getGaussianKernel(size, sigmaX, CV_32F);
+            const cv::Mat kernelY = cv::getGaussianKernel(size, sigmaY > 0 ? sigmaY : sigmaX, CV_32F);
+            kernel = kernelY * kernelX.t();
+        }
+    } else if (step.name == "applyCustomFilter") {
+        cv::Mat custom = p.getKernel("kernel");
+        const bool normalize = p.getBool("normalize", true);
+        if (!custom.empty() && custom.rows % 2 == 1) {
+            double minWeight = 0.0;
+            cv::minMaxLoc(custom, &minWeight);
+            const double sum = cv::sum(custom)[0];
+            if (minWeight >= 0 && sum > 0 && (normalize || std::abs(sum - 1.0) < 1e-6)) {
+                kernel = custom / sum;
+            }
+        }
+    }
+    p.getBorder();
+    QString error;
+    return p.check(&error) ? kernel : cv::Mat(); // Malformed steps are left for run() to report
+}
+
+// Parses "name key=value key=value" into a step.
+bool parseStep(const QString& text, PipelineStep& step, QString* errorMessage) {
+    static const QRegularExpression whitespace("\\s+");
+    const QStringList tokens = text.split(whitespace, Qt::SkipEmptyParts);
+    step.name = tokens.value(0);
+    step.params.clear();
+    if (!stepRegistry().contains(step.name)) {
+        if (errorMessage) *errorMessage = QString("unknown step '%1'").arg(step.name);
+        return false;
+    }
+    for (int i = 1; i < tokens.size(); ++i) {
+        const int eq = tokens[i].indexOf('=');
+        if (eq <= 0) {
+            if (errorMessage) *errorMessage = QString("expected key=value, got '%1'").arg(tokens[i]);
+            return false;
+        }
+        step.params.insert(tokens[i].left(eq), tokens[i].mid(eq + 1));
+    }
+    return true;
+}
+
+} // namespace
+
+// ==========================================================================
+// Processing Pipeline - Parsing & Serialization
+// ==========================================================================
+
+bool ProcessingPipeline::parse(const QString& text, QString* errorMessage) {
+    QVector<PipelineStep> parsed;
+    const QStringList lines = text.split('\n');
+    for (int lineNo = 0; lineNo < lines.size(); ++lineNo) {
+        QString line = lines[lineNo];
+        const int comment = line.indexOf('#');
+        if (comment >= 0) line.truncate(comment);
+
+        for (const QString& part : line.split(';', Qt::SkipEmptyParts)) {
+            if (part.trimmed().isEmpty()) continue;
+            PipelineStep step;
+            QString stepError;
+            if (!parseStep(part.trimmed(), step, &stepError)) {
+                if (errorMessage) *errorMessage = QString("line %1: %2").arg(lineNo + 1).arg(stepError);
+                return false;
+            }
+            parsed.append(step);
+        }
+    }
+    stepList = parsed;
+    return true;
+}
+
+bool ProcessingPipeline::load(const QString& filePath, QString* errorMessage) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (errorMessage) *errorMessage = QString("cannot open %1: %2").arg(filePath, file.errorString());
+        return false;
+    }
+    return parse(QTextStream(&file).readAll(), errorMessage);
+}
+
+bool ProcessingPipeline::save(const QString& filePath, QString* errorMessage) const {
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
+        if (errorMessage) *errorMessage = QString("cannot write %1: %2").arg(filePath, file.errorString());
+        return false;
+    }
+    QTextStream(&file) << toString() << '\n';
+    return true;
+}
+
+QString ProcessingPipeline::toString() const {
+    QStringList lines;
+    for (const PipelineStep& step : stepList) {
+        QStringList tokens{step.name};
+        for (auto it = step.params.constBegin(); it != step.params.constEnd(); ++it) {
+            tokens << it.key() + "=" + it.value();
+        }
+        lines << tokens.join(' ');
+    }
+    return lines.join('\n');
+}
+
+QStringList ProcessingPipeline::availableSteps() {
+    return stepRegistry().keys();
+}
+
+QString ProcessingPipeline::borderName(int borderOption) {
+    switch (borderOption & ~cv::BORDER_ISOLATED) {
+    case cv::BORDER_REFLECT: return "reflect";
+    case cv::BORDER_REPLICATE: return "replicate";
+    default: return "isolated";
+    }
+}
+
+QString ProcessingPipeline::kernelToString(const cv::Mat& kernel) {
+    cv::Mat values;
+    kernel.convertTo(values, CV_32F);
+    QStringList parts;
+    for (int i = 0; i < values.rows; ++i) {
+        for (int j = 0; j < values.cols; ++j) parts << QString::number(values.at<float>(i, j), 'g', 9);
+    }
+    return parts.join(',');
+}
+
+// ==========================================================================
+// Processing Pipeline - Execution
+// ==========================================================================
+
+cv::Mat ProcessingPipeline::run(const cv::Mat& input, QString* errorMessage) const {
+    cv::Mat current = input;
+    for (int i = 0; i < stepList.size(); ++i) {
+        const PipelineStep& step = stepList[i];
+        auto fail = [&](const QString& reason) {
+            if (errorMessage) *errorMessage = QString("step %1 (%2): %3").arg(i + 1).arg(stepList[i].name, reason);
+            return cv::Mat();
+        };
+
+        // A run of point operations on a grayscale image costs one pass over it (none if it cancels out)
+        if (current.type() == CV_8UC1 && pointStepRegistry().contains(step.name)) {
+            ImageProcessing::PointTable table = ImageProcessing::identityTable();
+            ImageProcessing::Histogram inputHistogram{};
+            bool counted = false;
+            for (; i < stepList.size(); ++i) {
+                const auto pointStep = pointStepRegistry().constFind(stepList[i].name);
+                if (pointStep == pointStepRegistry().constEnd()) break;
+
+                ImageProcessing::Histogram histogram{};
+                if (pointStep->needsHistogram) {
+                    if (!counted) {
+                        inputHistogram = ImageProcessing::computeGrayHistogram(current);
+                        counted = true;
+                    }
+                    histogram = ImageProcessing::mapHistogram(inputHistogram, table);
+                }
+                StepParameters params(stepList[i].params);
+                const ImageProcessing::TableResult stepTable = pointStep->table(params, histogram);
+                QString paramError;
+                if (!params.check(&paramError)) return fail(paramError);
+                if (!stepTable) return fail(QString::fromStdString(stepTable.error().message));
+                table = ImageProcessing::composeTables(table, stepTable.value());
+            }
+            if (table != ImageProcessing::identityTable()) {
+                current = ImageProcessing::applyPointTable(current, table).valueOr(cv::Mat());
+            }
+            --i; // The loop's increment moves on to the first step after the run
+            continue;
+        }
+
+        const auto entry = stepRegistry().constFind(step.name);
+        if (entry == stepRegistry().constEnd()) return fail("unknown step");
+
+        StepParameters params(step.params);
+        try {
+            ImageProcessing::MatResult result = entry.value()(current, params);
+            QString paramError;
+            if (!params.check(&paramError)) return fail(paramError);
+            if (!result) return fail(QString::fromStdString(result.error().message));
+            current = std::move(result).value();
+        } catch (const cv::Exception& e) {
+            return fail(QString::fromStdString(e.what()));
+        } catch (const std::exception& e) {
+            return fail(QString::fromStdString(e.what()));
+        }
+    }
+    return current;
+}
+
+ProcessingPipeline ProcessingPipeline::optimized() const {
+    static const QSet<QString> idempotent = {"convertToGrayscale", "grayscale", "removeAlphaChannel", "convertToColor"};
+    constexpr int MaxFusedKernel = 11;
+
+    QVector<PipelineStep> steps;
+    cv::Mat lastKernel; // Kernel of steps.last() if it is a smoothing filter
+    for (const PipelineStep& step : stepList) {
+        if (!steps.isEmpty()) {
+            const PipelineStep& previous = steps.last();
+            if (step.name == "applyNegation" && previous.name == "applyNegation" && step.params.isEmpty() && previous.params.isEmpty()) {
+                steps.removeLast();
+                lastKernel = steps.isEmpty() ? cv::Mat() : smoothingKernel(steps.last());
+                continue;
+            }
+            if (idempotent.contains(step.name) && step.name == previous.name && step.params.isEmpty() && previous.params.isEmpty()) {
+                continue;
+            }
+        }
+
+        const cv::Mat kernel = smoothingKernel(step);
+        if (!kernel.empty() && !lastKernel.empty()
+            && step.params.value("border", "isolated").toLower() == steps.last().params.value("border", "isolated").toLower()
+            && kernel.rows + lastKernel.rows - 1 <= MaxFusedKernel) {
+            lastKernel = ImageProcessing::combineKernels(lastKernel, kernel);
+            PipelineStep& fused = steps.last();
+            const QString border = fused.params.value("border", "isolated");
+            fused.name = "applyCustomFilter";
+            fused.params = {{"kernel", ProcessingPipeline::kernelToString(lastKernel)}, {"normalize", "false"}, {"border", border}};
+            continue;
+        }
+        steps.append(step);
+        lastKernel = kernel;
+    }
+    return ProcessingPipeline(steps);
+}
@@ -0,0 +1,366 @@
+#include "rlecodec.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RLE_USE_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace RleCodec {
+
+namespace {
+
+constexpr char Magic[4] = {'A', 'P', 'R', 'L'};
+constexpr int HeaderSize = 16;
+constexpr qint64 ReadChunk = 64 * 1024;
+constexpr quint64 MaxImageBytes = quint64(1) << 36; // Rejects corrupt headers before allocating
+
+bool fail(QString* errorMessage, const QString& message) {
+    if (errorMessage) *errorMessage = message;
+    return false;
+}
+
+// Index of the lowest set bit; `mask` must not be zero.
+int lowestSetBit(quint64 mask) {
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return static_cast<int>(index);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    if (_BitScanForward(&index, static_cast<unsigned long>(mask))) return static_cast<int>(index);
+    _BitScanForward(&index, static_cast<unsigned long>(mask >> 32));
+    return static_cast<int>(index) + 32;
+#else
+    return __builtin_ctzll(mask);
+#endif
+}
+
+// First byte in [begin, end) that differs from the byte one pixel (`channels` bytes) before it, or `end`.
+// Pixels form a run exactly where every byte equals the byte one pixel back, so a byte-wise compare
+// against the data shifted by one pixel finds run ends for any channel count, 16 bytes at a time.
+size_t findRunEnd(const uchar* data, size_t begin, size_t end, int channels) {
+    size_t k = begin;
+#if defined(RLE_USE_SSE2)
+    for (; k + 16 <= end; k += 16) {
+        const __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + k));
+        const __m128i previous = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + k - channels));
+        const unsigned equal = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(current, previous)));
+        if (equal != 0xFFFF) return k + lowestSetBit(~equal & 0xFFFF);
+    }
+#elif Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    // Without SSE2: eight bytes per step in a 64-bit register; the lowest differing bit is in the first differing byte
+    for (; k + 8 <= end; k += 8) {
+        quint64 current, previous;
+        std::memcpy(&current, data + k, 8);
+        std::memcpy(&previous, data + k - channels, 8);
+        if (const quint64 differs = current ^ previous) return k + lowestSetBit(differs) / 8;
+    }
+#endif
+    while (k < end && data[k] == data[k - channels]) ++k;
+    return k;
+}
+
+void appendVarint(std::vector<uchar>& out, quint64 value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uchar>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uchar>(value));
+}
+
+// Appends the runs of `pixelCount` contiguous pixels to `out`.
+void encodeBlock(const uchar* data, size_t pixelCount, int channels, std::vector<uchar>& out) {
+    const size_t byteCount = pixelCount * channels;
+    size_t start = 0;
+    while (start < byteCount) {
+        const size_t runEnd = findRunEnd(data, start + channels, byteCount, channels) / channels * channels;
+        out.insert(out.end(), data + start, data + start + channels);
+        appendVarint(out, (runEnd - start) / channels - 1);
+        start = runEnd;
+    }
+}
+
+// Writes `count` copies of a `channels`-byte pixel, doubling the filled part with each copy.
+void fillPixels(uchar* target, const uchar* pixel, size_t count, int channels) {
+    if (channels == 1) {
+        std::memset(target, pixel[0], count);
+        return;
+    }
+    const size_t total = count * channels;
+    std::memcpy(target, pixel, channels);
+    for (size_t filled = channels; filled < total; filled *= 2) {
+        std::memcpy(target + filled, target, std::min(filled, total - filled));
+    }
+}
+
+// Decodes one block's runs, which must cover exactly `byteCount` bytes of `target`.
+bool decodeBlock(const uchar* payload, size_t payloadSize, int channels, uchar* target, size_t byteCount) {
+    size_t in = 0;
+    size_t out = 0;
+    while (in < payloadSize) {
+        if (payloadSize - in <= static_cast<size_t>(channels)) return false;
+        const uchar* pixel = payload + in;
+        in += channels;
+
+        quint64 run = 0;
+        for (int shift = 0;; shift += 7) {
+            if (in >= payloadSize || shift > 56) return false;
+            const uchar byte = payload[in++];
+            run |= static_cast<quint64>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) break;
+        }
+        if (run >= (byteCount - out) / channels) return false; // Run of run + 1 pixels past the block
+        fillPixels(target + out, pixel, run + 1, channels);
+        out += (run + 1) * channels;
+    }
+    return out == byteCount;
+}
+
+// Serves small reads from 64 KiB chunks of the device, and large ones straight from it.
+class BufferedReader {
+public:
+    explicit BufferedReader(QIODevice& device) : device(device) {}
+
+    // The next `size` bytes, copied into `scratch`; null at the end of the data.
+    const uchar* take(qint64 size, std::vector<uchar>& scratch) {
+        scratch.resize(static_cast<size_t>(size));
+        return read(scratch.data(), size) ? scratch.data() : nullptr;
+    }
+
+    bool read(void* out, qint64 size) {
+        char* target = static_cast<char*>(out);
+        while (size > 0) {
+            if (position == buffer.size()) {
+                if (size >= ReadChunk) return device.read(target, size) == size;
+                buffer = device.read(ReadChunk);
+                position = 0;
+                if (buffer.isEmpty()) return false;
+            }
+            const qint64 count = std::min<qint64>(size, buffer.size() - position);
+            std::memcpy(target, buffer.constData() + position, count);
+            target += count;
+            position += count;
+            size -= count;
+        }
+        return true;
+    }
+
+private:
+    QIODevice& device;
+    QByteArray buffer;
+    qint64 position = 0;
+};
+
+// Reads from a block of memory, e.g. a file mapping; take() hands out pointers into it without copying.
+class MemoryReader {
+public:
+    MemoryReader(const uchar* data, size_t size) : data(data), size(size) {}
+
+    const uchar* take(qint64 count, std::vector<uchar>&) {
+        if (count < 0 || static_cast<size_t>(count) > size - position) return nullptr;
+        const uchar* taken = data + position;
+        position += static_cast<size_t>(count);
+        return taken;
+    }
+
+    bool read(void* out, qint64 count) {
+        if (count < 0 || static_cast<size_t>(count) > size - position) return false;
+        std::memcpy(out, data + position, static_cast<size_t>(count));
+        position += static_cast<size_t>(count);
+        return true;
+    }
+
+private:
+    const uchar* data;
+    size_t size;
+    size_t position = 0;
+};
+
+bool validSize(quint64 width, quint64 height, int channels) {
+    return width > 0 && height > 0 && width <= static_cast<quint64>(std::numeric_limits<int>::max())
+           && height <= static_cast<quint64>(std::numeric_limits<int>::max()) && width * height * channels <= MaxImageBytes;
+}
+
+// Version 1: "GRE" or "COL", 32-bit width and height, then (value, 1-byte count) runs.
+template <typename Reader>
+cv::Mat readVersion1(Reader& reader, int channels, QString* errorMessage) {
+    uchar sizes[8];
+    if (!reader.read(sizes, 8)) {
+        fail(errorMessage, "truncated header");
+        return cv::Mat();
+    }
+    const qint32 width = qFromLittleEndian<qint32>(sizes);
+    const qint32 height = qFromLittleEndian<qint32>(sizes + 4);
+    if (width <= 0 || height <= 0 || !validSize(width, height, channels)) {
+        fail(errorMessage, "invalid image size");
+        return cv::Mat();
+    }
+
+    cv::Mat image(height, width, CV_8UC(channels));
+    const size_t byteCount = image.total() * channels;
+    size_t out = 0;
+    uchar run[4];
+    while (out < byteCount) {
+        if (!reader.read(run, channels + 1)) {
+            fail(errorMessage, "truncated pixel data");
+            return cv::Mat();
+        }
+        const size_t count = run[channels];
+        if (count * channels > byteCount - out) {
+            fail(errorMessage, "runs exceed the image size");
+            return cv::Mat();
+        }
+        if (count > 0) fillPixels(image.data + out, run, count, channels);
+        out += count * channels;
+    }
+    return image;
+}
+
+template <typename Reader>
+cv::Mat readVersion2(Reader& reader, QString* errorMessage) {
+    uchar header[HeaderSize - 4];
+    if (!reader.read(header, sizeof(header))) {
+        fail(errorMessage, "truncated header");
+        return cv::Mat();
+    }
+    if (header[0] > FormatVersion) {
+        fail(errorMessage, QString("format version %1 is newer than this program supports").arg(header[0]));
+        return cv::Mat();
+    }
+    const int channels = header[1];
+    const quint32 width = qFromLittleEndian<quint32>(header + 4);
+    const quint32 height = qFromLittleEndian<quint32>(header + 8);
+    if ((channels != 1 && channels != 3 && channels != 4) || !validSize(width, height, channels)) {
+        fail(errorMessage, "invalid image size or channel count");
+        return cv::Mat();
+    }
+
+    cv::Mat image(static_cast<int>(height), static_cast<int>(width), CV_8UC(channels));
+    std::vector<uchar> scratch;
+    for (int y = 0; y < image.rows; y += BlockRows) {
+        const int rows = std::min(BlockRows, image.rows - y);
+        uchar size[4];
+        if (!reader.read(size, 4)) {
+            fail(errorMessage, "truncated pixel data");
+            return cv::Mat();
+        }
+        const quint32 payloadSize = qFromLittleEndian<quint32>(size);
+        const uchar* payload = reader.take(payloadSize, scratch);
+        if (!payload || !decodeBlock(payload, payloadSize, channels, image.ptr(y),
+                                     static_cast<size_t>(rows) * image.cols * channels)) {
+            fail(errorMessage, QString("corrupt or truncated block at row %1").arg(y));
+            return cv::Mat();
+        }
+    }
+    return image;
+}
+
+template <typename Reader>
+cv::Mat readImage(Reader& reader, QString* errorMessage) {
+    char magic[3];
+    if (!reader.read(magic, 3)) {
+        fail(errorMessage, "not an RLE image");
+        return cv::Mat();
+    }
+    if (std::memcmp(magic, "GRE", 3) == 0) return readVersion1(reader, 1, errorMessage);
+    if (std::memcmp(magic, "COL", 3) == 0) return readVersion1(reader, 3, errorMessage);
+
+    char last;
+    if (std::memcmp(magic, Magic, 3) != 0 || !reader.read(&last, 1) || last != Magic[3]) {
+        fail(errorMessage, "not an RLE image");
+        return cv::Mat();
+    }
+    return readVersion2(reader, errorMessage);
+}
+
+} // namespace
+
+bool canEncode(const cv::Mat& image) {
+    return !image.empty() && image.depth() == CV_8U
+           && (image.channels() == 1 || image.channels() == 3 || image.channels() == 4);
+}
+
+bool write(const cv::Mat& image, QIODevice& device, qint64* encodedBytes, QString* errorMessage) {
+    if (!canEncode(image)) {
+        return fail(errorMessage, "only 8-bit images with 1, 3 or 4 channels can be stored as RLE");
+    }
+    const int channels = image.channels();
+    qint64 written = 0;
+    auto put = [&](const void* data, qint64 size) {
+        if (device.write(static_cast<const char*>(data), size) != size) return false;
+        written += size;
+        return true;
+    };
+
+    uchar header[HeaderSize] = {};
+    std::memcpy(header, Magic, sizeof(Magic));
+    header[4] = FormatVersion;
+    header[5] = static_cast<uchar>(channels);
+    qToLittleEndian<quint32>(static_cast<quint32>(image.cols), header + 8);
+    qToLittleEndian<quint32>(static_cast<quint32>(image.rows), header + 12);
+    if (!put(header, HeaderSize)) {
+        return fail(errorMessage, "cannot write: " + device.errorString());
+    }
+
+    // One block is encoded into memory at a time and written in one call
+    std::vector<uchar> payload;
+    for (int y = 0; y < image.rows; y += BlockRows) {
+        cv::Mat block = image.rowRange(y, std::min(image.rows, y + BlockRows));
+        if (!block.isContinuous()) block = block.clone();
+        payload.clear();
+        encodeBlock(block.data, block.total(), channels, payload);
+        if (payload.size() > std::numeric_limits<quint32>::max()) {
+            return fail(errorMessage, "image rows are too wide for the RLE format");
+        }
+        uchar size[4];
+        qToLittleEndian<quint32>(static_cast<quint32>(payload.size()), size);
+        if (!put(size, 4) || !put(payload.data(), static_cast<qint64>(payload.size()))) {
+            return fail(errorMessage, "cannot write: " + device.errorString());
+        }
+    }
+    if (encodedBytes) *encodedBytes = written;
+    return true;
+}
+
+bool write(const cv::Mat& image, const QString& filePath, qint64* encodedBytes, QString* errorMessage) {
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return fail(errorMessage, QString("cannot write %1: %2").arg(filePath, file.errorString()));
+    }
+    if (!write(image, file, encodedBytes, errorMessage)) return false;
+    if (!file.commit()) {
+        return fail(errorMessage, QString("cannot write %1: %2").arg(filePath, file.errorString()));
+    }
+    return true;
+}
+
+cv::Mat read(QIODevice& device, QString* errorMessage) {
+    BufferedReader reader(device);
+    return readImage(reader, errorMessage);
+}
+
+cv::Mat decode(const uchar* data, size_t size, QString* errorMessage) {
+    MemoryReader reader(data, size);
+    return readImage(reader, errorMessage);
+}
+
+cv::Mat read(const QString& filePath, QString* errorMessage) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        fail(errorMessage, QString("cannot open %1: %2").arg(filePath, file.errorString()));
+        return cv::Mat();
+    }
+    return read(file, errorMessage);
+}
+
+} // namespace RleCodec
@@ -0,0 +1,123 @@
+#include "stackingdialog.h"
+#include "imageviewer.h"
+#include <QComboBox>
+#include <QDialogButtonBox>
+#include <QDoubleSpinBox>
+#include <QFileDialog>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QVBoxLayout>
+
+StackingDialog::StackingDialog(const QVector<QWidget*>& openedImages, QWidget *parent) : QDialog(parent) {
+    setWindowTitle("Stack Images");
+    setMinimumSize(450, 450);
+    auto *layout = new QVBoxLayout(this);
+
+    layout->addWidget(new QLabel("Aligned frames to combine:"));
+    frameList = new QListWidget(this);
+    for (QWidget *widget : openedImages) {
+        auto *viewer = qobject_cast<ImageViewer*>(widget);
+        if (!viewer || viewer->getSnapshot().empty()) continue;
+        auto *item = new QListWidgetItem(viewer->windowTitle(), frameList);
+        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+        item->setCheckState(Qt::Checked);
+        viewers.append(viewer);
+    }
+    layout->addWidget(frameList);
+
+    auto *form = new QFormLayout();
+    methodCombo = new QComboBox(this);
+    methodCombo->addItem("Mean", static_cast<int>(ImageProcessing::StackMethod::Mean));
+    methodCombo->addItem("Median", static_cast<int>(ImageProcessing::StackMethod::Median));
+    methodCombo->addItem("Sigma-Clipped Mean", static_cast<int>(ImageProcessing::StackMethod::SigmaClippedMean));
+    form->addRow("Method:", methodCombo);
+
+    kappaSpin = new QDoubleSpinBox(this);
+    kappaSpin->setRange(0.5, 10.0);
+    kappaSpin->setSingleStep(0.5);
+    kappaSpin->setValue(ImageProcessing::StackOptions{}.kappa);
+    form->addRow("Reject beyond (sigma):", kappaSpin);
+
+    iterationsSpin = new QSpinBox(this);
+    iterationsSpin->setRange(1, 20);
+    iterationsSpin->setValue(ImageProcessing::StackOptions{}.iterations);
+    form->addRow("Iterations:", iterationsSpin);
+
+    auto *outputLayout = new QHBoxLayout();
+    outputPathEdit = new QLineEdit(this);
+    outputPathEdit->setPlaceholderText("Optional, e.g. stack.png or stack.tiff");
+    auto *browseButton = new QPushButton("Browse...", this);
+    outputLayout->addWidget(outputPathEdit);
+    outputLayout->addWidget(browseButton);
+    form->addRow("Save full bit depth to:", outputLayout);
+    layout->addLayout(form);
+
+    statusLabel = new QLabel(this);
+    statusLabel->setWordWrap(true);
+    layout->addWidget(statusLabel);
+
+    buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    layout->addWidget(buttonBox);
+
+    connect(frameList, &QListWidget::itemChanged, this, &StackingDialog::validate);
+    connect(methodCombo, &QComboBox::currentIndexChanged, this, &StackingDialog::validate);
+    connect(browseButton, &QPushButton::clicked, this, &StackingDialog::browseOutputPath);
+    connect(buttonBox, &QDialogButtonBox::accepted, this, &QDialog::accept);
+    connect(buttonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    validate();
+}
+
+QVector<ImageViewer*> StackingDialog::getSelectedViewers() const {
+    QVector<ImageViewer*> selected;
+    for (int row = 0; row < frameList->count(); ++row) {
+        if (frameList->item(row)->checkState() == Qt::Checked) selected.append(viewers[row]);
+    }
+    return selected;
+}
+
+ImageProcessing::StackOptions StackingDialog::getOptions() const {
+    ImageProcessing::StackOptions options;
+    options.method = static_cast<ImageProcessing::StackMethod>(methodCombo->currentData().toInt());
+    options.kappa = kappaSpin->value();
+    options.iterations = iterationsSpin->value();
+    return options;
+}
+
+QString StackingDialog::getOutputPath() const {
+    return outputPathEdit->text().trimmed();
+}
+
+void StackingDialog::validate() {
+    const bool sigmaClipping = getOptions().method == ImageProcessing::StackMethod::SigmaClippedMean;
+    kappaSpin->setEnabled(sigmaClipping);
+    iterationsSpin->setEnabled(sigmaClipping);
+
+    QString status;
+    const QVector<ImageViewer*> selected = getSelectedViewers();
+    if (selected.size() < 2) {
+        status = "Check at least two images.";
+    } else {
+        const cv::Mat first = selected.first()->getSnapshot().mat();
+        for (ImageViewer *viewer : selected) {
+            const ImageSnapshot frame = viewer->getSnapshot();
+            if (frame.size() != first.size() || frame.type() != first.type()) {
+                status = "\"" + viewer->windowTitle() + "\" does not have the size and type of \""
+                         + selected.first()->windowTitle() + "\".";
+                break;
+            }
+        }
+    }
+    statusLabel->setText(status.isEmpty() ? QString("Stacks %1 image(s).").arg(selected.size()) : status);
+    buttonBox->button(QDialogButtonBox::Ok)->setEnabled(status.isEmpty());
+}
+
+void StackingDialog::browseOutputPath() {
+    const QString filePath = QFileDialog::getSaveFileName(this, "Save Stacked Image", outputPathEdit->text(),
+                                                          "16-bit Images (*.png *.tiff *.tif);;All Files (*)");
+    if (!filePath.isEmpty()) outputPathEdit->setText(filePath);
+}
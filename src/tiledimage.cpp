@@ -0,0 +1,49 @@
+#include "tiledimage.h"
+#include <algorithm>
+
+TiledImage::TiledImage(const cv::Mat& image, int tileSize)
+    : source(image), size(std::max(1, tileSize)) {
+    cols = (image.cols + size - 1) / size;
+    rowCount = (image.rows + size - 1) / size;
+}
+
+cv::Rect TiledImage::tileRect(int index) const {
+    const int x = (index % cols) * size;
+    const int y = (index / cols) * size;
+    return cv::Rect(x, y, std::min(size, source.cols - x), std::min(size, source.rows - y));
+}
+
+cv::Mat TiledImage::paddedTile(int index, int halo, int borderType) const {
+    const cv::Rect rect = tileRect(index);
+    if (halo <= 0) return source(rect).clone();
+
+    // Take real neighbours where the image has them, extrapolate only past its edges
+    const cv::Rect inner = cv::Rect(rect.x - halo, rect.y - halo, rect.width + 2 * halo, rect.height + 2 * halo)
+                           & cv::Rect(0, 0, source.cols, source.rows);
+    const int top = halo - (rect.y - inner.y);
+    const int left = halo - (rect.x - inner.x);
+    const int bottom = halo - (inner.br().y - rect.br().y);
+    const int right = halo - (inner.br().x - rect.br().x);
+
+    cv::Mat padded;
+    cv::copyMakeBorder(source(inner), padded, top, bottom, left, right,
+                       (borderType & ~cv::BORDER_ISOLATED) | cv::BORDER_ISOLATED);
+    return padded;
+}
+
+std::vector<int> TiledImage::tilesIntersecting(const cv::Rect& region) const {
+    std::vector<int> indices;
+    const cv::Rect clipped = region & cv::Rect(0, 0, source.cols, source.rows);
+    if (clipped.empty()) return indices;
+
+    const int firstColumn = clipped.x / size;
+    const int lastColumn = (clipped.br().x - 1) / size;
+    const int firstRow = clipped.y / size;
+    const int lastRow = (clipped.br().y - 1) / size;
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int column = firstColumn; column <= lastColumn; ++column) {
+            indices.push_back(row * cols + column);
+        }
+    }
+    return indices;
+}
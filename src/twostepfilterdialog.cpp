@@ -12,7 +12,7 @@
 
 TwoStepFilterDialog::TwoStepFilterDialog(QWidget *parent) : PreviewDialogBase(parent) {
     setWindowTitle("Two-Step Filter Input");
-    setFixedSize(600, 500);
+    setFixedSize(600, 620);
 
     QVBoxLayout *mainLayout = new QVBoxLayout(this);
 
@@ -56,6 +56,30 @@ TwoStepFilterDialog::TwoStepFilterDialog(QWidget *parent) : PreviewDialogBase(pa
     rightKernelLayout->addWidget(loadButton2);
 
 
+    // Execution strategy, in TwoStepStrategy order
+    QHBoxLayout *strategyLayout = new QHBoxLayout();
+    strategyBox = new QComboBox(this);
+    for (auto strategy : {ImageProcessing::TwoStepStrategy::Combined, ImageProcessing::TwoStepStrategy::Sequential,
+                          ImageProcessing::TwoStepStrategy::Separable}) {
+        strategyBox->addItem(ImageProcessing::twoStepStrategyName(strategy));
+    }
+    connect(strategyBox, qOverload<int>(&QComboBox::currentIndexChanged), this, &PreviewDialogBase::previewRequested);
+    QPushButton *benchmarkButton = new QPushButton("Benchmark");
+    connect(benchmarkButton, &QPushButton::clicked, this, [this]() {
+        benchmarkLabel->setText("Benchmarking...");
+        emit benchmarkRequested();
+    });
+    strategyLayout->addWidget(new QLabel("Strategy:"));
+    strategyLayout->addWidget(strategyBox, 1);
+    strategyLayout->addWidget(benchmarkButton);
+    mainLayout->addLayout(strategyLayout);
+
+    benchmarkLabel = new QLabel();
+    mainLayout->addWidget(benchmarkLabel);
+
+    methodLabel = new QLabel("Method: shown with the preview");
+    mainLayout->addWidget(methodLabel);
+
     previewCheckBox = new QCheckBox("Preview");
     previewCheckBox->setChecked(false); // default off
     connect(previewCheckBox, &QCheckBox::checkStateChanged, this, &PreviewDialogBase::previewRequested);
@@ -77,6 +101,25 @@ TwoStepFilterDialog::TwoStepFilterDialog(QWidget *parent) : PreviewDialogBase(pa
 }
 
 
+void TwoStepFilterDialog::setConvolutionInfo(const ImageProcessing::ConvolutionInfo& info) {
+    methodLabel->setText(QString("Method: %1, %2 ms for the last preview")
+                             .arg(ImageProcessing::convolutionMethodName(info.method))
+                             .arg(info.milliseconds, 0, 'f', 1));
+}
+
+void TwoStepFilterDialog::setBenchmarkResults(const std::vector<ImageProcessing::StrategyTiming>& timings) {
+    QStringList lines;
+    for (const ImageProcessing::StrategyTiming& timing : timings) {
+        lines << QString("%1: %2 ms").arg(ImageProcessing::twoStepStrategyName(timing.strategy))
+                     .arg(timing.milliseconds, 0, 'f', 2);
+    }
+    benchmarkLabel->setText(lines.join("\n"));
+}
+
+ImageProcessing::TwoStepStrategy TwoStepFilterDialog::getStrategy() const {
+    return static_cast<ImageProcessing::TwoStepStrategy>(strategyBox->currentIndex());
+}
+
 cv::Mat TwoStepFilterDialog::getKernel1() { return extractKernel(kernelInputs1); }
 cv::Mat TwoStepFilterDialog::getKernel2() { return extractKernel(kernelInputs2); }
 cv::Mat TwoStepFilterDialog::getKernel3() { return extractKernel(kernel5x5Labels); }
@@ -151,17 +194,7 @@ cv::Mat TwoStepFilterDialog::extractKernel(const QVector<QVector<QDoubleSpinBox*
 void TwoStepFilterDialog::updateKernel5x5() {
     cv::Mat kernel1 = getKernel1();
     cv::Mat kernel2 = getKernel2();
-    cv::Mat combined5x5 = cv::Mat::zeros(5, 5, CV_32F);
-
-    for (int i = 0; i < 3; ++i) {
-        for (int j = 0; j < 3; ++j) {
-            for (int k = 0; k < 3; ++k) {
-                for (int l = 0; l < 3; ++l) {
-                    combined5x5.at<float>(i + k, j + l) += kernel1.at<float>(i, j) * kernel2.at<float>(k, l);
-                }
-            }
-        }
-    }
+    cv::Mat combined5x5 = ImageProcessing::combineKernels(kernel1, kernel2);
 
     for (int i = 0; i < 5; ++i) {
         for (int j = 0; j < 5; ++j) {
@@ -0,0 +1,238 @@
+#include "undohistory.h"
+#include <QDataStream>
+#include <QDir>
+#include <QTemporaryFile>
+#include <cstring>
+
+namespace {
+
+constexpr int TileSize = 128;
+
+// Fast compression level: history encoding runs on the GUI thread
+constexpr int CompressionLevel = 1;
+
+bool rectEquals(const cv::Mat& a, const cv::Mat& b, const cv::Rect& rect) {
+    const size_t offset = rect.x * a.elemSize();
+    const size_t rowBytes = rect.width * a.elemSize();
+    for (int y = rect.y; y < rect.br().y; ++y) {
+        if (std::memcmp(a.ptr(y) + offset, b.ptr(y) + offset, rowBytes) != 0) return false;
+    }
+    return true;
+}
+
+QByteArray compressRect(const cv::Mat& image, const cv::Rect& rect) {
+    const size_t offset = rect.x * image.elemSize();
+    const size_t rowBytes = rect.width * image.elemSize();
+    QByteArray raw(static_cast<qsizetype>(rowBytes * rect.height), Qt::Uninitialized);
+    for (int y = 0; y < rect.height; ++y) {
+        std::memcpy(raw.data() + y * rowBytes, image.ptr(rect.y + y) + offset, rowBytes);
+    }
+    return qCompress(raw, CompressionLevel);
+}
+
+// Returns false for a corrupt tile or one that doesn't fit in `image`
+bool decompressRect(const QByteArray& data, cv::Mat& image, const cv::Rect& rect) {
+    if ((rect & cv::Rect(0, 0, image.cols, image.rows)) != rect) return false;
+    const size_t offset = rect.x * image.elemSize();
+    const size_t rowBytes = rect.width * image.elemSize();
+    const QByteArray raw = qUncompress(data);
+    if (static_cast<size_t>(raw.size()) != rowBytes * rect.height) return false;
+    for (int y = 0; y < rect.height; ++y) {
+        std::memcpy(image.ptr(rect.y + y) + offset, raw.constData() + y * rowBytes, rowBytes);
+    }
+    return true;
+}
+
+std::vector<cv::Rect> tileGrid(const cv::Size& size) {
+    std::vector<cv::Rect> rects;
+    for (int y = 0; y < size.height; y += TileSize) {
+        for (int x = 0; x < size.width; x += TileSize) {
+            rects.emplace_back(x, y, std::min(TileSize, size.width - x), std::min(TileSize, size.height - y));
+        }
+    }
+    return rects;
+}
+
+} // namespace
+
+UndoHistory::UndoHistory(size_t budgetBytes)
+    : budgetBytes(budgetBytes) {}
+
+size_t UndoHistory::Entry::bytes() const {
+    if (isFull()) return image.total() * image.elemSize();
+    size_t total = 0;
+    for (const Tile& tile : tiles) total += static_cast<size_t>(tile.data.size());
+    return total;
+}
+
+size_t UndoHistory::memoryUsage() const {
+    size_t total = 0;
+    for (const Entry& entry : undoStates) total += entry.bytes();
+    for (const Entry& entry : redoStates) total += entry.bytes();
+    return total;
+}
+
+void UndoHistory::push(const cv::Mat& previous, const cv::Mat& current) {
+    if (previous.empty()) return;
+    redoStates.clear();
+    Entry entry;
+    entry.image = previous; // Shared, not cloned
+    undoStates.push_back(std::move(entry));
+    enforceBudget(current);
+}
+
+cv::Mat UndoHistory::undo(const cv::Mat& current) {
+    if (undoStates.empty()) return cv::Mat();
+    const cv::Mat previous = decode(undoStates.back(), current);
+    if (previous.empty()) return cv::Mat(); // The entry stays, so a failed undo loses nothing
+    undoStates.pop_back();
+
+    Entry redoEntry;
+    redoEntry.image = current;
+    redoStates.push_back(std::move(redoEntry));
+    enforceBudget(previous);
+    return previous;
+}
+
+cv::Mat UndoHistory::redo(const cv::Mat& current) {
+    if (redoStates.empty()) return cv::Mat();
+    const cv::Mat next = decode(redoStates.back(), current);
+    if (next.empty()) return cv::Mat();
+    redoStates.pop_back();
+
+    Entry undoEntry;
+    undoEntry.image = current;
+    undoStates.push_back(std::move(undoEntry));
+    enforceBudget(next);
+    return next;
+}
+
+void UndoHistory::clear() {
+    undoStates.clear();
+    redoStates.clear();
+}
+
+void UndoHistory::setBudget(size_t bytes, const cv::Mat& current) {
+    budgetBytes = bytes;
+    enforceBudget(current);
+}
+
+// Stores only the tiles of `image` that differ from `neighbour`. When the shapes differ or most
+// tiles changed, every tile is stored and decoding does not need the neighbour.
+UndoHistory::Entry UndoHistory::encode(const cv::Mat& image, const cv::Mat& neighbour) {
+    Entry entry;
+    entry.size = image.size();
+    entry.type = image.type();
+
+    const std::vector<cv::Rect> grid = tileGrid(image.size());
+    std::vector<cv::Rect> changed;
+    if (neighbour.size() == image.size() && neighbour.type() == image.type()) {
+        long long changedArea = 0;
+        for (const cv::Rect& rect : grid) {
+            if (!rectEquals(image, neighbour, rect)) {
+                changed.push_back(rect);
+                changedArea += rect.area();
+            }
+        }
+        entry.relative = changedArea * 4 < static_cast<long long>(image.total()) * 3;
+    }
+    if (!entry.relative) changed = grid;
+
+    entry.tiles.reserve(changed.size());
+    for (const cv::Rect& rect : changed) {
+        entry.tiles.push_back(Tile{rect, compressRect(image, rect)});
+    }
+    return entry;
+}
+
+// Returns an empty Mat if the state can't be rebuilt exactly: its spill file is unreadable, a tile is corrupt,
+// or a relative entry's neighbour no longer has the shape it was encoded against. Patching a different
+// image would silently hand back the neighbour instead of the state.
+cv::Mat UndoHistory::decode(const Entry& entry, const cv::Mat& neighbour) const {
+    if (entry.isFull()) return entry.image;
+    if (entry.relative && (neighbour.size() != entry.size || neighbour.type() != entry.type)) return cv::Mat();
+
+    // Spilled tiles are read back only for this decode; the entry keeps pointing at its file
+    std::vector<Tile> spilledTiles;
+    if (entry.spillFile) {
+        if (!entry.spillFile->open()) return cv::Mat();
+        QDataStream in(entry.spillFile.get());
+        quint32 count = 0;
+        in >> count;
+        for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+            qint32 x, y, width, height;
+            Tile tile;
+            in >> x >> y >> width >> height >> tile.data;
+            tile.rect = cv::Rect(x, y, width, height);
+            spilledTiles.push_back(std::move(tile));
+        }
+        entry.spillFile->close();
+        if (in.status() != QDataStream::Ok) return cv::Mat();
+    }
+    const std::vector<Tile>& tiles = entry.spillFile ? spilledTiles : entry.tiles;
+
+    cv::Mat image;
+    if (entry.relative) {
+        image = neighbour.clone(); // Shared buffers are never modified
+    } else {
+        image.create(entry.size, entry.type);
+        image.setTo(cv::Scalar::all(0));
+    }
+    for (const Tile& tile : tiles) {
+        if (!decompressRect(tile.data, image, tile.rect)) return cv::Mat();
+    }
+    return image;
+}
+
+// Encodes the full state farthest from the current image. Full states always form the part of a
+// stack nearest to the current image, so the neighbour needed for the delta is still a full image.
+bool UndoHistory::compactOldest(States& states, const cv::Mat& current) {
+    for (size_t i = 0; i < states.size(); ++i) {
+        if (!states[i].isFull()) continue;
+        const cv::Mat& neighbour = i + 1 < states.size() ? states[i + 1].image : current;
+        Entry encoded = encode(states[i].image, neighbour);
+        states[i] = std::move(encoded);
+        return true;
+    }
+    return false;
+}
+
+// Moves the tiles of the oldest in-memory encoded state to a temporary file in the spill directory.
+bool UndoHistory::spillOldest(States& states) {
+    for (Entry& entry : states) {
+        if (entry.isFull() || entry.spillFile || entry.tiles.empty()) continue;
+
+        auto file = std::make_shared<QTemporaryFile>(QDir(spillDirectory).filePath("apo-undo-XXXXXX.bin"));
+        if (!file->open()) return false;
+        QDataStream out(file.get());
+        out << static_cast<quint32>(entry.tiles.size());
+        for (const Tile& tile : entry.tiles) {
+            out << qint32(tile.rect.x) << qint32(tile.rect.y) << qint32(tile.rect.width) << qint32(tile.rect.height)
+                << tile.data;
+        }
+        file->close();
+        if (out.status() != QDataStream::Ok) return false;
+
+        entry.spillFile = std::move(file);
+        entry.tiles.clear();
+        entry.tiles.shrink_to_fit();
+        return true;
+    }
+    return false;
+}
+
+void UndoHistory::enforceBudget(const cv::Mat& current) {
+    while (memoryUsage() > budgetBytes) {
+        if (compactOldest(undoStates, current) || compactOldest(redoStates, current)) continue;
+        if (!spillDirectory.isEmpty() && (spillOldest(undoStates) || spillOldest(redoStates))) continue;
+
+        // Nothing left to shrink: drop the oldest state (the far end of a stack never has dependents)
+        if (!undoStates.empty()) {
+            undoStates.pop_front();
+        } else if (!redoStates.empty()) {
+            redoStates.pop_front();
+        } else {
+            break;
+        }
+    }
+}